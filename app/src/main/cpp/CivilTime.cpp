@@ -0,0 +1,283 @@
+// CivilTime.cpp - Implementation
+#include "CivilTime.h"
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+
+namespace descansa {
+
+    namespace civil {
+
+        namespace {
+
+            const int64_t kSecondsPerDay = 86400;
+
+            // Transitions are located by probing weekly (no zone has a span
+            // shorter than that) up to about a year in each direction
+            const int64_t kProbeStep = 7 * kSecondsPerDay;
+            const int kProbeCount = 53;
+
+            // [begin, end) with a single UTC offset
+            struct OffsetSpan {
+                int64_t begin;
+                int64_t end;
+                int32_t offset;
+            };
+
+            // Plain data so it can live in thread-local storage on every NDK level
+            const int kCachedSpans = 8;
+            struct ZoneCache {
+                OffsetSpan spans[kCachedSpans];
+                int count;
+                int next_victim;
+                int last_hit;
+                unsigned generation;
+            };
+
+            thread_local ZoneCache tl_zone_cache;
+            std::atomic<unsigned> g_zone_generation(1);
+
+            int64_t floor_div(int64_t value, int64_t divisor) {
+                int64_t quotient = value / divisor;
+                return (value % divisor < 0) ? quotient - 1 : quotient;
+            }
+
+            int64_t clamp_to_time_t(int64_t seconds) {
+                const int64_t lowest = static_cast<int64_t>(std::numeric_limits<std::time_t>::min());
+                const int64_t highest = static_cast<int64_t>(std::numeric_limits<std::time_t>::max());
+                return seconds < lowest ? lowest : (seconds > highest ? highest : seconds);
+            }
+
+            // The only libc call - reentrant and only made on a cache miss
+            int32_t libc_offset(int64_t epoch_seconds) {
+                std::time_t t = static_cast<std::time_t>(clamp_to_time_t(epoch_seconds));
+                struct tm local;
+                if (!localtime_r(&t, &local)) return 0;
+                return static_cast<int32_t>(local.tm_gmtoff);
+            }
+
+            // Smallest x in (same, changed] whose offset differs from offset
+            int64_t first_change_after(int64_t same, int64_t changed, int32_t offset) {
+                while (changed - same > 1) {
+                    int64_t middle = same + (changed - same) / 2;
+                    if (libc_offset(middle) == offset) {
+                        same = middle;
+                    } else {
+                        changed = middle;
+                    }
+                }
+                return changed;
+            }
+
+            // Largest x in [changed, same) whose offset differs from offset
+            int64_t last_change_before(int64_t changed, int64_t same, int32_t offset) {
+                while (same - changed > 1) {
+                    int64_t middle = changed + (same - changed) / 2;
+                    if (libc_offset(middle) == offset) {
+                        same = middle;
+                    } else {
+                        changed = middle;
+                    }
+                }
+                return changed;
+            }
+
+            OffsetSpan discover_span(int64_t epoch_seconds) {
+                OffsetSpan span;
+                span.offset = libc_offset(epoch_seconds);
+
+                int64_t same = epoch_seconds;
+                span.end = epoch_seconds + 1;
+                for (int i = 1; i <= kProbeCount; ++i) {
+                    int64_t probe = epoch_seconds + i * kProbeStep;
+                    if (libc_offset(probe) != span.offset) {
+                        span.end = first_change_after(same, probe, span.offset);
+                        break;
+                    }
+                    same = probe;
+                    span.end = probe + 1;
+                }
+
+                same = epoch_seconds;
+                span.begin = epoch_seconds;
+                for (int i = 1; i <= kProbeCount; ++i) {
+                    int64_t probe = epoch_seconds - i * kProbeStep;
+                    if (libc_offset(probe) != span.offset) {
+                        span.begin = last_change_before(probe, same, span.offset) + 1;
+                        break;
+                    }
+                    same = probe;
+                    span.begin = probe;
+                }
+
+                return span;
+            }
+
+            void append_two_digits(char*& out, int value) {
+                *out++ = static_cast<char>('0' + value / 10);
+                *out++ = static_cast<char>('0' + value % 10);
+            }
+
+        } // namespace
+
+        int64_t days_from_civil(int64_t year, int month, int day) {
+            year -= month <= 2 ? 1 : 0;
+            const int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const int64_t year_of_era = year - era * 400;
+            const int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+            const int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+            return era * 146097 + day_of_era - 719468;
+        }
+
+        CivilDate civil_from_days(int64_t day_number) {
+            day_number += 719468;
+            const int64_t era = (day_number >= 0 ? day_number : day_number - 146096) / 146097;
+            const int64_t day_of_era = day_number - era * 146097;
+            const int64_t year_of_era =
+                    (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+            const int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+            const int64_t shifted_month = (5 * day_of_year + 2) / 153;
+
+            CivilDate date;
+            date.day = static_cast<int>(day_of_year - (153 * shifted_month + 2) / 5 + 1);
+            date.month = static_cast<int>(shifted_month < 10 ? shifted_month + 3 : shifted_month - 9);
+            date.year = year_of_era + era * 400 + (date.month <= 2 ? 1 : 0);
+            return date;
+        }
+
+        int weekday_from_days(int64_t day_number) {
+            // 1970-01-01 was a Thursday
+            int64_t weekday = (day_number + 4) % 7;
+            return static_cast<int>(weekday < 0 ? weekday + 7 : weekday);
+        }
+
+        int32_t utc_offset_at(int64_t epoch_seconds) {
+            ZoneCache& cache = tl_zone_cache;
+
+            unsigned generation = g_zone_generation.load(std::memory_order_relaxed);
+            if (cache.generation != generation) {
+                cache.count = 0;
+                cache.next_victim = 0;
+                cache.last_hit = 0;
+                cache.generation = generation;
+            }
+
+            // Consecutive lookups almost always land in the same span
+            if (cache.last_hit < cache.count) {
+                const OffsetSpan& span = cache.spans[cache.last_hit];
+                if (epoch_seconds >= span.begin && epoch_seconds < span.end) return span.offset;
+            }
+            for (int i = 0; i < cache.count; ++i) {
+                const OffsetSpan& span = cache.spans[i];
+                if (epoch_seconds >= span.begin && epoch_seconds < span.end) {
+                    cache.last_hit = i;
+                    return span.offset;
+                }
+            }
+
+            OffsetSpan span = discover_span(epoch_seconds);
+            int slot;
+            if (cache.count < kCachedSpans) {
+                slot = cache.count++;
+            } else {
+                slot = cache.next_victim; // Round-robin once full
+                cache.next_victim = (slot + 1) % kCachedSpans;
+            }
+            cache.spans[slot] = span;
+            cache.last_hit = slot;
+            return span.offset;
+        }
+
+        LocalTime to_local(int64_t epoch_seconds) {
+            LocalTime local;
+            local.utc_offset = utc_offset_at(epoch_seconds);
+
+            int64_t local_seconds = epoch_seconds + local.utc_offset;
+            local.day_number = floor_div(local_seconds, kSecondsPerDay);
+            local.second_of_day = static_cast<int32_t>(local_seconds - local.day_number * kSecondsPerDay);
+            local.weekday = weekday_from_days(local.day_number);
+            return local;
+        }
+
+        int64_t local_day(int64_t epoch_seconds) {
+            return floor_div(epoch_seconds + utc_offset_at(epoch_seconds), kSecondsPerDay);
+        }
+
+        int64_t from_local(int64_t day_number, int32_t second_of_day) {
+            int64_t local_seconds = day_number * kSecondsPerDay + second_of_day;
+
+            // Offsets just before and after any transition near this wall time
+            int64_t guess = local_seconds - utc_offset_at(local_seconds);
+            int32_t offset_before = utc_offset_at(guess - kSecondsPerDay);
+            int32_t offset_after = utc_offset_at(guess + kSecondsPerDay);
+
+            int64_t earlier = local_seconds - offset_before;
+            int64_t later = local_seconds - offset_after;
+            bool earlier_valid = utc_offset_at(earlier) == offset_before;
+            bool later_valid = utc_offset_at(later) == offset_after;
+
+            // Repeated wall time (fall back): take the first occurrence
+            if (earlier_valid && later_valid) return earlier < later ? earlier : later;
+            if (earlier_valid) return earlier;
+            if (later_valid) return later;
+
+            // Wall time inside a spring-forward gap - land past it
+            return earlier;
+        }
+
+        int64_t start_of_local_day(int64_t epoch_seconds) {
+            return from_local(local_day(epoch_seconds), 0);
+        }
+
+        void to_local_batch(const int64_t* epoch_seconds, size_t count, LocalTime* out) {
+            for (size_t i = 0; i < count; ++i) {
+                out[i] = to_local(epoch_seconds[i]);
+            }
+        }
+
+        void invalidate_zone_cache() {
+            tzset();
+            g_zone_generation.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::string format_date(int64_t epoch_seconds) {
+            CivilDate date = civil_from_days(local_day(epoch_seconds));
+
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%04lld-%02d-%02d",
+                          static_cast<long long>(date.year), date.month, date.day);
+            return buffer;
+        }
+
+        std::string format_date_time(int64_t epoch_seconds) {
+            return format_date(epoch_seconds) + " " + format_clock(epoch_seconds);
+        }
+
+        std::string format_clock(int64_t epoch_seconds) {
+            LocalTime local = to_local(epoch_seconds);
+
+            char buffer[8];
+            char* out = buffer;
+            append_two_digits(out, local.hour());
+            *out++ = ':';
+            append_two_digits(out, local.minute());
+            *out++ = ':';
+            append_two_digits(out, local.second_of_day % 60);
+            return std::string(buffer, out);
+        }
+
+        std::string format_hour_minute(int64_t epoch_seconds) {
+            LocalTime local = to_local(epoch_seconds);
+
+            char buffer[5];
+            char* out = buffer;
+            append_two_digits(out, local.hour());
+            *out++ = ':';
+            append_two_digits(out, local.minute());
+            return std::string(buffer, out);
+        }
+
+    } // namespace civil
+
+} // namespace descansa
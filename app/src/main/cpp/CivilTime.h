@@ -0,0 +1,82 @@
+// CivilTime.h - Local calendar arithmetic without localtime/mktime
+#ifndef CIVIL_TIME_H
+#define CIVIL_TIME_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "TimeTypes.h"
+
+namespace descansa {
+
+    namespace civil {
+
+// Proleptic Gregorian date
+        struct CivilDate {
+            int64_t year;
+            int month;      // 1-12
+            int day;        // 1-31
+        };
+
+// A timestamp resolved in the device's time zone
+        struct LocalTime {
+            int64_t day_number;     // local days since 1970-01-01
+            int32_t second_of_day;  // 0-86399
+            int32_t utc_offset;     // seconds east of UTC in effect at that instant
+            int weekday;            // 0 = Sunday, matches tm_wday
+
+            int minute_of_day() const { return second_of_day / 60; }
+            int hour() const { return second_of_day / 3600; }
+            int minute() const { return (second_of_day / 60) % 60; }
+            double fractional_hour() const { return second_of_day / 3600.0; }
+        };
+
+// Pure date arithmetic (no time zone involved)
+        int64_t days_from_civil(int64_t year, int month, int day);
+        CivilDate civil_from_days(int64_t day_number);
+        int weekday_from_days(int64_t day_number);
+
+// UTC offset at an instant. Offsets are cached per thread as spans of
+// constant offset bounded by the zone's transitions, so after the first
+// lookup in a span every conversion is integer arithmetic with no libc lock.
+        int32_t utc_offset_at(int64_t epoch_seconds);
+
+        LocalTime to_local(int64_t epoch_seconds);
+        int64_t local_day(int64_t epoch_seconds);
+
+// Local wall-clock time back to an instant, matching mktime with
+// tm_isdst = -1: a time skipped by a DST jump resolves forward past the
+// gap, a repeated time resolves to its first occurrence.
+        int64_t from_local(int64_t day_number, int32_t second_of_day);
+        int64_t start_of_local_day(int64_t epoch_seconds);
+
+// Batch conversion for analytics over whole columns of timestamps
+        void to_local_batch(const int64_t* epoch_seconds, size_t count, LocalTime* out);
+
+// Drop every thread's cached spans and re-read the zone; call when the
+// device time zone or its rules change (Android: ACTION_TIMEZONE_CHANGED)
+        void invalidate_zone_cache();
+
+// Formatting without put_time/localtime
+        std::string format_date(int64_t epoch_seconds);         // YYYY-MM-DD
+        std::string format_date_time(int64_t epoch_seconds);    // YYYY-MM-DD HH:MM:SS
+        std::string format_clock(int64_t epoch_seconds);        // HH:MM:SS
+        std::string format_hour_minute(int64_t epoch_seconds);  // HH:MM
+
+// TimePoint convenience
+        inline int64_t to_seconds(const std::chrono::system_clock::time_point& tp) {
+            return static_cast<int64_t>(std::chrono::system_clock::to_time_t(tp));
+        }
+        inline int64_t to_seconds(const TimePoint& tp) { return to_epoch_seconds(tp); }
+        inline TimePoint from_seconds(int64_t epoch_seconds) { return from_epoch_seconds(epoch_seconds); }
+        inline LocalTime to_local(const std::chrono::system_clock::time_point& tp) {
+            return to_local(to_seconds(tp));
+        }
+        inline LocalTime to_local(const TimePoint& tp) { return to_local(to_epoch_seconds(tp)); }
+
+    } // namespace civil
+
+} // namespace descansa
+
+#endif // CIVIL_TIME_H
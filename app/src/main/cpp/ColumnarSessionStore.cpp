@@ -0,0 +1,170 @@
+// ColumnarSessionStore.cpp - Implementation
+#include "ColumnarSessionStore.h"
+#include "DurableFile.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace descansa {
+
+    namespace {
+
+        // 32-byte file header; the columns follow back to back
+        struct ColumnFileHeader {
+            char magic[4];
+            uint32_t version;
+            uint64_t row_count;
+            uint32_t column_count;
+            uint32_t reserved;
+            uint64_t reserved2;
+        };
+
+        static_assert(sizeof(ColumnFileHeader) == 32, "column data must stay 8-byte aligned");
+
+        const char kColumnMagic[4] = {'D', 'S', 'C', 'S'};
+        const uint32_t kColumnVersion = 1;
+        const size_t kColumnCount = static_cast<size_t>(SessionColumn::COUNT);
+
+    } // namespace
+
+    ColumnarSessionStore::ColumnarSessionStore()
+            : mapping(nullptr), mapping_size(0), row_total(0) {
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            columns[i] = nullptr;
+        }
+    }
+
+    ColumnarSessionStore::~ColumnarSessionStore() {
+        close();
+    }
+
+    bool ColumnarSessionStore::open(const std::string& path) {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ColumnFileHeader))) {
+            ::close(fd);
+            return false;
+        }
+
+        size_t size = static_cast<size_t>(info.st_size);
+        void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping keeps the file alive
+        if (data == MAP_FAILED) return false;
+
+        ColumnFileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+
+        bool valid = std::memcmp(header.magic, kColumnMagic, sizeof(header.magic)) == 0 &&
+                     header.version == kColumnVersion &&
+                     header.column_count == kColumnCount &&
+                     header.row_count <= (size - sizeof(header)) / (kColumnCount * sizeof(int64_t)) &&
+                     size == sizeof(header) + header.row_count * kColumnCount * sizeof(int64_t);
+        if (!valid) {
+            munmap(data, size);
+            return false;
+        }
+
+        mapping = data;
+        mapping_size = size;
+        row_total = static_cast<size_t>(header.row_count);
+
+        const int64_t* base = reinterpret_cast<const int64_t*>(
+                static_cast<const char*>(data) + sizeof(header));
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            columns[i] = base + i * row_total;
+        }
+        return true;
+    }
+
+    void ColumnarSessionStore::close() {
+        if (mapping) {
+            munmap(mapping, mapping_size);
+        }
+        mapping = nullptr;
+        mapping_size = 0;
+        row_total = 0;
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            columns[i] = nullptr;
+        }
+    }
+
+    DurationTotals ColumnarSessionStore::duration_totals_since(int64_t wake_cutoff, size_t row_limit) const {
+        DurationTotals totals;
+        size_t rows = row_limit < row_total ? row_limit : row_total;
+
+        const int64_t* wake = column(SessionColumn::WAKE_UP);
+        const int64_t* duration = column(SessionColumn::DURATION);
+        for (size_t i = 0; i < rows; ++i) {
+            if (wake[i] >= wake_cutoff) {
+                totals.total_seconds += duration[i];
+                totals.count++;
+            }
+        }
+        return totals;
+    }
+
+    size_t ColumnarSessionStore::first_row_waking_since(int64_t wake_cutoff, size_t row_limit) const {
+        size_t rows = row_limit < row_total ? row_limit : row_total;
+        const int64_t* wake = column(SessionColumn::WAKE_UP);
+        return static_cast<size_t>(std::lower_bound(wake, wake + rows, wake_cutoff) - wake);
+    }
+
+    void ColumnarSessionWriter::reserve(size_t rows) {
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            columns[i].reserve(rows);
+        }
+    }
+
+    void ColumnarSessionWriter::add_row(int64_t sleep_start, int64_t wake_up, int64_t duration,
+                                        int64_t target_sleep, int64_t target_wake_minute, int64_t recorded) {
+        columns[static_cast<size_t>(SessionColumn::SLEEP_START)].push_back(sleep_start);
+        columns[static_cast<size_t>(SessionColumn::WAKE_UP)].push_back(wake_up);
+        columns[static_cast<size_t>(SessionColumn::DURATION)].push_back(duration);
+        columns[static_cast<size_t>(SessionColumn::TARGET_SLEEP)].push_back(target_sleep);
+        columns[static_cast<size_t>(SessionColumn::TARGET_WAKE_MINUTE)].push_back(target_wake_minute);
+        columns[static_cast<size_t>(SessionColumn::RECORDED)].push_back(recorded);
+    }
+
+    void ColumnarSessionWriter::append_rows(const ColumnarSessionStore& store, size_t row_limit) {
+        size_t rows = row_limit < store.size() ? row_limit : store.size();
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            const int64_t* source = store.column(static_cast<SessionColumn>(i));
+            columns[i].insert(columns[i].end(), source, source + rows);
+        }
+    }
+
+    void ColumnarSessionWriter::serialize(std::string& image) const {
+        ColumnFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kColumnMagic, sizeof(header.magic));
+        header.version = kColumnVersion;
+        header.row_count = size();
+        header.column_count = static_cast<uint32_t>(kColumnCount);
+
+        image.clear();
+        image.reserve(sizeof(header) + size() * kColumnCount * sizeof(int64_t));
+        image.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            if (!columns[i].empty()) {
+                image.append(reinterpret_cast<const char*>(columns[i].data()),
+                             columns[i].size() * sizeof(int64_t));
+            }
+        }
+    }
+
+    bool ColumnarSessionWriter::write(const std::string& path) const {
+        std::string image;
+        serialize(image);
+
+        // Readers holding the old mapping keep the previous inode alive
+        return write_file_durably(path, image);
+    }
+
+} // namespace descansa
@@ -0,0 +1,88 @@
+// ColumnarSessionStore.h - Memory-mapped columnar image of completed sleep sessions
+#ifndef COLUMNAR_SESSION_STORE_H
+#define COLUMNAR_SESSION_STORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace descansa {
+
+// Column order inside the file; every column is row_count packed int64 values
+    enum class SessionColumn : uint32_t {
+        SLEEP_START = 0,            // seconds since epoch
+        WAKE_UP,                    // seconds since epoch
+        DURATION,                   // seconds
+        TARGET_SLEEP,               // seconds
+        TARGET_WAKE_MINUTE,         // minute of day (hour * 60 + minute)
+        RECORDED,                   // seconds since epoch
+        COUNT
+    };
+
+// Aggregate read straight from the columns
+    struct DurationTotals {
+        int64_t total_seconds;
+        size_t count;
+
+        DurationTotals() : total_seconds(0), count(0) {}
+    };
+
+// Read-only view over a mapped column file. Opening is an mmap plus a header
+// check; nothing is parsed or materialized until a column is read.
+    class ColumnarSessionStore {
+    private:
+        void* mapping;
+        size_t mapping_size;
+        size_t row_total;
+        const int64_t* columns[static_cast<size_t>(SessionColumn::COUNT)];
+
+        ColumnarSessionStore(const ColumnarSessionStore&) = delete;
+        ColumnarSessionStore& operator=(const ColumnarSessionStore&) = delete;
+
+    public:
+        ColumnarSessionStore();
+        ~ColumnarSessionStore();
+
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const { return mapping != nullptr; }
+
+        size_t size() const { return row_total; }
+        const int64_t* column(SessionColumn which) const {
+            return columns[static_cast<size_t>(which)];
+        }
+        int64_t value(SessionColumn which, size_t row) const { return column(which)[row]; }
+
+        // Column queries over the first row_limit rows
+        DurationTotals duration_totals_since(int64_t wake_cutoff, size_t row_limit) const;
+
+        // First row waking at or after the cutoff. Rows are written in the
+        // order sessions completed, so the wake column is ascending and this
+        // is a binary search.
+        size_t first_row_waking_since(int64_t wake_cutoff, size_t row_limit) const;
+    };
+
+// Builds a column file in memory and writes it out in one go
+    class ColumnarSessionWriter {
+    private:
+        std::vector<int64_t> columns[static_cast<size_t>(SessionColumn::COUNT)];
+
+    public:
+        void reserve(size_t rows);
+        void add_row(int64_t sleep_start, int64_t wake_up, int64_t duration,
+                     int64_t target_sleep, int64_t target_wake_minute, int64_t recorded);
+        void append_rows(const ColumnarSessionStore& store, size_t row_limit);
+
+        size_t size() const { return columns[0].size(); }
+
+        // Complete file image, for staging into a CommitBatch
+        void serialize(std::string& image) const;
+
+        // Durable replace of path (temp file, fsync, rename)
+        bool write(const std::string& path) const;
+    };
+
+} // namespace descansa
+
+#endif // COLUMNAR_SESSION_STORE_H
@@ -0,0 +1,53 @@
+// ConstSpan.h - Read-only pointer + length view over contiguous elements
+#ifndef CONST_SPAN_H
+#define CONST_SPAN_H
+
+#include <cstddef>
+#include <vector>
+
+namespace descansa {
+
+// Non-owning view, in the spirit of std::span<const T> (C++20). A span
+// borrows its elements: it is valid only while the container it came from
+// is alive and unmodified. Getters that return one say which calls end its
+// lifetime; copy with to_vector() to keep the data past that.
+    template <typename T>
+    class ConstSpan {
+    private:
+        const T* first;
+        size_t length;
+
+    public:
+        typedef const T* const_iterator;
+
+        ConstSpan() : first(nullptr), length(0) {}
+        ConstSpan(const T* data, size_t count) : first(data), length(count) {}
+        // Implicit, so a vector (any allocator) can be passed wherever a span is expected
+        template <typename Allocator>
+        ConstSpan(const std::vector<T, Allocator>& values) : first(values.data()), length(values.size()) {}
+
+        const T* begin() const { return first; }
+        const T* end() const { return first + length; }
+        const T* data() const { return first; }
+        size_t size() const { return length; }
+        bool empty() const { return length == 0; }
+
+        const T& operator[](size_t index) const { return first[index]; }
+        const T& front() const { return first[0]; }
+        const T& back() const { return first[length - 1]; }
+
+        // Elements [offset, offset + count), clamped to the span
+        ConstSpan subspan(size_t offset, size_t count) const {
+            if (offset > length) offset = length;
+            if (count > length - offset) count = length - offset;
+            return ConstSpan(first + offset, count);
+        }
+
+        ConstSpan last(size_t count) const { return subspan(count < length ? length - count : 0, count); }
+
+        std::vector<T> to_vector() const { return std::vector<T>(begin(), end()); }
+    };
+
+} // namespace descansa
+
+#endif // CONST_SPAN_H
@@ -0,0 +1,255 @@
+// CoreSnapshot.cpp - Implementation
+#include "CoreSnapshot.h"
+#include "CivilTime.h"
+#include "CsvExportWriter.h"
+#include "TraceBuffer.h"
+
+namespace descansa {
+
+    namespace {
+        const std::shared_ptr<const std::vector<SleepSession>> kNoSessions =
+                std::make_shared<const std::vector<SleepSession>>();
+
+        int64_t seconds_between(TimePoint from, TimePoint to) {
+            return to > from ? (to - from).count() : 0;
+        }
+    }
+
+    CoreSnapshot::CoreSnapshot()
+            : version(0), session_active(false),
+              archive(std::make_shared<const ColumnarSessionStore>()), archived_count(0),
+              recent_sessions(kNoSessions) {}
+
+    SleepSession CoreSnapshot::get_session(size_t index) const {
+        if (index >= archived_count) {
+            return (*recent_sessions)[index - archived_count];
+        }
+
+        SleepSession session;
+        session.sleep_start = civil::from_seconds(archive->value(SessionColumn::SLEEP_START, index));
+        session.wake_up = civil::from_seconds(archive->value(SessionColumn::WAKE_UP, index));
+        session.sleep_duration = Duration(archive->value(SessionColumn::DURATION, index));
+        session.is_complete = true;
+        session.target_sleep_hours_at_session = Duration(archive->value(SessionColumn::TARGET_SLEEP, index));
+
+        int64_t wake_minute_of_day = archive->value(SessionColumn::TARGET_WAKE_MINUTE, index);
+        session.target_wake_hour_at_session = std::chrono::hours(wake_minute_of_day / 60);
+        session.target_wake_minute_at_session = std::chrono::minutes(wake_minute_of_day % 60);
+        session.session_recorded = civil::from_seconds(archive->value(SessionColumn::RECORDED, index));
+        return session;
+    }
+
+    Duration CoreSnapshot::get_last_sleep_duration() const {
+        if (!recent_sessions->empty()) {
+            return recent_sessions->back().sleep_duration;
+        }
+        if (archived_count > 0) {
+            return Duration(archive->value(SessionColumn::DURATION, archived_count - 1));
+        }
+        return Duration(0);
+    }
+
+    Duration CoreSnapshot::get_remaining_work_time(TimePoint now) const {
+        TimePoint next_bedtime = get_next_recommended_bedtime(now);
+
+        if (now >= next_bedtime) {
+            return Duration(0); // Past bedtime
+        }
+
+        return next_bedtime - now;
+    }
+
+    Duration CoreSnapshot::get_average_sleep_duration(TimePoint now, int days) const {
+        if (get_session_count() == 0) return Duration(0);
+
+        // Up to 90 days is answered from the rolling day buckets
+        if (days >= 1 && days <= RollingSleepAggregates::kMaxWindowDays) {
+            return Duration(get_sleep_window_stats(now, days).average_seconds());
+        }
+
+        // Same local-day window as the buckets, just longer
+        int64_t today = RollingSleepAggregates::day_index(civil::to_seconds(now));
+        TimePoint cutoff = civil::from_seconds(RollingSleepAggregates::window_start(today, days));
+
+        // Archived sessions are summed straight from the mapped columns
+        DurationTotals archived = archive->duration_totals_since(civil::to_seconds(cutoff), archived_count);
+        Duration total(archived.total_seconds);
+        size_t count = archived.count;
+
+        for (const auto& session : *recent_sessions) {
+            if (session.wake_up >= cutoff) {
+                total += session.sleep_duration;
+                count++;
+            }
+        }
+
+        return count > 0 ? Duration(total.count() / static_cast<int64_t>(count)) : Duration(0);
+    }
+
+    SleepWindowStats CoreSnapshot::get_sleep_window_stats(TimePoint now, int days) const {
+        SleepWindowStats stats;
+        int64_t today = RollingSleepAggregates::day_index(civil::to_seconds(now));
+
+        if (today <= aggregates.today()) {
+            aggregates.window(days, stats);
+            return stats;
+        }
+
+        // The day rolled over since publication - roll a private copy forward
+        RollingSleepAggregates rolled(aggregates);
+        rolled.advance_to(today);
+        rolled.window(days, stats);
+        return stats;
+    }
+
+    Duration CoreSnapshot::get_current_session_duration(TimePoint now) const {
+        if (!session_active) {
+            return Duration(0);
+        }
+        return now - current_session_start;
+    }
+
+    TimePoint CoreSnapshot::get_today_target_wake_time(TimePoint now) const {
+        return utils::start_of_day(now) + config.target_wake_hour + config.target_wake_minute;
+    }
+
+    TimePoint CoreSnapshot::get_next_recommended_bedtime(TimePoint now) const {
+        TimePoint tomorrow_wake = get_today_target_wake_time(now) + std::chrono::hours(24);
+        return tomorrow_wake - config.target_sleep_hours;
+    }
+
+    TimePoint CoreSnapshot::get_next_wake_time(TimePoint now) const {
+        TimePoint today_wake = get_today_target_wake_time(now);
+
+        // Today's wake if it hasn't passed yet, otherwise tomorrow's
+        return now < today_wake ? today_wake : today_wake + std::chrono::hours(24);
+    }
+
+    bool CoreSnapshot::is_in_sleep_period(TimePoint now) const {
+        TimePoint today_wake = get_today_target_wake_time(now);
+        TimePoint tonight_bedtime = get_next_recommended_bedtime(now);
+
+        // If current time is between bedtime and wake time
+        return (now >= tonight_bedtime) || (now < today_wake);
+    }
+
+    bool CoreSnapshot::is_before_target_wake_time(TimePoint now) const {
+        return now < get_today_target_wake_time(now);
+    }
+
+    Duration CoreSnapshot::get_time_until_target_wake(TimePoint now) const {
+        TimePoint today_wake = get_today_target_wake_time(now);
+
+        if (now >= today_wake) {
+            return Duration(0); // Return zero if wake time passed
+        }
+
+        return today_wake - now;
+    }
+
+    Duration CoreSnapshot::get_time_until_next_wake(TimePoint now) const {
+        return get_next_wake_time(now) - now;
+    }
+
+    DashboardSnapshot CoreSnapshot::get_dashboard(TimePoint now, int average_days) const {
+        DESCANSA_TRACE_SCOPE("CoreSnapshot::get_dashboard");
+
+        TimePoint today_wake = get_today_target_wake_time(now);
+        TimePoint next_wake = now < today_wake ? today_wake : today_wake + std::chrono::hours(24);
+
+        DashboardSnapshot dashboard;
+        dashboard.taken_at = civil::to_seconds(now);
+        dashboard.session_running = session_active;
+        dashboard.before_target_wake = now < today_wake;
+        dashboard.in_sleep_period = is_in_sleep_period(now);
+        dashboard.next_wake_minute_of_day = civil::to_local(next_wake).minute_of_day();
+        dashboard.session_count = static_cast<int64_t>(get_session_count());
+
+        dashboard.current_session_seconds = session_active ? seconds_between(current_session_start, now) : 0;
+        dashboard.remaining_work_seconds = get_remaining_work_time(now).count();
+        dashboard.time_until_wake_seconds = seconds_between(now, today_wake);
+        dashboard.time_until_next_wake_seconds = seconds_between(now, next_wake);
+        dashboard.last_sleep_seconds = get_last_sleep_duration().count();
+        dashboard.average_sleep_seconds = get_average_sleep_duration(now, average_days).count();
+
+        return dashboard;
+    }
+
+    bool CoreSnapshot::export_analysis_csv(const std::string& export_path) const {
+        DESCANSA_TRACE_SCOPE("CoreSnapshot::export_analysis_csv");
+
+        CsvExportWriter file;
+        if (!file.open(export_path)) return false;
+
+        // Pure CSV header - no decorative elements, all data columns
+        file.append("session_id,sleep_start_timestamp,wake_up_timestamp,"
+                    "sleep_duration_seconds,target_sleep_seconds_at_session,"
+                    "target_wake_hour_at_session,target_wake_minute_at_session,"
+                    "session_recorded_timestamp,export_timestamp,"
+                    "sleep_start_iso,wake_up_iso,session_recorded_iso,export_iso\n");
+
+        // Export timestamp is the same on every row - format its tail once
+        int64_t export_timestamp = civil::to_seconds(system_now());
+        std::string export_tail = "," + std::to_string(static_cast<long long>(export_timestamp)) + ",";
+        std::string export_iso = ",\"" + utils::format_time(civil::from_seconds(export_timestamp)) + "\"\n";
+
+        auto write_row = [&](size_t id, int64_t start, int64_t wake, int64_t duration, int64_t target_sleep,
+                             int64_t wake_hour, int64_t wake_minute, int64_t recorded) {
+            file.append_uint(id);
+            file.append_char(',');
+            file.append_int(start);
+            file.append_char(',');
+            file.append_int(wake);
+            file.append_char(',');
+            file.append_int(duration);
+            file.append_char(',');
+            file.append_int(target_sleep);
+            file.append_char(',');
+            file.append_int(wake_hour);
+            file.append_char(',');
+            file.append_int(wake_minute);
+            file.append_char(',');
+            file.append_int(recorded);
+            file.append(export_tail.data(), export_tail.size());
+
+            // ISO format strings for human reference in analysis tools
+            file.append_char('"');
+            file.append_local_time(start);
+            file.append("\",\"", 3);
+            file.append_local_time(wake);
+            file.append("\",\"", 3);
+            file.append_local_time(recorded);
+            file.append_char('"');
+            file.append(export_iso.data(), export_iso.size());
+        };
+
+        // Archived sessions stream straight from the mapped columns
+        const int64_t* starts = archive->column(SessionColumn::SLEEP_START);
+        const int64_t* wakes = archive->column(SessionColumn::WAKE_UP);
+        const int64_t* durations = archive->column(SessionColumn::DURATION);
+        const int64_t* target_sleeps = archive->column(SessionColumn::TARGET_SLEEP);
+        const int64_t* target_wakes = archive->column(SessionColumn::TARGET_WAKE_MINUTE);
+        const int64_t* recorded = archive->column(SessionColumn::RECORDED);
+        for (size_t i = 0; i < archived_count; ++i) {
+            write_row(i, starts[i], wakes[i], durations[i], target_sleeps[i],
+                      target_wakes[i] / 60, target_wakes[i] % 60, recorded[i]);
+        }
+
+        for (size_t i = 0; i < recent_sessions->size(); ++i) {
+            const SleepSession& session = (*recent_sessions)[i];
+            if (!session.is_complete) continue;
+
+            write_row(archived_count + i,
+                      civil::to_seconds(session.sleep_start),
+                      civil::to_seconds(session.wake_up),
+                      session.sleep_duration.count(),
+                      session.target_sleep_hours_at_session.count(),
+                      session.target_wake_hour_at_session.count(),
+                      session.target_wake_minute_at_session.count(),
+                      civil::to_seconds(session.session_recorded));
+        }
+
+        return file.close();
+    }
+
+} // namespace descansa
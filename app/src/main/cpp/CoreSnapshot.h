@@ -0,0 +1,63 @@
+// CoreSnapshot.h - Immutable, versioned view of the core's state
+#ifndef CORE_SNAPSHOT_H
+#define CORE_SNAPSHOT_H
+
+#include "DescansaCore.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace descansa {
+
+// One published version of DescansaCore's state. The core builds a new one
+// after every mutation and swaps it in atomically; a reader that holds the
+// shared_ptr sees a consistent state for as long as it likes, on any thread,
+// without taking the core's lock. Nothing in here is ever modified after
+// publication - the archive mapping and session list are shared, not copied,
+// between versions that did not change them.
+    class CoreSnapshot {
+    public:
+        uint64_t version;
+        ScheduleConfig config;
+        bool session_active;
+        TimePoint current_session_start;
+
+        // Sessions [0, archived_count) in the mapped column file, the rest in recent_sessions
+        std::shared_ptr<const ColumnarSessionStore> archive;
+        size_t archived_count;
+        std::shared_ptr<const std::vector<SleepSession>> recent_sessions;
+
+        // Windows as of the publishing mutation; rolled forward on a copy when read later
+        RollingSleepAggregates aggregates;
+
+        CoreSnapshot();
+
+        // Sessions
+        bool is_session_running() const { return session_active; }
+        size_t get_session_count() const { return archived_count + recent_sessions->size(); }
+        SleepSession get_session(size_t index) const;
+        const ScheduleConfig& get_config() const { return config; }
+
+        // Calculations - each takes the caller's clock read so one query sees one instant
+        Duration get_last_sleep_duration() const;
+        Duration get_remaining_work_time(TimePoint now) const;
+        Duration get_average_sleep_duration(TimePoint now, int days) const;
+        SleepWindowStats get_sleep_window_stats(TimePoint now, int days) const;
+        Duration get_current_session_duration(TimePoint now) const;
+
+        // Schedule
+        TimePoint get_today_target_wake_time(TimePoint now) const;
+        TimePoint get_next_recommended_bedtime(TimePoint now) const;
+        TimePoint get_next_wake_time(TimePoint now) const;
+        bool is_in_sleep_period(TimePoint now) const;
+        bool is_before_target_wake_time(TimePoint now) const;
+        Duration get_time_until_target_wake(TimePoint now) const;
+        Duration get_time_until_next_wake(TimePoint now) const;
+
+        DashboardSnapshot get_dashboard(TimePoint now, int average_days) const;
+        bool export_analysis_csv(const std::string& export_path) const;
+    };
+
+} // namespace descansa
+
+#endif // CORE_SNAPSHOT_H
@@ -0,0 +1,152 @@
+// CsvExportWriter.cpp - Implementation
+#include "CsvExportWriter.h"
+#include "CivilTime.h"
+#include "DurableFile.h"
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <unistd.h>
+
+namespace descansa {
+
+    namespace {
+        // Longest field appended in one piece: "-9223372036854775808" or a local timestamp
+        const size_t kMaxFieldLength = 24;
+
+        void put_two_digits(char* out, int value) {
+            out[0] = static_cast<char>('0' + value / 10);
+            out[1] = static_cast<char>('0' + value % 10);
+        }
+
+        // Digits of value into the tail of scratch; returns the first digit
+        char* format_uint(uint64_t value, char* scratch_end) {
+            char* digit = scratch_end;
+            do {
+                *--digit = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            return digit;
+        }
+    }
+
+    const size_t CsvExportWriter::kDateCacheSize;
+
+    CsvExportWriter::CsvExportWriter(size_t buffer_size)
+            : fd(-1), buffer(buffer_size < kMaxFieldLength ? kMaxFieldLength : buffer_size),
+              used(0), failed(false) {
+        for (size_t i = 0; i < kDateCacheSize; ++i) {
+            date_cache[i].day = std::numeric_limits<int64_t>::min();
+        }
+    }
+
+    CsvExportWriter::~CsvExportWriter() {
+        close();
+    }
+
+    bool CsvExportWriter::open(const std::string& path) {
+        close();
+        used = 0;
+        failed = false;
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        return fd >= 0;
+    }
+
+    bool CsvExportWriter::flush() {
+        if (fd < 0) return false;
+        if (used > 0 && !failed) {
+            failed = !write_fully(fd, buffer.data(), used);
+        }
+        used = 0;
+        return !failed;
+    }
+
+    bool CsvExportWriter::close() {
+        if (fd < 0) return false;
+
+        bool ok = flush();
+        ok = (::close(fd) == 0) && ok;
+        fd = -1;
+        return ok;
+    }
+
+    char* CsvExportWriter::reserve(size_t length) {
+        if (buffer.size() - used < length) {
+            flush();
+        }
+        char* out = buffer.data() + used;
+        used += length;
+        return out;
+    }
+
+    void CsvExportWriter::append(const char* text, size_t length) {
+        if (length > buffer.size()) {
+            // Wider than the buffer - bypass it
+            flush();
+            if (!failed && fd >= 0) failed = !write_fully(fd, text, length);
+            return;
+        }
+        std::memcpy(reserve(length), text, length);
+    }
+
+    void CsvExportWriter::append(const char* text) {
+        append(text, std::strlen(text));
+    }
+
+    void CsvExportWriter::append_char(char c) {
+        *reserve(1) = c;
+    }
+
+    void CsvExportWriter::append_uint(uint64_t value) {
+        char scratch[kMaxFieldLength];
+        char* end = scratch + sizeof(scratch);
+        char* begin = format_uint(value, end);
+        append(begin, static_cast<size_t>(end - begin));
+    }
+
+    void CsvExportWriter::append_int(int64_t value) {
+        char scratch[kMaxFieldLength];
+        char* end = scratch + sizeof(scratch);
+
+        // Negate in unsigned arithmetic so INT64_MIN is safe
+        uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+        char* begin = format_uint(magnitude, end);
+        if (value < 0) *--begin = '-';
+        append(begin, static_cast<size_t>(end - begin));
+    }
+
+    const char* CsvExportWriter::date_prefix(int64_t day) {
+        // Direct-mapped: consecutive sessions touch one or two days
+        DatePrefix& entry = date_cache[static_cast<size_t>(day) % kDateCacheSize];
+        if (entry.day != day) {
+            civil::CivilDate date = civil::civil_from_days(day);
+
+            char scratch[kMaxFieldLength];
+            char* end = scratch + sizeof(scratch);
+            char* year = format_uint(static_cast<uint64_t>(date.year < 0 ? 0 : date.year), end);
+            while (end - year < 4) *--year = '0';
+
+            std::memcpy(entry.text, end - 4, 4);
+            entry.text[4] = '-';
+            put_two_digits(entry.text + 5, date.month);
+            entry.text[7] = '-';
+            put_two_digits(entry.text + 8, date.day);
+            entry.day = day;
+        }
+        return entry.text;
+    }
+
+    void CsvExportWriter::append_local_time(int64_t epoch_seconds) {
+        civil::LocalTime local = civil::to_local(epoch_seconds);
+
+        char* out = reserve(19);
+        std::memcpy(out, date_prefix(local.day_number), 10);
+        out[10] = ' ';
+        put_two_digits(out + 11, local.hour());
+        out[13] = ':';
+        put_two_digits(out + 14, local.minute());
+        out[16] = ':';
+        put_two_digits(out + 17, local.second_of_day % 60);
+    }
+
+} // namespace descansa
@@ -0,0 +1,59 @@
+// CsvExportWriter.h - Buffered streaming writer for large CSV exports
+#ifndef CSV_EXPORT_WRITER_H
+#define CSV_EXPORT_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace descansa {
+
+// Appends fields into one reusable buffer and hands it to write(2) only when
+// it fills, so a large export costs a few hundred syscalls and no per-field
+// streams or heap strings. Integers are formatted by hand; local timestamps
+// reuse a cached "YYYY-MM-DD " prefix per day, leaving only HH:MM:SS to
+// format per value. Errors are sticky: close() reports whether every byte
+// reached the file.
+    class CsvExportWriter {
+    private:
+        struct DatePrefix {
+            int64_t day;        // local day number, or INT64_MIN when empty
+            char text[10];      // YYYY-MM-DD
+        };
+
+        static const size_t kDateCacheSize = 4;
+
+        int fd;
+        std::vector<char> buffer;
+        size_t used;
+        bool failed;
+        DatePrefix date_cache[kDateCacheSize];
+
+        char* reserve(size_t length);
+        const char* date_prefix(int64_t day);
+
+        CsvExportWriter(const CsvExportWriter&);
+        CsvExportWriter& operator=(const CsvExportWriter&);
+
+    public:
+        explicit CsvExportWriter(size_t buffer_size = 256 * 1024);
+        ~CsvExportWriter();
+
+        bool open(const std::string& path);    // truncates
+        bool flush();
+        bool close();                          // flush + close; false if anything failed
+
+        void append(const char* text, size_t length);
+        void append(const char* text);
+        void append_char(char c);
+        void append_int(int64_t value);
+        void append_uint(uint64_t value);
+
+        // Local time as YYYY-MM-DD HH:MM:SS - same text as utils::format_time
+        void append_local_time(int64_t epoch_seconds);
+    };
+
+} // namespace descansa
+
+#endif // CSV_EXPORT_WRITER_H
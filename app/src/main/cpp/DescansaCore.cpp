@@ -1,18 +1,35 @@
 #include "DescansaCore.h"
+#include "CoreSnapshot.h"
+#include "DurableFile.h"
+#include "CivilTime.h"
+#include "TraceBuffer.h"
 #include <sstream>
 #include <iomanip>
 #include <algorithm>
+#include <cmath>
+#include <atomic>
 #include <ctime>
 
 namespace descansa {
 
-    DescansaCore::DescansaCore(const std::string& data_path)
-            : session_active(false), data_file_path(data_path.empty() ? "descansa_data.txt" : data_path) {
+    namespace {
+        // Journal records replayed/appended before they are folded into the snapshot
+        const size_t kJournalCompactionThreshold = 256;
+    }
+
+    DescansaCore::DescansaCore(const std::string& data_path, StorageMode mode)
+            : archive(std::make_shared<ColumnarSessionStore>()), archived_count(0), archive_declared(0),
+              archive_damaged(false), session_active(false),
+              data_file_path(data_path.empty() ? "descansa_data.txt" : data_path),
+              archive_file_path(data_file_path + ".cols"), storage_mode(mode),
+              journal(data_file_path + ".journal"), journal_sequence(0), snapshot_pending(false),
+              history_changed(true), state_version(0) {
         load_data();
     }
 
     DescansaCore::~DescansaCore() {
-        save_data();
+        flush_pending();
+        checkpoint();
     }
 
     void DescansaCore::start_sleep_session() {
@@ -23,6 +40,12 @@ namespace descansa {
 
         current_session_start = utils::now();
         session_active = true;
+
+        publish_snapshot();
+
+        JournalRecord record(JournalRecordType::ACTIVE);
+        record.start_time = to_epoch_seconds(current_session_start);
+        persist(record);
     }
 
     void DescansaCore::end_sleep_session() {
@@ -32,290 +55,553 @@ namespace descansa {
         // NEW: Create session with current configuration context
         SleepSession session(current_session_start, wake_time, config);
         sleep_history.push_back(session);
+        roll_aggregates_forward(wake_time);
+        rolling_aggregates.add(to_epoch_seconds(wake_time), session.sleep_duration.count());
 
         session_active = false;
-        save_data();
+        history_changed = true;
+        publish_snapshot();
+
+        JournalRecord record(JournalRecordType::SESSION);
+        record.start_time = to_epoch_seconds(session.sleep_start);
+        record.end_time = to_epoch_seconds(session.wake_up);
+        record.recorded_time = to_epoch_seconds(session.session_recorded);
+        record.duration_seconds = static_cast<int32_t>(session.sleep_duration.count());
+        record.target_sleep_seconds = static_cast<int32_t>(session.target_sleep_hours_at_session.count());
+        record.target_wake_hour = static_cast<int32_t>(session.target_wake_hour_at_session.count());
+        record.target_wake_minute = static_cast<int32_t>(session.target_wake_minute_at_session.count());
+        persist(record);
     }
 
     void DescansaCore::set_target_sleep_hours(double hours) {
-        config.target_sleep_hours = Duration(hours * 3600.0);
+        config.target_sleep_hours = from_hours(hours);
+        publish_snapshot();
+        persist(make_config_record());
     }
 
     void DescansaCore::set_target_wake_time(int hour, int minute) {
         config.target_wake_hour = std::chrono::hours(hour);
         config.target_wake_minute = std::chrono::minutes(minute);
+        publish_snapshot();
+        persist(make_config_record());
     }
 
-    Duration DescansaCore::get_last_sleep_duration() const {
-        if (sleep_history.empty()) {
-            return Duration(0);
+    std::shared_ptr<const CoreSnapshot> DescansaCore::snapshot() const {
+        return std::atomic_load(&published);
+    }
+
+    void DescansaCore::publish_snapshot() {
+        // The session list is only copied when it changed; config-only
+        // mutations share the previous version's vector
+        if (history_changed || !published_history) {
+            published_history = std::make_shared<const std::vector<SleepSession>>(sleep_history);
+            history_changed = false;
+        }
+
+        std::shared_ptr<CoreSnapshot> next = std::make_shared<CoreSnapshot>();
+        next->version = ++state_version;
+        next->config = config;
+        next->session_active = session_active;
+        next->current_session_start = current_session_start;
+        next->archive = archive;
+        next->archived_count = archived_count;
+        next->recent_sessions = published_history;
+        next->aggregates = rolling_aggregates;
+
+        std::shared_ptr<const CoreSnapshot> version(std::move(next));
+        std::atomic_store(&published, version);
+        if (publish_callback) {
+            publish_callback(version);
         }
-        return sleep_history.back().sleep_duration;
+    }
+
+    void DescansaCore::set_publish_callback(
+            std::function<void(const std::shared_ptr<const CoreSnapshot>&)> callback) {
+        publish_callback = std::move(callback);
+    }
+
+    Duration DescansaCore::get_last_sleep_duration() const {
+        return snapshot()->get_last_sleep_duration();
     }
 
     Duration DescansaCore::get_remaining_work_time() const {
-        return calculate_remaining_work_time(utils::now());
+        return snapshot()->get_remaining_work_time(utils::now());
     }
 
     Duration DescansaCore::get_average_sleep_duration(int days) const {
-        if (sleep_history.empty()) return Duration(0);
+        return snapshot()->get_average_sleep_duration(utils::now(), days);
+    }
 
-        TimePoint cutoff = utils::now() - std::chrono::hours(24 * days);
-        Duration total(0);
-        int count = 0;
+    SleepWindowStats DescansaCore::get_sleep_window_stats(int days) const {
+        return snapshot()->get_sleep_window_stats(utils::now(), days);
+    }
 
+    void DescansaCore::roll_aggregates_forward(TimePoint now) {
+        rolling_aggregates.advance_to(RollingSleepAggregates::day_index(
+                to_epoch_seconds(now)));
+    }
+
+    void DescansaCore::rebuild_rolling_aggregates() {
+        rolling_aggregates.clear();
+        roll_aggregates_forward(utils::now());
+
+        // Only the archive's tail can land in a bucket; afterwards sessions
+        // are added as they complete
+        int64_t oldest = RollingSleepAggregates::window_start(
+                rolling_aggregates.today(), RollingSleepAggregates::kMaxWindowDays);
+        const int64_t* wake_times = archive->column(SessionColumn::WAKE_UP);
+        const int64_t* durations = archive->column(SessionColumn::DURATION);
+        for (size_t i = archive->first_row_waking_since(oldest, archived_count); i < archived_count; ++i) {
+            rolling_aggregates.add(wake_times[i], durations[i]);
+        }
         for (const auto& session : sleep_history) {
-            if (session.wake_up >= cutoff) {
-                total += session.sleep_duration;
-                count++;
+            if (session.is_complete) {
+                rolling_aggregates.add(to_epoch_seconds(session.wake_up),
+                                       session.sleep_duration.count());
             }
         }
+    }
 
-        return count > 0 ? Duration(total.count() / count) : Duration(0);
+    void DescansaCore::on_time_zone_changed() {
+        civil::invalidate_zone_cache();
+        rebuild_rolling_aggregates();
+        publish_snapshot();
     }
 
     TimePoint DescansaCore::get_next_recommended_bedtime() const {
-        TimePoint tomorrow_wake = get_tomorrow_target_wake_time();
-        auto bedtime_duration = std::chrono::duration_cast<std::chrono::system_clock::duration>(config.target_sleep_hours);
-        return tomorrow_wake - bedtime_duration;
+        return snapshot()->get_next_recommended_bedtime(utils::now());
+    }
+
+    bool DescansaCore::save_data() {
+        DESCANSA_TRACE_SCOPE("DescansaCore::save_data");
+
+        if (archive_damaged) return false;  // Would drop the rows the archive failed to supply
+
+        // Every mutation publishes before it persists, so this is the current state
+        size_t rows = 0;
+        if (!write_snapshot(*published, journal_sequence, rows)) return false;
+
+        adopt_archive(rows);
+        return true;
     }
 
-    TimePoint DescansaCore::get_today_target_wake_time() const {
-        TimePoint now = utils::now();
-        TimePoint start_today = utils::start_of_day(now);
+    bool DescansaCore::write_snapshot(const CoreSnapshot& state, uint64_t sequence, size_t& archived_rows) const {
+        DESCANSA_TRACE_SCOPE("DescansaCore::write_snapshot");
+
+        // Session history goes to the column file; the text snapshot only points at it
+        ColumnarSessionWriter writer;
+        writer.reserve(state.get_session_count());
+        writer.append_rows(*state.archive, state.archived_count);
+        for (const auto& session : *state.recent_sessions) {
+            if (session.is_complete) {
+                writer.add_row(to_epoch_seconds(session.sleep_start),
+                               to_epoch_seconds(session.wake_up),
+                               session.sleep_duration.count(),
+                               session.target_sleep_hours_at_session.count(),
+                               session.target_wake_hour_at_session.count() * 60 +
+                               session.target_wake_minute_at_session.count(),
+                               to_epoch_seconds(session.session_recorded));
+            }
+        }
+
+        std::ostringstream file;
+
+        // Save config (UPDATED)
+        file << "CONFIG:" << state.config.target_sleep_hours.count() << ","
+             << state.config.target_wake_hour.count() << ","
+             << state.config.target_wake_minute.count() << "\n";
+
+        // Journal records up to this sequence are folded into the snapshot
+        file << "JOURNAL:" << sequence << "\n";
+        file << "ARCHIVE:" << writer.size() << "\n";
 
-        return start_today + config.target_wake_hour + config.target_wake_minute;
+        // Save current session if active (existing code)
+        if (state.session_active) {
+            auto start_time_t = to_epoch_seconds(state.current_session_start);
+            file << "ACTIVE:" << start_time_t << "\n";
+        }
+
+        // Column file and snapshot land together or not at all
+        std::string archive_image;
+        writer.serialize(archive_image);
+
+        CommitBatch batch(data_file_path + ".commit");
+        batch.stage(archive_file_path, std::move(archive_image));
+        batch.stage(data_file_path, file.str());
+        if (!batch.commit()) return false;
+
+        // Snapshot is complete - the journal is now redundant
+        if (storage_mode == StorageMode::JOURNAL) {
+            journal.reset();
+        }
+
+        archived_rows = writer.size();
+        return true;
     }
 
-    TimePoint DescansaCore::get_tomorrow_target_wake_time() const {
-        TimePoint today_wake = get_today_target_wake_time();
-        return today_wake + std::chrono::hours(24);
+    void DescansaCore::adopt_archive(size_t rows) {
+        // Map the column file just written; if that fails the old mapping and
+        // sleep_history still hold every session, so nothing is lost
+        std::shared_ptr<ColumnarSessionStore> store = std::make_shared<ColumnarSessionStore>();
+        if (rows < archived_count || !store->open(archive_file_path) || store->size() < rows) return;
+
+        // The oldest complete sessions now live in the archive; any recorded
+        // while the file was being written stay in sleep_history
+        size_t moved = rows - archived_count;
+        auto kept = std::remove_if(sleep_history.begin(), sleep_history.end(),
+                                   [&moved](const SleepSession& session) {
+                                       if (!session.is_complete || moved == 0) return false;
+                                       moved--;
+                                       return true;
+                                   });
+        sleep_history.erase(kept, sleep_history.end());
+
+        archive = store;
+        archived_count = rows;
+        archive_declared = rows;
+        history_changed = true;
+        publish_snapshot();
     }
 
-    Duration DescansaCore::calculate_remaining_work_time(TimePoint current_time) const {
-        TimePoint next_bedtime = get_next_recommended_bedtime();
+    bool DescansaCore::checkpoint() {
+        if (storage_mode == StorageMode::SNAPSHOT) {
+            return save_data();
+        }
 
-        if (current_time >= next_bedtime) {
-            return Duration(0); // Past bedtime
+        // Every mutation is already in the journal; only fold it when it has grown
+        if (journal.record_count() >= kJournalCompactionThreshold) {
+            return save_data();
         }
+        return true;
+    }
 
-        return std::chrono::duration_cast<Duration>(next_bedtime - current_time);
+    void DescansaCore::set_dirty_callback(std::function<void()> callback) {
+        dirty_callback = std::move(callback);
     }
 
-    bool DescansaCore::save_data() const {
-        std::ofstream file(data_file_path);
-        if (!file.is_open()) return false;
+    bool DescansaCore::flush_pending() {
+        DESCANSA_TRACE_SCOPE("DescansaCore::flush_pending");
 
-        // Save config (UPDATED)
-        file << "CONFIG:" << config.target_sleep_hours.count() << ","
-             << config.target_wake_hour.count() << ","
-             << config.target_wake_minute.count() << "\n";
+        PendingWrites writes;
+        if (!take_pending_writes(writes)) return true;
 
-        // Save sessions with full configuration context (existing code)
-        for (const auto& session : sleep_history) {
-            if (session.is_complete) {
-                auto start_time_t = std::chrono::system_clock::to_time_t(session.sleep_start);
-                auto end_time_t = std::chrono::system_clock::to_time_t(session.wake_up);
-                auto recorded_time_t = std::chrono::system_clock::to_time_t(session.session_recorded);
-
-                file << "SESSION:" << start_time_t << "," << end_time_t << ","
-                     << session.sleep_duration.count() << ","
-                     << session.target_sleep_hours_at_session.count() << ","
-                     << session.target_wake_hour_at_session.count() << ","
-                     << session.target_wake_minute_at_session.count() << ","
-                     << recorded_time_t << "\n";
-            }
+        bool ok = write_pending_writes(writes);
+        finish_pending_writes(writes, ok);
+        return ok;
+    }
+
+    bool DescansaCore::take_pending_writes(PendingWrites& writes) {
+        if (!has_pending_writes()) return false;
+
+        writes.records.swap(pending_records);
+        pending_records.clear();
+        writes.snapshot = snapshot_pending || storage_mode == StorageMode::SNAPSHOT;
+        writes.state = published;
+        writes.sequence = journal_sequence;
+        writes.snapshot_written = false;
+        writes.archived_rows = 0;
+        writes.snapshot_allowed = !archive_damaged;
+        snapshot_pending = false;
+        return true;
+    }
+
+    bool DescansaCore::write_pending_writes(PendingWrites& writes) const {
+        DESCANSA_TRACE_SCOPE("DescansaCore::write_pending_writes");
+
+        bool ok = true;
+        if (!writes.snapshot) {
+            // The whole burst goes out as one append
+            ok = journal.append(writes.records.data(), writes.records.size());
         }
 
-        // Save current session if active (existing code)
-        if (session_active) {
-            auto start_time_t = std::chrono::system_clock::to_time_t(current_session_start);
-            file << "ACTIVE:" << start_time_t << "\n";
+        if (!ok || writes.snapshot || journal.record_count() >= kJournalCompactionThreshold) {
+            // Compaction waits for a readable archive; the journal keeps everything meanwhile
+            if (!writes.snapshot_allowed) return ok && !writes.snapshot;
+
+            // The captured state already covers every queued sequence
+            ok = write_snapshot(*writes.state, writes.sequence, writes.archived_rows);
+            writes.snapshot_written = ok;
+        }
+        return ok;
+    }
+
+    void DescansaCore::finish_pending_writes(PendingWrites& writes, bool ok) {
+        if (!ok) {
+            // Retried on the next flush, ahead of anything queued since
+            pending_records.insert(pending_records.begin(), writes.records.begin(), writes.records.end());
+            snapshot_pending = snapshot_pending || writes.snapshot;
+            return;
         }
 
-        return file.good();
+        // A clear_history() in the meantime replaced the archive the file was built from
+        if (writes.snapshot_written && archive == writes.state->archive) {
+            adopt_archive(writes.archived_rows);
+        }
     }
 
-    bool DescansaCore::load_data() {
-        std::ifstream file(data_file_path);
-        if (!file.is_open()) return false;
+    void DescansaCore::persist(JournalRecord record) {
+        if (dirty_callback) {
+            // Sequence is assigned now so replay order matches mutation order
+            record.sequence = ++journal_sequence;
+            pending_records.push_back(record);
+            dirty_callback();
+            return;
+        }
 
-        std::string line;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
+        if (storage_mode == StorageMode::SNAPSHOT) {
+            save_data();
+            return;
+        }
 
-            size_t colon_pos = line.find(':');
-            if (colon_pos == std::string::npos) continue;
+        record.sequence = ++journal_sequence;
 
-            std::string type = line.substr(0, colon_pos);
-            std::string data = line.substr(colon_pos + 1);
+        // A failed append falls back to a full snapshot so the change is not lost
+        if (!journal.append(record) || journal.record_count() >= kJournalCompactionThreshold) {
+            save_data();
+        }
+    }
 
-            if (type == "CONFIG") {
-                std::istringstream ss(data);
-                std::string token;
+    JournalRecord DescansaCore::make_config_record() const {
+        JournalRecord record(JournalRecordType::CONFIG);
+        record.target_sleep_seconds = static_cast<int32_t>(config.target_sleep_hours.count());
+        record.target_wake_hour = static_cast<int32_t>(config.target_wake_hour.count());
+        record.target_wake_minute = static_cast<int32_t>(config.target_wake_minute.count());
+        return record;
+    }
 
-                if (std::getline(ss, token, ',')) {
-                    config.target_sleep_hours = Duration(std::stod(token));
-                }
-                if (std::getline(ss, token, ',')) {
-                    config.target_wake_hour = std::chrono::hours(std::stoi(token));
-                }
-                if (std::getline(ss, token, ',')) {
-                    config.target_wake_minute = std::chrono::minutes(std::stoi(token));
-                }
+    void DescansaCore::apply_journal_record(const JournalRecord& record) {
+        switch (record.get_type()) {
+            case JournalRecordType::SESSION: {
+                SleepSession session;
+                session.sleep_start = from_epoch_seconds(record.start_time);
+                session.wake_up = from_epoch_seconds(record.end_time);
+                session.sleep_duration = Duration(record.duration_seconds);
+                session.is_complete = true;
+                session.target_sleep_hours_at_session = Duration(record.target_sleep_seconds);
+                session.target_wake_hour_at_session = std::chrono::hours(record.target_wake_hour);
+                session.target_wake_minute_at_session = std::chrono::minutes(record.target_wake_minute);
+                session.session_recorded = from_epoch_seconds(record.recorded_time);
+
+                sleep_history.push_back(session);
+                session_active = false;
+                break;
             }
+            case JournalRecordType::CONFIG:
+                config.target_sleep_hours = Duration(record.target_sleep_seconds);
+                config.target_wake_hour = std::chrono::hours(record.target_wake_hour);
+                config.target_wake_minute = std::chrono::minutes(record.target_wake_minute);
+                break;
+            case JournalRecordType::ACTIVE:
+                current_session_start = from_epoch_seconds(record.start_time);
+                session_active = true;
+                break;
+        }
+    }
 
-            else if (type == "SESSION") {
-                std::istringstream ss(data);
-                std::string token;
-                std::vector<std::string> tokens;
-
-                while (std::getline(ss, token, ',')) {
-                    tokens.push_back(token);
-                }
+    bool DescansaCore::parse_snapshot_line(const text_parser::TextSpan& line, uint64_t& snapshot_sequence) {
+        using text_parser::TextSpan;
 
-                if (tokens.size() >= 3) {  // Backward compatibility
-                    auto start_t = static_cast<std::time_t>(std::stoll(tokens[0]));
-                    auto end_t = static_cast<std::time_t>(std::stoll(tokens[1]));
+        TextSpan type, data;
+        if (!text_parser::split_record(line, type, data)) return true; // Not a record line
 
-                    TimePoint start = std::chrono::system_clock::from_time_t(start_t);
-                    TimePoint end = std::chrono::system_clock::from_time_t(end_t);
+        text_parser::FieldCursor fields(data);
+        TextSpan token;
 
-                    SleepSession session(start, end, config);  // Use current config as fallback
+        if (type.equals("CONFIG")) {
+            double sleep_seconds = 0.0;     // Older snapshots wrote fractional seconds
+            int wake_hour = 0, wake_minute = 0;
 
-                    // If enhanced data available, use it
-                    if (tokens.size() >= 7) {
-                        session.target_sleep_hours_at_session = Duration(std::stod(tokens[3]));
-                        session.target_wake_hour_at_session = std::chrono::hours(std::stoi(tokens[4]));
-                        session.target_wake_minute_at_session = std::chrono::minutes(std::stoi(tokens[5]));
+            if (fields.next(token)) {
+                if (!text_parser::parse_double(token, sleep_seconds)) return false;
+                config.target_sleep_hours = Duration(std::llround(sleep_seconds));
+            }
+            if (fields.next(token)) {
+                if (!text_parser::parse_int(token, wake_hour)) return false;
+                config.target_wake_hour = std::chrono::hours(wake_hour);
+            }
+            if (fields.next(token)) {
+                if (!text_parser::parse_int(token, wake_minute)) return false;
+                config.target_wake_minute = std::chrono::minutes(wake_minute);
+            }
+        }
+        else if (type.equals("SESSION")) {
+            // start,end[,duration[,target_sleep,wake_hour,wake_minute,recorded]]
+            TextSpan tokens[7];
+            size_t token_count = 0;
+            while (token_count < 7 && fields.next(tokens[token_count])) {
+                token_count++;
+            }
+            if (token_count < 3) return false;  // Backward compatibility: at least start,end,duration
 
-                        auto recorded_t = static_cast<std::time_t>(std::stoll(tokens[6]));
-                        session.session_recorded = std::chrono::system_clock::from_time_t(recorded_t);
-                    }
+            int64_t start_t = 0, end_t = 0;
+            if (!text_parser::parse_int64(tokens[0], start_t) ||
+                !text_parser::parse_int64(tokens[1], end_t)) {
+                return false;
+            }
 
-                    sleep_history.push_back(session);
+            TimePoint start = from_epoch_seconds(start_t);
+            TimePoint end = from_epoch_seconds(end_t);
+
+            SleepSession session(start, end, config);  // Use current config as fallback
+
+            // If enhanced data available, use it
+            if (token_count >= 7) {
+                double target_seconds = 0.0;
+                int wake_hour = 0, wake_minute = 0;
+                int64_t recorded_t = 0;
+                if (!text_parser::parse_double(tokens[3], target_seconds) ||
+                    !text_parser::parse_int(tokens[4], wake_hour) ||
+                    !text_parser::parse_int(tokens[5], wake_minute) ||
+                    !text_parser::parse_int64(tokens[6], recorded_t)) {
+                    return false;
                 }
+
+                session.target_sleep_hours_at_session = Duration(std::llround(target_seconds));
+                session.target_wake_hour_at_session = std::chrono::hours(wake_hour);
+                session.target_wake_minute_at_session = std::chrono::minutes(wake_minute);
+                session.session_recorded = from_epoch_seconds(recorded_t);
             }
-            else if (type == "ACTIVE") {
-                auto start_t = static_cast<std::time_t>(std::stoll(data));
-                current_session_start = std::chrono::system_clock::from_time_t(start_t);
-                session_active = true;
+
+            sleep_history.push_back(session);
+        }
+        else if (type.equals("ACTIVE")) {
+            int64_t start_t = 0;
+            if (!text_parser::parse_int64(data, start_t)) return false;
+
+            current_session_start = from_epoch_seconds(start_t);
+            session_active = true;
+        }
+        else if (type.equals("JOURNAL")) {
+            int64_t sequence = 0;
+            if (!text_parser::parse_int64(data, sequence) || sequence < 0) return false;
+
+            snapshot_sequence = static_cast<uint64_t>(sequence);
+        }
+        else if (type.equals("ARCHIVE")) {
+            int64_t declared = 0;
+            if (!text_parser::parse_int64(data, declared) || declared < 0) {
+                archive_damaged = true;     // Unknown row count - nothing may overwrite the file
+                return false;
+            }
+
+            // Older sessions are mapped, not parsed; only the declared prefix is trusted
+            std::shared_ptr<ColumnarSessionStore> store = std::make_shared<ColumnarSessionStore>();
+            archive_declared = static_cast<size_t>(declared);
+            archived_count = store->open(archive_file_path) ? std::min(archive_declared, store->size()) : 0;
+            archive = store;
+
+            // Queries see the readable rows; the declared count guards the file
+            if (archived_count < archive_declared) {
+                archive_damaged = true;
+                return false;
             }
         }
 
         return true;
     }
 
+    bool DescansaCore::load_data() {
+        DESCANSA_TRACE_SCOPE("DescansaCore::load_data");
+
+        uint64_t snapshot_sequence = 0;
+        load_report = text_parser::ParseReport();
+        archive_declared = 0;
+        archive_damaged = false;
+
+        // Finish (or discard) a save that was interrupted by a crash
+        CommitBatch::recover(data_file_path + ".commit");
+
+        // One buffer for the whole snapshot; lines and fields are views into it
+        std::string buffer;
+        bool snapshot_loaded = text_parser::read_file(data_file_path, buffer);
+
+        text_parser::LineCursor lines(buffer);
+        text_parser::TextSpan line;
+        while (lines.next(line)) {
+            load_report.lines_read++;
+            if (line.empty()) continue;
+
+            if (!parse_snapshot_line(line, snapshot_sequence)) {
+                load_report.note_malformed(lines.line_number());
+            }
+        }
+
+        // Replay mutations journaled after the snapshot was written
+        journal_sequence = snapshot_sequence;
+        size_t replayed = 0;
+        bool journal_intact = journal.replay([&](const JournalRecord& record) {
+            if (record.sequence <= snapshot_sequence) return; // Already in the snapshot
+
+            apply_journal_record(record);
+            journal_sequence = record.sequence;
+            replayed++;
+        });
+
+        rebuild_rolling_aggregates();
+        history_changed = true;
+        publish_snapshot();
+
+        // Fold a damaged, oversized or old-format journal into a fresh snapshot right away
+        if (storage_mode == StorageMode::JOURNAL &&
+            (!journal_intact || journal.needs_upgrade() || replayed >= kJournalCompactionThreshold)) {
+            save_data();
+        }
+
+        return snapshot_loaded || replayed > 0;
+    }
+
     void DescansaCore::clear_history() {
+        DESCANSA_TRACE_SCOPE("DescansaCore::clear_history");
+
+        archive = std::make_shared<ColumnarSessionStore>(); // Readers may still hold the old mapping
+        archived_count = 0;
+        archive_declared = 0;
+        archive_damaged = false;    // Dropping the history is what was asked for
         sleep_history.clear();
-        save_data();
+        rolling_aggregates.clear();
+        history_changed = true;
+        publish_snapshot();
+
+        if (dirty_callback) {
+            pending_records.clear();
+            snapshot_pending = true;
+            dirty_callback();
+            return;
+        }
+        save_data(); // Snapshot of an empty history is tiny and resets the journal
     }
 
     bool DescansaCore::is_in_sleep_period() const {
-        TimePoint now = utils::now();
-        TimePoint today_wake = get_today_target_wake_time();
-        TimePoint tonight_bedtime = get_next_recommended_bedtime();
-
-        // If current time is between bedtime and wake time
-        return (now >= tonight_bedtime) || (now < today_wake);
+        return snapshot()->is_in_sleep_period(utils::now());
     }
 
     bool DescansaCore::is_before_target_wake_time() const {
-        TimePoint now = utils::now();
-        TimePoint today_wake = get_today_target_wake_time();
-        return now < today_wake;
+        return snapshot()->is_before_target_wake_time(utils::now());
     }
 
     Duration DescansaCore::get_time_until_target_wake() const {
-        TimePoint now = utils::now();
-        TimePoint today_wake = get_today_target_wake_time();
-
-        if (now >= today_wake) {
-            return Duration(0); // Return zero if wake time passed
-        }
-
-        return std::chrono::duration_cast<Duration>(today_wake - now);
+        return snapshot()->get_time_until_target_wake(utils::now());
     }
 
     Duration DescansaCore::get_current_session_duration() const {
-        if (!session_active) {
-            return Duration(0);
-        }
-        return std::chrono::duration_cast<Duration>(utils::now() - current_session_start);
+        return snapshot()->get_current_session_duration(utils::now());
     }
 
     bool DescansaCore::export_analysis_csv(const std::string& export_path) const {
-        std::ofstream file(export_path);
-        if (!file.is_open()) return false;
-
-        // Pure CSV header - no decorative elements, all data columns
-        file << "session_id,sleep_start_timestamp,wake_up_timestamp,"
-             << "sleep_duration_seconds,target_sleep_seconds_at_session,"
-             << "target_wake_hour_at_session,target_wake_minute_at_session,"
-             << "session_recorded_timestamp,export_timestamp,"
-             << "sleep_start_iso,wake_up_iso,session_recorded_iso,export_iso\n";
-
-        // Current export timestamp
-        auto export_time = std::chrono::system_clock::now();
-        auto export_timestamp = std::chrono::system_clock::to_time_t(export_time);
-        std::string export_iso = utils::format_time(export_time);
-
-        // Export all sessions with complete raw data
-        for (size_t i = 0; i < sleep_history.size(); ++i) {
-            const auto& session = sleep_history[i];
-            if (session.is_complete) {
-                // Convert to timestamps for analysis
-                auto start_timestamp = std::chrono::system_clock::to_time_t(session.sleep_start);
-                auto wake_timestamp = std::chrono::system_clock::to_time_t(session.wake_up);
-                auto recorded_timestamp = std::chrono::system_clock::to_time_t(session.session_recorded);
-
-                // ISO format strings for human reference in analysis tools
-                std::string start_iso = utils::format_time(session.sleep_start);
-                std::string wake_iso = utils::format_time(session.wake_up);
-                std::string recorded_iso = utils::format_time(session.session_recorded);
-
-                file << i << ","
-                     << start_timestamp << ","
-                     << wake_timestamp << ","
-                     << static_cast<int64_t>(session.sleep_duration.count()) << ","
-                     << static_cast<int64_t>(session.target_sleep_hours_at_session.count()) << ","
-                     << session.target_wake_hour_at_session.count() << ","
-                     << session.target_wake_minute_at_session.count() << ","
-                     << recorded_timestamp << ","
-                     << export_timestamp << ","
-                     << "\"" << start_iso << "\","
-                     << "\"" << wake_iso << "\","
-                     << "\"" << recorded_iso << "\","
-                     << "\"" << export_iso << "\"\n";
-            }
-        }
-
-        return file.good();
+        // Runs against one version - sessions recorded meanwhile don't tear the file
+        return snapshot()->export_analysis_csv(export_path);
     }
 
     Duration DescansaCore::get_time_until_next_wake() const {
-        TimePoint now = utils::now();
-        TimePoint today_wake = get_today_target_wake_time();
-
-        if (now < today_wake) {
-            // Today's wake time hasn't passed yet
-            return std::chrono::duration_cast<Duration>(today_wake - now);
-        } else {
-            // Today's wake time has passed, calculate time until tomorrow's wake
-            TimePoint tomorrow_wake = get_tomorrow_target_wake_time();
-            return std::chrono::duration_cast<Duration>(tomorrow_wake - now);
-        }
+        return snapshot()->get_time_until_next_wake(utils::now());
     }
 
     TimePoint DescansaCore::get_next_wake_time() const {
-        TimePoint now = utils::now();
-        TimePoint today_wake = get_today_target_wake_time();
+        return snapshot()->get_next_wake_time(utils::now());
+    }
 
-        if (now < today_wake) {
-            return today_wake;
-        } else {
-            return get_tomorrow_target_wake_time();
-        }
+    DashboardSnapshot DescansaCore::get_dashboard_snapshot(int average_days) const {
+        return snapshot()->get_dashboard(utils::now(), average_days);
     }
 
     std::string DescansaCore::get_next_wake_time_formatted() const {
@@ -324,13 +610,7 @@ namespace descansa {
     }
 
     std::string DescansaCore::format_wake_time_24h(const TimePoint& wake_time) {
-        auto time_t = std::chrono::system_clock::to_time_t(wake_time);
-        auto tm = *std::localtime(&time_t);
-
-        std::ostringstream ss;
-        ss << std::setfill('0') << std::setw(2) << tm.tm_hour << ":"
-           << std::setfill('0') << std::setw(2) << tm.tm_min;
-        return ss.str();
+        return civil::format_hour_minute(civil::to_seconds(wake_time));
     }
 
 // Utility functions implementation - ONLY keeping functions that are actually used
@@ -346,27 +626,15 @@ namespace descansa {
         }
 
         std::string format_time(const TimePoint& tp) {
-            auto time_t = std::chrono::system_clock::to_time_t(tp);
-            auto tm = *std::localtime(&time_t);
-
-            std::ostringstream ss;
-            ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-            return ss.str();
+            return civil::format_date_time(civil::to_seconds(tp));
         }
 
         TimePoint now() {
-            return std::chrono::system_clock::now();
+            return system_now();
         }
 
         TimePoint start_of_day(const TimePoint& tp) {
-            auto time_t = std::chrono::system_clock::to_time_t(tp);
-            auto tm = *std::localtime(&time_t);
-
-            tm.tm_hour = 0;
-            tm.tm_min = 0;
-            tm.tm_sec = 0;
-
-            return std::chrono::system_clock::from_time_t(std::mktime(&tm));
+            return civil::from_seconds(civil::start_of_local_day(civil::to_seconds(tp)));
         }
 
     } // namespace utils
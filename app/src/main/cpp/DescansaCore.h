@@ -7,15 +7,18 @@
 #include <fstream>
 #include <memory>
 #include <cstdint>
+#include <functional>
+#include "SleepJournal.h"
+#include "ColumnarSessionStore.h"
+#include "TextDataParser.h"
+#include "RollingSleepAggregates.h"
+#include "TimeTypes.h"
 
 namespace descansa {
 
-// Time point using system clock
-    using TimePoint = std::chrono::system_clock::time_point;
-    using Duration = std::chrono::duration<double>;
-
 // Forward declarations
     struct ScheduleConfig;
+    class CoreSnapshot;
 
 // Daily schedule configuration
     struct ScheduleConfig {
@@ -24,7 +27,7 @@ namespace descansa {
         std::chrono::minutes target_wake_minute; // Minute of hour (0-59)
 
         ScheduleConfig()
-                : target_sleep_hours(Duration(8.0 * 3600.0)),  // Fix: explicit Duration constructor
+                : target_sleep_hours(Hours(8)),
                   target_wake_hour(8),
                   target_wake_minute(0) {}
     };
@@ -47,45 +50,119 @@ namespace descansa {
 
         // FIXED: Default constructor - Initialize ALL fields including sleep_duration
         SleepSession()
-                : sleep_duration(0.0),  // FIXED: Explicit initialization
+                : sleep_duration(0),  // FIXED: Explicit initialization
                   is_complete(false),
-                  target_sleep_hours_at_session(Duration(8.0 * 3600)),
+                  target_sleep_hours_at_session(Hours(8)),
                   target_wake_hour_at_session(std::chrono::hours(8)),
                   target_wake_minute_at_session(std::chrono::minutes(0)) {
-            session_recorded = std::chrono::system_clock::now();
+            session_recorded = system_now();
         }
 
         // Constructor with configuration context
         SleepSession(TimePoint start, TimePoint end, const ScheduleConfig& active_config)
                 : sleep_start(start),
                   wake_up(end),
-                  sleep_duration(std::chrono::duration_cast<Duration>(end - start)),  // FIXED: Initialize here too
+                  sleep_duration(end - start),  // FIXED: Initialize here too
                   is_complete(true),
                   target_sleep_hours_at_session(active_config.target_sleep_hours),
                   target_wake_hour_at_session(active_config.target_wake_hour),
                   target_wake_minute_at_session(active_config.target_wake_minute) {
-            session_recorded = std::chrono::system_clock::now();
+            session_recorded = system_now();
         }
     };
 
+// Everything the main screen shows, computed from a single clock read
+    struct DashboardSnapshot {
+        int64_t taken_at;                   // seconds since epoch
+        bool session_running;
+        bool in_sleep_period;
+        bool before_target_wake;
+        int64_t current_session_seconds;
+        int64_t remaining_work_seconds;
+        int64_t time_until_wake_seconds;    // until today's target wake, 0 once passed
+        int64_t time_until_next_wake_seconds;
+        int32_t next_wake_minute_of_day;    // local hour * 60 + minute
+        int64_t last_sleep_seconds;
+        int64_t average_sleep_seconds;
+        int64_t session_count;
+
+        DashboardSnapshot()
+                : taken_at(0), session_running(false), in_sleep_period(false), before_target_wake(false),
+                  current_session_seconds(0), remaining_work_seconds(0), time_until_wake_seconds(0),
+                  time_until_next_wake_seconds(0), next_wake_minute_of_day(0), last_sleep_seconds(0),
+                  average_sleep_seconds(0), session_count(0) {}
+    };
+
+// How mutations reach disk
+    enum class StorageMode {
+        SNAPSHOT,   // every mutation rewrites the whole data file
+        JOURNAL     // mutations append to a journal, folded into the snapshot periodically
+    };
+
 // Core sleep tracking and calculation engine
     class DescansaCore {
     private:
+        // Sessions [0, archived_count) live in the mapped column file;
+        // sleep_history holds the sessions recorded after it was written.
+        // Each open maps a fresh store so published snapshots keep theirs.
+        std::shared_ptr<ColumnarSessionStore> archive;
+        size_t archived_count;
+        // Rows the snapshot declares but the column file could not supply
+        // (missing, corrupt or short). Writing a snapshot now would erase
+        // them, so snapshots are refused until a load finds them readable.
+        size_t archive_declared;
+        bool archive_damaged;
         std::vector<SleepSession> sleep_history;
         ScheduleConfig config;
         TimePoint current_session_start;
         bool session_active;
         std::string data_file_path;
+        std::string archive_file_path;
+
+        // Journal-backed persistence
+        StorageMode storage_mode;
+        mutable SleepJournal journal;
+        uint64_t journal_sequence;      // last sequence number issued or folded into the snapshot
+        text_parser::ParseReport load_report;
+
+        // Deferred persistence - mutations queue here until flush_pending()
+        std::function<void()> dirty_callback;
+        std::vector<JournalRecord> pending_records;
+        bool snapshot_pending;
+
+        // 7/30/90-day windows kept current as sessions complete
+        RollingSleepAggregates rolling_aggregates;
 
-        // Helper methods
-        TimePoint get_today_target_wake_time() const;
-        TimePoint get_tomorrow_target_wake_time() const;
-        Duration calculate_remaining_work_time(TimePoint current_time) const;
+        // Immutable state published after every mutation; all queries read it
+        std::shared_ptr<const CoreSnapshot> published;
+        std::shared_ptr<const std::vector<SleepSession>> published_history;
+        bool history_changed;
+        uint64_t state_version;
+        std::function<void(const std::shared_ptr<const CoreSnapshot>&)> publish_callback;
+
+        // Persistence helpers
+        void persist(JournalRecord record);
+        void apply_journal_record(const JournalRecord& record);
+        JournalRecord make_config_record() const;
+        bool parse_snapshot_line(const text_parser::TextSpan& line, uint64_t& snapshot_sequence);
+        void rebuild_rolling_aggregates();
+        void roll_aggregates_forward(TimePoint now);
+        void publish_snapshot();
+        bool write_snapshot(const CoreSnapshot& state, uint64_t sequence, size_t& archived_rows) const;
+        void adopt_archive(size_t rows);
 
     public:
-        explicit DescansaCore(const std::string& data_path = "");
+        explicit DescansaCore(const std::string& data_path = "",
+                              StorageMode mode = StorageMode::JOURNAL);
         ~DescansaCore();
 
+        // Current state as one immutable version. Safe to call from any thread
+        // without the caller's lock; the result never changes underneath it.
+        std::shared_ptr<const CoreSnapshot> snapshot() const;
+
+        // Called (on the mutating thread) with every newly published version
+        void set_publish_callback(std::function<void(const std::shared_ptr<const CoreSnapshot>&)> callback);
+
         // Session management
         void start_sleep_session();
         void end_sleep_session();
@@ -100,19 +177,58 @@ namespace descansa {
         Duration get_last_sleep_duration() const;
         Duration get_remaining_work_time() const;
         Duration get_average_sleep_duration(int days = 7) const;
+        SleepWindowStats get_sleep_window_stats(int days) const;  // O(1) for 7/30/90 days
         TimePoint get_next_recommended_bedtime() const;
 
         // Current session tracking
         Duration get_current_session_duration() const;
 
         // Data management
-        bool save_data() const;
-        bool load_data();
+        // save_data() also remaps the new column file and drops the sessions
+        // it now holds from sleep_history, so memory stays bounded
+        bool save_data();               // full snapshot; also compacts the journal
+        bool load_data();               // snapshot followed by journal replay
+        bool checkpoint();              // compacts only when the journal has grown large
+
+        // Deferred persistence: with a callback set, mutations only queue their
+        // journal records and signal the callback; flush_pending() writes them
+        // all in one append (called from a background PersistenceWorker).
+        void set_dirty_callback(std::function<void()> callback);
+        bool flush_pending();
+
+        // flush_pending() in three steps, so a caller that guards the core
+        // with a lock need not hold it for the disk I/O: take and finish run
+        // under the lock, write runs outside it and touches only the journal
+        // and the data files. Writes must not overlap each other.
+        struct PendingWrites {
+            std::vector<JournalRecord> records;
+            bool snapshot;                              // fold into a full snapshot
+            bool snapshot_written;
+            std::shared_ptr<const CoreSnapshot> state;  // what a snapshot holds
+            uint64_t sequence;                          // last journal sequence it covers
+            size_t archived_rows;
+            bool snapshot_allowed;                      // false while the archive is damaged
+
+            PendingWrites() : snapshot(false), snapshot_written(false), sequence(0), archived_rows(0),
+                              snapshot_allowed(true) {}
+        };
+        bool take_pending_writes(PendingWrites& writes);        // false if nothing is pending
+        bool write_pending_writes(PendingWrites& writes) const;
+        void finish_pending_writes(PendingWrites& writes, bool ok);
+        bool has_pending_writes() const { return !pending_records.empty() || snapshot_pending; }
         bool export_analysis_csv(const std::string& export_path) const;  // USED by MainActivity
         void clear_history();
 
         // Statistics
-        size_t get_session_count() const { return sleep_history.size(); }
+        size_t get_session_count() const { return archived_count + sleep_history.size(); }
+        StorageMode get_storage_mode() const { return storage_mode; }
+        size_t get_journal_record_count() const { return journal.record_count(); }
+        const text_parser::ParseReport& get_load_report() const { return load_report; }
+        bool is_archive_intact() const { return !archive_damaged; }
+        size_t get_missing_archive_rows() const { return archive_declared - archived_count; }
+
+        // Re-reads the device time zone and re-buckets the day windows by the new local days
+        void on_time_zone_changed();
 
         // Current status - USED by MainActivity
         bool is_in_sleep_period() const;
@@ -124,6 +240,9 @@ namespace descansa {
         TimePoint get_next_wake_time() const;
         std::string get_next_wake_time_formatted() const;
 
+        // Whole dashboard in one call (one clock read, no per-field re-entry)
+        DashboardSnapshot get_dashboard_snapshot(int average_days = 7) const;
+
         // Helper method for 24-hour time formatting
         static std::string format_wake_time_24h(const TimePoint& wake_time) ;
 
@@ -1,5 +1,10 @@
 #include "DescansaCoreManager.h"
+#include "DurableFile.h"
+#include "ScratchArena.h"
+#include "CivilTime.h"
+#include "TraceBuffer.h"
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
@@ -8,9 +13,44 @@
 
 namespace descansa {
 
+    namespace {
+
+        // Orders sessions by wake time; usable with lower_bound and upper_bound
+        struct WakeTimeOrder {
+            bool operator()(const DetailedSleepSession& session, const TimePoint& time) const {
+                return session.wake_up < time;
+            }
+            bool operator()(const TimePoint& time, const DetailedSleepSession& session) const {
+                return time < session.wake_up;
+            }
+            bool operator()(const DetailedSleepSession& a, const DetailedSleepSession& b) const {
+                return a.wake_up < b.wake_up;
+            }
+        };
+
+        // Orders daily summaries by date
+        struct SummaryDateOrder {
+            bool operator()(const DailySleepSummary& summary, const TimePoint& time) const {
+                return summary.date < time;
+            }
+            bool operator()(const TimePoint& time, const DailySleepSummary& summary) const {
+                return time < summary.date;
+            }
+            bool operator()(const DailySleepSummary& a, const DailySleepSummary& b) const {
+                return a.date < b.date;
+            }
+        };
+
+    } // namespace
+
 // DescansaCoreManager Implementation
     DescansaCoreManager::DescansaCoreManager(const std::string& data_dir)
-            : enhanced_session_active(false), data_directory(data_dir.empty() ? "descansa_data" : data_dir) {
+            : metric_sketches_stale(false), enhanced_session_active(false), data_directory(data_dir.empty() ? "descansa_data" : data_dir),
+              save_pending(false),
+              sensor_pipeline([this](const ActivityEpoch& epoch) {
+                  std::lock_guard<std::mutex> lock(sensor_epoch_mutex);
+                  sensor_epochs.push_back(epoch);
+              }) {
 
         // Initialize basic core for compatibility
         basic_core.reset(new DescansaCore(data_directory + "/basic_data.txt"));
@@ -20,6 +60,8 @@ namespace descansa {
         summaries_file = data_directory + "/daily_summaries.dat";
         goals_file = data_directory + "/user_goals.dat";
         environment_file = data_directory + "/environment_data.dat";
+        sketches_file = data_directory + "/metric_sketches.dat";
+        commit_log_file = data_directory + "/manager_data.commit";
 
         load_all_data();
     }
@@ -36,12 +78,20 @@ namespace descansa {
             end_enhanced_sleep_session(); // End previous session
         }
 
-        session_start_time = std::chrono::system_clock::now();
+        session_start_time = system_now();
         current_session = DetailedSleepSession();
         current_session.sleep_start = session_start_time;
         current_session.created_timestamp = session_start_time;
         enhanced_session_active = true;
 
+        {
+            std::lock_guard<std::mutex> lock(sensor_epoch_mutex);
+            sensor_epochs.clear();
+        }
+        sleep_scorer.reset();
+        applied_sleep_summary = SleepWakeSummary();
+        sensor_pipeline.start();
+
         // Sync with basic core
         basic_core->start_sleep_session();
     }
@@ -49,19 +99,17 @@ namespace descansa {
     void DescansaCoreManager::end_enhanced_sleep_session() {
         if (!enhanced_session_active) return;
 
-        TimePoint wake_time = std::chrono::system_clock::now();
-        current_session.wake_up = wake_time;
-        current_session.total_sleep_duration = std::chrono::duration_cast<Duration>(
-                wake_time - current_session.sleep_start);
-        current_session.time_in_bed = current_session.total_sleep_duration;
+        // Score whatever the sensor delivered up to now
+        sensor_pipeline.stop();
+        process_sensor_data();
+
+        TimePoint wake_time = system_now();
+        apply_session_totals(current_session, wake_time);
         current_session.is_complete = true;
         current_session.modified_timestamp = wake_time;
 
-        // Calculate efficiency
-        current_session.sleep_efficiency = current_session.calculate_sleep_efficiency();
-
         // Store completed session
-        detailed_sessions.push_back(current_session);
+        insert_session_ordered(current_session);
 
         // Update daily summary
         update_daily_summary(current_session);
@@ -77,13 +125,13 @@ namespace descansa {
         basic_core->end_sleep_session();
 
         // Save data
-        save_all_data();
+        persist_all_data();
     }
 
     void DescansaCoreManager::pause_session() {
         if (!enhanced_session_active) return;
 
-        TimePoint pause_time = std::chrono::system_clock::now();
+        TimePoint pause_time = system_now();
         Duration awake_duration = std::chrono::duration_cast<Duration>(
                 pause_time - session_start_time);
 
@@ -93,7 +141,7 @@ namespace descansa {
 
     void DescansaCoreManager::resume_session() {
         if (!enhanced_session_active) return;
-        session_start_time = std::chrono::system_clock::now();
+        session_start_time = system_now();
     }
 
     void DescansaCoreManager::update_environment_data(const SleepEnvironment& env) {
@@ -118,8 +166,13 @@ namespace descansa {
         if (enhanced_session_active) {
             current_session.perceived_quality = quality;
         } else if (!detailed_sessions.empty()) {
-            detailed_sessions.back().perceived_quality = quality;
-            detailed_sessions.back().modified_timestamp = std::chrono::system_clock::now();
+            DetailedSleepSession& last = detailed_sessions.back();
+            if (last.perceived_quality != quality && SleepMetricSketches::tracks(last)) {
+                metric_sketches_stale = true;   // The score changed
+            }
+            last.perceived_quality = quality;
+            last.modified_timestamp = system_now();
+            session_columns.update(detailed_sessions.size() - 1, last);
         }
     }
 
@@ -134,15 +187,59 @@ namespace descansa {
                 detailed_sessions.back().notes += "; ";
             }
             detailed_sessions.back().notes += note;
-            detailed_sessions.back().modified_timestamp = std::chrono::system_clock::now();
+            detailed_sessions.back().modified_timestamp = system_now();
         }
     }
 
+    void DescansaCoreManager::set_sleep_phases(const std::vector<SleepPhase>& phases) {
+        if (enhanced_session_active) {
+            current_session.set_sleep_phases(phases);
+        } else if (!detailed_sessions.empty()) {
+            detailed_sessions.back().set_sleep_phases(phases);
+            detailed_sessions.back().modified_timestamp = system_now();
+        }
+    }
+
+    size_t DescansaCoreManager::push_accelerometer_samples(const AccelerometerSample* samples, size_t count) {
+        return sensor_pipeline.push_samples(samples, count);
+    }
+
+    void DescansaCoreManager::process_sensor_data() {
+        std::vector<ActivityEpoch> epochs;
+        {
+            std::lock_guard<std::mutex> lock(sensor_epoch_mutex);
+            epochs.swap(sensor_epochs);
+        }
+
+        for (const auto& epoch : epochs) {
+            record_activity_epoch(epoch);
+        }
+    }
+
+    void DescansaCoreManager::record_activity_epoch(const ActivityEpoch& epoch) {
+        if (!enhanced_session_active) return;
+
+        // Re-scores only the newest minutes, so a live preview stays cheap all night
+        sleep_scorer.add(epoch, current_session.hypnogram);
+        const SleepWakeSummary& scored = sleep_scorer.summary();
+
+        // Apply the change, so awakenings logged by hand (pause_session, add_awakening) are kept
+        current_session.awakenings_count += scored.awakenings - applied_sleep_summary.awakenings;
+        current_session.total_awake_time += scored.awake_after_onset - applied_sleep_summary.awake_after_onset;
+        applied_sleep_summary = scored;
+        current_session.update_stage_durations();
+    }
+
     void DescansaCoreManager::mark_as_nap(bool is_nap) {
         if (enhanced_session_active) {
             current_session.is_nap = is_nap;
         } else if (!detailed_sessions.empty()) {
-            detailed_sessions.back().is_nap = is_nap;
+            DetailedSleepSession& last = detailed_sessions.back();
+            if (last.is_nap != is_nap && last.is_complete) {
+                metric_sketches_stale = true;   // The session joins or leaves the reference set
+            }
+            last.is_nap = is_nap;
+            session_columns.update(detailed_sessions.size() - 1, last);
         }
     }
 
@@ -152,13 +249,7 @@ namespace descansa {
         }
 
         // Also update daily summary if exists
-        DailySleepSummary* today_summary = nullptr;
-        for (auto& summary : daily_summaries) {
-            if (is_same_calendar_day(summary.date, time)) {
-                today_summary = &summary;
-                break;
-            }
-        }
+        DailySleepSummary* today_summary = find_daily_summary(time);
 
         if (today_summary) {
             today_summary->caffeine_times.push_back(time);
@@ -171,13 +262,7 @@ namespace descansa {
         }
 
         // Update daily summary
-        DailySleepSummary* today_summary = nullptr;
-        for (auto& summary : daily_summaries) {
-            if (is_same_calendar_day(summary.date, time)) {
-                today_summary = &summary;
-                break;
-            }
-        }
+        DailySleepSummary* today_summary = find_daily_summary(time);
 
         if (today_summary) {
             today_summary->meal_times.push_back(time);
@@ -205,7 +290,7 @@ namespace descansa {
         user_goals = goals;
 
         // Sync target duration with basic core
-        basic_core->set_target_sleep_hours(goals.target_sleep_duration.count() / 3600.0);
+        basic_core->set_target_sleep_hours(to_hours(goals.target_sleep_duration));
         basic_core->set_target_wake_time(
                 static_cast<int>(goals.preferred_wake_time.count()),
                 0
@@ -214,7 +299,7 @@ namespace descansa {
 
     void DescansaCoreManager::update_target_sleep_duration(const Duration& duration) {
         user_goals.target_sleep_duration = duration;
-        basic_core->set_target_sleep_hours(duration.count() / 3600.0);
+        basic_core->set_target_sleep_hours(to_hours(duration));
     }
 
     void DescansaCoreManager::update_preferred_schedule(std::chrono::hours bedtime, std::chrono::hours wake_time) {
@@ -228,121 +313,130 @@ namespace descansa {
         user_goals.weekend_sleep_extension = extension;
     }
 
-    std::vector<DetailedSleepSession> DescansaCoreManager::get_sessions(int count) const {
-        if (count <= 0 || count >= static_cast<int>(detailed_sessions.size())) {
-            return detailed_sessions;
-        }
-
-        return std::vector<DetailedSleepSession>(
-                detailed_sessions.end() - count,
-                detailed_sessions.end()
-        );
+    ConstSpan<DetailedSleepSession> DescansaCoreManager::get_sessions(int count) const {
+        ConstSpan<DetailedSleepSession> all(detailed_sessions);
+        return count <= 0 ? all : all.last(static_cast<size_t>(count));
     }
 
-    std::vector<DetailedSleepSession> DescansaCoreManager::get_sessions_in_range(
+    ConstSpan<DetailedSleepSession> DescansaCoreManager::get_sessions_waking_in_range(
             const TimePoint& start, const TimePoint& end) const {
+        // Sessions that woke in [start, end]; one that began before start is included
+        auto range = sessions_waking_between(start, end);
+        return ConstSpan<DetailedSleepSession>(detailed_sessions.data() + (range.first - detailed_sessions.begin()),
+                                               static_cast<size_t>(range.second - range.first));
+    }
 
-        std::vector<DetailedSleepSession> result;
-
-        for (const auto& session : detailed_sessions) {
-            if (session.sleep_start >= start && session.wake_up <= end) {
-                result.push_back(session);
+    void DescansaCoreManager::for_each_session_in_range(const TimePoint& start, const TimePoint& end,
+                                                        const SessionVisitor& visitor) const {
+        // A session that started after start also woke after it - only that slice can match
+        for (const auto& session : get_sessions_waking_in_range(start, end)) {
+            if (session.sleep_start >= start) {
+                visitor(session);
             }
         }
+    }
 
+    std::vector<DetailedSleepSession> DescansaCoreManager::get_sessions_in_range(
+            const TimePoint& start, const TimePoint& end) const {
+        std::vector<DetailedSleepSession> result;
+        for_each_session_in_range(start, end, [&result](const DetailedSleepSession& session) {
+            result.push_back(session);
+        });
         return result;
     }
 
     DailySleepSummary DescansaCoreManager::get_daily_summary(const TimePoint& date) const {
-        for (const auto& summary : daily_summaries) {
-            if (is_same_calendar_day(summary.date, date)) {
-                return summary;
-            }
+        size_t row = 0;
+        if (summary_days.find(LocalDayIndex::day_of(date), row)) {
+            return daily_summaries[row];
         }
 
         // Return empty summary for date
         return DailySleepSummary(date);
     }
 
-    std::vector<DailySleepSummary> DescansaCoreManager::get_recent_summaries(int days) const {
-        TimePoint cutoff = std::chrono::system_clock::now() - std::chrono::hours(24 * days);
-
-        std::vector<DailySleepSummary> result;
-        for (const auto& summary : daily_summaries) {
-            if (summary.date >= cutoff) {
-                result.push_back(summary);
-            }
-        }
+    ConstSpan<DailySleepSummary> DescansaCoreManager::get_recent_summaries(int days) const {
+        TimePoint cutoff = system_now() - std::chrono::hours(24 * days);
 
-        return result;
+        auto first = std::lower_bound(daily_summaries.begin(), daily_summaries.end(), cutoff, SummaryDateOrder());
+        return ConstSpan<DailySleepSummary>(daily_summaries).subspan(
+                static_cast<size_t>(first - daily_summaries.begin()), daily_summaries.size());
     }
 
-    WeeklySleepPattern DescansaCoreManager::get_weekly_pattern(const TimePoint& week_start) const {
-        for (const auto& pattern : weekly_patterns) {
-            if (is_same_calendar_day(pattern.week_start, week_start)) {
-                return pattern;
-            }
-        }
+    int64_t DescansaCoreManager::week_of(int64_t day) {
+        // Weeks start on Monday; weekday_from_days counts from Sunday
+        return day - (civil::weekday_from_days(day) + 6) % 7;
+    }
 
-        // Generate new weekly pattern if not found
-        WeeklySleepPattern new_pattern(week_start);
+    const WeeklySleepPattern& DescansaCoreManager::get_weekly_pattern(const TimePoint& date) const {
+        return weekly_pattern_for_week(week_of(LocalDayIndex::day_of(date)));
+    }
 
-        // Fill with daily summaries from that week
-        TimePoint week_end = week_start + std::chrono::hours(24 * 7);
-        for (const auto& summary : daily_summaries) {
-            if (summary.date >= week_start && summary.date < week_end) {
-                new_pattern.daily_summaries.push_back(summary);
-            }
+    const WeeklySleepPattern& DescansaCoreManager::weekly_pattern_for_week(int64_t first_day) const {
+        auto cached = weekly_pattern_cache.find(first_day);
+        if (cached != weekly_pattern_cache.end()) {
+            return cached->second;
         }
 
-        new_pattern.analyze_patterns();
-        new_pattern.generate_recommendations();
+        WeeklySleepPattern& pattern = weekly_pattern_cache[first_day];
+        pattern = WeeklySleepPattern(from_epoch_seconds(civil::from_local(first_day, 0)));
 
-        return new_pattern;
+        // The summary index already knows every row's day - no zone conversions
+        std::pair<size_t, size_t> rows = summary_days.rows_between(first_day, first_day + 7);
+        pattern.daily_summaries.assign(daily_summaries.begin() + static_cast<std::ptrdiff_t>(rows.first),
+                                       daily_summaries.begin() + static_cast<std::ptrdiff_t>(rows.second));
+
+        pattern.analyze_patterns();
+        pattern.generate_recommendations();
+        return pattern;
     }
 
-    std::vector<WeeklySleepPattern> DescansaCoreManager::get_recent_weekly_patterns(int weeks) const {
-        std::vector<WeeklySleepPattern> result;
+    void DescansaCoreManager::invalidate_week_of(int64_t day) {
+        weekly_pattern_cache.erase(week_of(day));
+    }
 
-        TimePoint current_week = std::chrono::system_clock::now();
+    void DescansaCoreManager::for_each_recent_weekly_pattern(int weeks, const WeeklyPatternVisitor& visitor) const {
+        int64_t current_week = week_of(LocalDayIndex::day_of(system_now()));
         for (int i = 0; i < weeks; ++i) {
-            TimePoint week_start = current_week - std::chrono::hours(24 * 7 * i);
-            result.push_back(get_weekly_pattern(week_start));
+            visitor(weekly_pattern_for_week(current_week - 7 * i));
         }
-
-        return result;
     }
 
-    DetailedSleepSession DescansaCoreManager::get_current_session_preview() const {
+    DetailedSleepSession DescansaCoreManager::get_current_session_preview() {
         if (!enhanced_session_active) {
             return DetailedSleepSession();
         }
 
-        DetailedSleepSession preview = current_session;
-        preview.wake_up = std::chrono::system_clock::now();
-        preview.total_sleep_duration = std::chrono::duration_cast<Duration>(
-                preview.wake_up - preview.sleep_start);
-        preview.time_in_bed = preview.total_sleep_duration;
-        preview.sleep_efficiency = preview.calculate_sleep_efficiency();
+        // The UI polls this during the night, so it is where queued epochs get scored
+        process_sensor_data();
 
+        DetailedSleepSession preview = current_session;
+        apply_session_totals(preview, system_now());
         return preview;
     }
 
+    void DescansaCoreManager::apply_session_totals(DetailedSleepSession& session, const TimePoint& until) const {
+        session.wake_up = until;
+        session.time_in_bed = std::chrono::duration_cast<Duration>(until - session.sleep_start);
+
+        // Asleep is what the scorer wrote into the hypnogram - the same rule a
+        // reload applies. Awakenings and awake time already carry the
+        // scorer's share (record_activity_epoch).
+        session.update_sleep_duration();
+        session.sleep_efficiency = session.calculate_sleep_efficiency();
+    }
+
     Duration DescansaCoreManager::get_enhanced_remaining_work_time() const {
         // Use basic core calculation but enhance with user goals
         Duration basic_remaining = basic_core->get_remaining_work_time();
 
         // Adjust based on user's specific schedule preferences
-        TimePoint now = std::chrono::system_clock::now();
-        auto now_time_t = std::chrono::system_clock::to_time_t(now);
-        auto now_tm = *std::localtime(&now_time_t);
+        TimePoint now = system_now();
 
         // Calculate target bedtime for today
-        now_tm.tm_hour = static_cast<int>(user_goals.preferred_bedtime.count());
-        now_tm.tm_min = 0;
-        now_tm.tm_sec = 0;
-
-        TimePoint target_bedtime = std::chrono::system_clock::from_time_t(std::mktime(&now_tm));
+        int64_t today = civil::local_day(civil::to_seconds(now));
+        TimePoint target_bedtime = civil::from_seconds(civil::from_local(
+                today, static_cast<int32_t>(user_goals.preferred_bedtime.count() * 3600)));
 
         // If target bedtime is in the past, move to tomorrow
         if (target_bedtime <= now) {
@@ -356,13 +450,15 @@ namespace descansa {
         std::vector<std::string> recommendations;
 
         // Check recent sleep patterns
-        if (detailed_sessions.size() >= 3) {
-            auto recent_sessions = get_sessions(3);
+        if (session_columns.size() >= 3) {
+            size_t first = session_columns.size() - 3;
+            const int64_t* durations = session_columns.durations();
+            const int64_t* sleep_starts = session_columns.sleep_starts();
 
             // Check for consistent sleep debt
             int debt_days = 0;
-            for (const auto& session : recent_sessions) {
-                if (session.total_sleep_duration < user_goals.target_sleep_duration) {
+            for (size_t row = first; row < session_columns.size(); ++row) {
+                if (durations[row] < user_goals.target_sleep_duration.count()) {
                     debt_days++;
                 }
             }
@@ -373,12 +469,11 @@ namespace descansa {
 
             // Check for late bedtimes
             auto avg_bedtime_hour = 0.0;
-            for (const auto& session : recent_sessions) {
-                auto time_t = std::chrono::system_clock::to_time_t(session.sleep_start);
-                auto tm = *std::localtime(&time_t);
-                avg_bedtime_hour += tm.tm_hour + (tm.tm_min / 60.0);
+            for (size_t row = first; row < session_columns.size(); ++row) {
+                civil::LocalTime bedtime = civil::to_local(sleep_starts[row]);
+                avg_bedtime_hour += bedtime.hour() + (bedtime.minute() / 60.0);
             }
-            avg_bedtime_hour /= recent_sessions.size();
+            avg_bedtime_hour /= 3;
 
             if (avg_bedtime_hour > user_goals.preferred_bedtime.count() + 1) {
                 recommendations.push_back("Your recent bedtimes are later than your goal - try to wind down earlier");
@@ -390,7 +485,7 @@ namespace descansa {
         recommendations.insert(recommendations.end(), env_recommendations.begin(), env_recommendations.end());
 
         // Current time recommendations
-        TimePoint now = std::chrono::system_clock::now();
+        TimePoint now = system_now();
         auto remaining_work = get_enhanced_remaining_work_time();
 
         if (remaining_work.count() < 2 * 3600) { // Less than 2 hours
@@ -436,15 +531,15 @@ namespace descansa {
     }
 
     bool DescansaCoreManager::export_summary_csv(const std::string& export_path) const {
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::export_summary_csv");
+
         std::ofstream file(export_path);
         if (!file.is_open()) return false;
 
         file << "Date,Total Sleep (hours),Sleep Efficiency (%),Sleep Score,Met Goal,Sleep Debt (hours)\n";
 
         for (const auto& summary : daily_summaries) {
-            auto date_time_t = std::chrono::system_clock::to_time_t(summary.date);
-
-            file << std::put_time(std::localtime(&date_time_t), "%Y-%m-%d") << ","
+            file << civil::format_date(civil::to_seconds(summary.date)) << ","
                  << std::fixed << std::setprecision(2) << (summary.total_sleep_time.count() / 3600.0) << ","
                  << std::setprecision(1) << summary.average_sleep_efficiency << ","
                  << std::setprecision(1) << summary.get_sleep_score() << ","
@@ -456,18 +551,26 @@ namespace descansa {
     }
 
     bool DescansaCoreManager::export_weekly_patterns_json(const std::string& export_path) const {
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::export_weekly_patterns_json");
+
         std::ofstream file(export_path);
         if (!file.is_open()) return false;
 
         file << "{\n";
         file << "  \"weekly_patterns\": [\n";
 
-        for (size_t i = 0; i < weekly_patterns.size(); ++i) {
-            const auto& pattern = weekly_patterns[i];
-            auto week_time_t = std::chrono::system_clock::to_time_t(pattern.week_start);
+        // Every week that has at least one summary, oldest first
+        std::vector<int64_t> weeks;
+        for (size_t row = 0; row < summary_days.size(); ++row) {
+            int64_t week = week_of(summary_days.day_at(row));
+            if (weeks.empty() || weeks.back() != week) weeks.push_back(week);
+        }
+
+        for (size_t i = 0; i < weeks.size(); ++i) {
+            const auto& pattern = weekly_pattern_for_week(weeks[i]);
 
             file << "    {\n";
-            file << "      \"week_start\": \"" << std::put_time(std::localtime(&week_time_t), "%Y-%m-%d") << "\",\n";
+            file << "      \"week_start\": \"" << civil::format_date(civil::to_seconds(pattern.week_start)) << "\",\n";
             file << "      \"average_sleep_duration_hours\": " << (pattern.average_sleep_duration.count() / 3600.0) << ",\n";
             file << "      \"average_sleep_efficiency\": " << pattern.average_sleep_efficiency << ",\n";
             file << "      \"average_sleep_score\": " << pattern.average_sleep_score << ",\n";
@@ -483,7 +586,7 @@ namespace descansa {
 
             file << "      ]\n";
             file << "    }";
-            if (i < weekly_patterns.size() - 1) file << ",";
+            if (i < weeks.size() - 1) file << ",";
             file << "\n";
         }
 
@@ -500,7 +603,7 @@ namespace descansa {
 
         auto now = std::time(nullptr);
         backup << "# Descansa Data Backup\n";
-        backup << "# Generated: " << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M:%S") << "\n\n";
+        backup << "# Generated: " << civil::format_date_time(now) << "\n\n";
 
         // Backup goals
         backup << "[GOALS]\n";
@@ -515,14 +618,7 @@ namespace descansa {
         backup << "[SESSIONS]\n";
         for (const auto& session : detailed_sessions) {
             if (session.is_complete) {
-                auto start_time_t = std::chrono::system_clock::to_time_t(session.sleep_start);
-                auto end_time_t = std::chrono::system_clock::to_time_t(session.wake_up);
-
-                backup << start_time_t << "," << end_time_t << ","
-                       << session.sleep_efficiency << "," << static_cast<int>(session.perceived_quality) << ","
-                       << (session.is_nap ? "1" : "0") << "," << session.awakenings_count << ","
-                       << session.room_temperature << "," << session.noise_level << ","
-                       << session.light_level << ",\"" << session.notes << "\"\n";
+                write_session_line(backup, session);
             }
         }
         backup << "\n";
@@ -530,7 +626,7 @@ namespace descansa {
         // Backup daily summaries
         backup << "[SUMMARIES]\n";
         for (const auto& summary : daily_summaries) {
-            auto date_time_t = std::chrono::system_clock::to_time_t(summary.date);
+            auto date_time_t = to_epoch_seconds(summary.date);
             backup << date_time_t << "," << summary.total_sleep_time.count() << ","
                    << summary.average_sleep_efficiency << "," << (summary.met_sleep_goal ? "1" : "0") << ","
                    << summary.sleep_debt.count() << "\n";
@@ -541,118 +637,86 @@ namespace descansa {
 
 // Continue with the rest of the implementation...
     bool DescansaCoreManager::save_all_data() const {
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::save_all_data");
+
         // Save to basic text format for simplicity and cross-platform compatibility
-        std::ofstream sessions_out(sessions_file);
-        if (sessions_out.is_open()) {
-            sessions_out << detailed_sessions.size() << "\n";
-            for (const auto& session : detailed_sessions) {
-                if (session.is_complete) {
-                    auto start_time_t = std::chrono::system_clock::to_time_t(session.sleep_start);
-                    auto end_time_t = std::chrono::system_clock::to_time_t(session.wake_up);
-
-                    sessions_out << start_time_t << "," << end_time_t << ","
-                                 << session.sleep_efficiency << "," << static_cast<int>(session.perceived_quality) << ","
-                                 << (session.is_nap ? "1" : "0") << "," << session.awakenings_count << ","
-                                 << session.room_temperature << "," << session.noise_level << ","
-                                 << session.light_level << ",\"" << session.notes << "\"\n";
-                }
+        std::ostringstream sessions_out;
+        sessions_out << detailed_sessions.size() << "\n";
+        for (const auto& session : detailed_sessions) {
+            if (session.is_complete) {
+                write_session_line(sessions_out, session);
             }
-            sessions_out.close();
         }
 
         // Save daily summaries
-        std::ofstream summaries_out(summaries_file);
-        if (summaries_out.is_open()) {
-            summaries_out << daily_summaries.size() << "\n";
-            for (const auto& summary : daily_summaries) {
-                auto date_time_t = std::chrono::system_clock::to_time_t(summary.date);
-                summaries_out << date_time_t << "," << summary.total_sleep_time.count() << ","
-                              << summary.average_sleep_efficiency << "," << (summary.met_sleep_goal ? "1" : "0") << ","
-                              << summary.sleep_debt.count() << "\n";
-            }
-            summaries_out.close();
+        std::ostringstream summaries_out;
+        summaries_out << daily_summaries.size() << "\n";
+        for (const auto& summary : daily_summaries) {
+            auto date_time_t = to_epoch_seconds(summary.date);
+            summaries_out << date_time_t << "," << summary.total_sleep_time.count() << ","
+                          << summary.average_sleep_efficiency << "," << (summary.met_sleep_goal ? "1" : "0") << ","
+                          << summary.sleep_debt.count() << "\n";
         }
 
         // Save user goals
-        std::ofstream goals_out(goals_file);
-        if (goals_out.is_open()) {
-            goals_out << user_goals.target_sleep_duration.count() << "\n";
-            goals_out << user_goals.preferred_bedtime.count() << "\n";
-            goals_out << user_goals.preferred_wake_time.count() << "\n";
-            goals_out << user_goals.target_sleep_efficiency << "\n";
-            goals_out << (user_goals.weekend_schedule_differs ? "1" : "0") << "\n";
-            goals_out << user_goals.weekend_sleep_extension.count() << "\n";
-            goals_out.close();
-        }
-
-        return true;
+        std::ostringstream goals_out;
+        goals_out << user_goals.target_sleep_duration.count() << "\n";
+        goals_out << user_goals.preferred_bedtime.count() << "\n";
+        goals_out << user_goals.preferred_wake_time.count() << "\n";
+        goals_out << user_goals.target_sleep_efficiency << "\n";
+        goals_out << (user_goals.weekend_schedule_differs ? "1" : "0") << "\n";
+        goals_out << user_goals.weekend_sleep_extension.count() << "\n";
+
+        // All three files are one transaction - a crash never leaves them out of step
+        CommitBatch batch(commit_log_file);
+        batch.stage(sessions_file, sessions_out.str());
+        batch.stage(summaries_file, summaries_out.str());
+        batch.stage(goals_file, goals_out.str());
+
+        // Percentile sketches, so a restart doesn't rebuild them
+        std::ostringstream sketches_out;
+        fresh_metric_sketches().write(sketches_out);
+        batch.stage(sketches_file, sketches_out.str());
+        return batch.commit();
     }
 
     bool DescansaCoreManager::load_all_data() {
-        // Load detailed sessions
-        std::ifstream sessions_in(sessions_file);
-        if (sessions_in.is_open()) {
-            size_t count;
-            sessions_in >> count;
-            sessions_in.ignore(); // Skip newline
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::load_all_data");
+
+        // Finish (or discard) a save that was interrupted by a crash
+        CommitBatch::recover(commit_log_file);
+
+        // Load detailed sessions - single pass over one buffer, no per-field allocation
+        load_report = text_parser::ParseReport();
+
+        std::string buffer;
+        if (text_parser::read_file(sessions_file, buffer)) {
+            text_parser::LineCursor lines(buffer);
+            text_parser::TextSpan line;
 
             detailed_sessions.clear();
-            detailed_sessions.reserve(count);
-
-            std::string line;
-            while (std::getline(sessions_in, line) && !line.empty()) {
-                std::istringstream ss(line);
-                std::string token;
-                std::vector<std::string> tokens;
-
-                // Parse CSV with quoted strings
-                bool in_quotes = false;
-                std::string current_token;
-
-                for (char c : line) {
-                    if (c == '"') {
-                        in_quotes = !in_quotes;
-                    } else if (c == ',' && !in_quotes) {
-                        tokens.push_back(current_token);
-                        current_token.clear();
-                    } else {
-                        current_token += c;
-                    }
-                }
-                tokens.push_back(current_token);
-
-                if (tokens.size() >= 9) {
-                    DetailedSleepSession session;
-
-                    std::time_t start_t = static_cast<std::time_t>(std::stoll(tokens[0]));
-                    std::time_t end_t = static_cast<std::time_t>(std::stoll(tokens[1]));
-
-                    session.sleep_start = std::chrono::system_clock::from_time_t(start_t);
-                    session.wake_up = std::chrono::system_clock::from_time_t(end_t);
-                    session.total_sleep_duration = std::chrono::duration_cast<Duration>(
-                            session.wake_up - session.sleep_start);
-                    session.time_in_bed = session.total_sleep_duration;
-                    session.sleep_efficiency = std::stod(tokens[2]);
-                    session.perceived_quality = static_cast<SleepQuality>(std::stoi(tokens[3]));
-                    session.is_nap = (tokens[4] == "1");
-                    session.awakenings_count = std::stoi(tokens[5]);
-                    session.room_temperature = std::stod(tokens[6]);
-                    session.noise_level = std::stoi(tokens[7]);
-                    session.light_level = std::stoi(tokens[8]);
-                    if (tokens.size() > 9) {
-                        session.notes = tokens[9];
-                        // Remove quotes if present
-                        if (session.notes.front() == '"' && session.notes.back() == '"') {
-                            session.notes = session.notes.substr(1, session.notes.length() - 2);
-                        }
-                    }
-                    session.is_complete = true;
 
+            // Header line holds the session count
+            int64_t count = 0;
+            if (lines.next(line) && text_parser::parse_int64(line, count) && count > 0) {
+                detailed_sessions.reserve(static_cast<size_t>(count));
+            }
+
+            while (lines.next(line) && !line.empty()) {
+                load_report.lines_read++;
+
+                DetailedSleepSession session;
+                if (parse_session_line(line, session, load_report)) {
                     detailed_sessions.push_back(session);
+                } else {
+                    load_report.note_malformed(lines.line_number());
                 }
             }
-            sessions_in.close();
+
+            // Files written before the index existed may be out of order
+            restore_time_order();
         }
+        load_metric_sketches();
 
         // Load user goals
         std::ifstream goals_in(goals_file);
@@ -663,12 +727,12 @@ namespace descansa {
             goals_in >> target_duration >> bedtime_hour >> wake_hour
                      >> target_efficiency >> weekend_differs >> weekend_extension;
 
-            user_goals.target_sleep_duration = Duration(target_duration);
+            user_goals.target_sleep_duration = Duration(std::llround(target_duration));
             user_goals.preferred_bedtime = std::chrono::hours(bedtime_hour);
             user_goals.preferred_wake_time = std::chrono::hours(wake_hour);
             user_goals.target_sleep_efficiency = target_efficiency;
             user_goals.weekend_schedule_differs = (weekend_differs == 1);
-            user_goals.weekend_sleep_extension = Duration(weekend_extension);
+            user_goals.weekend_sleep_extension = Duration(std::llround(weekend_extension));
 
             goals_in.close();
         }
@@ -677,20 +741,83 @@ namespace descansa {
     }
 
 // Helper method implementations
-    void DescansaCoreManager::update_daily_summary(const DetailedSleepSession& session) {
-        // Find or create daily summary for this session's date
-        DailySleepSummary* summary = nullptr;
+    void DescansaCoreManager::write_session_line(std::ostream& out, const DetailedSleepSession& session) const {
+        out << to_epoch_seconds(session.sleep_start) << "," << to_epoch_seconds(session.wake_up) << ","
+            << session.sleep_efficiency << "," << static_cast<int>(session.perceived_quality) << ","
+            << (session.is_nap ? "1" : "0") << "," << session.awakenings_count << ","
+            << session.room_temperature << "," << session.noise_level << ","
+            << session.light_level << ",\"" << session.notes << "\"";
+
+        // Run-length encoded stages, only for sessions that have them
+        if (!session.hypnogram.empty()) {
+            out << ",";
+            session.hypnogram.write(out);
+        }
+        out << "\n";
+    }
 
-        for (auto& existing_summary : daily_summaries) {
-            if (is_same_calendar_day(existing_summary.date, session.wake_up)) {
-                summary = &existing_summary;
-                break;
+    bool DescansaCoreManager::parse_session_line(const text_parser::TextSpan& line,
+                                                 DetailedSleepSession& session,
+                                                 text_parser::ParseReport& report) const {
+        // start,end,efficiency,quality,is_nap,awakenings,temperature,noise,light[,"notes"[,hypnogram]]
+        text_parser::FieldCursor fields(line);
+        text_parser::TextSpan tokens[11];
+        size_t token_count = 0;
+        while (token_count < 11 && fields.next(tokens[token_count])) {
+            token_count++;
+        }
+        if (token_count < 9) return false;
+
+        int64_t start_t = 0, end_t = 0;
+        int quality = 0;
+        if (!text_parser::parse_int64(tokens[0], start_t) ||
+            !text_parser::parse_int64(tokens[1], end_t) ||
+            !text_parser::parse_double(tokens[2], session.sleep_efficiency) ||
+            !text_parser::parse_int(tokens[3], quality) ||
+            !text_parser::parse_int(tokens[5], session.awakenings_count) ||
+            !text_parser::parse_double(tokens[6], session.room_temperature) ||
+            !text_parser::parse_int(tokens[7], session.noise_level) ||
+            !text_parser::parse_int(tokens[8], session.light_level)) {
+            return false;
+        }
+
+        session.sleep_start = from_epoch_seconds(start_t);
+        session.wake_up = from_epoch_seconds(end_t);
+        session.time_in_bed = session.wake_up - session.sleep_start;
+        session.total_sleep_duration = session.time_in_bed;
+        session.perceived_quality = static_cast<SleepQuality>(quality);
+        session.is_nap = tokens[4].equals("1");
+        if (token_count > 9) {
+            session.notes.assign(tokens[9].begin, tokens[9].end); // Quotes already stripped
+        }
+        if (token_count > 10) {
+            // Stages are optional detail - a damaged field costs the stages, not the session
+            if (session.hypnogram.read(tokens[10])) {
+                session.update_stage_durations();
+                session.update_sleep_duration();    // As apply_session_totals set it
+            } else {
+                session.hypnogram.clear();
+                report.note_dropped_field();
             }
         }
+        session.is_complete = true;
+        return true;
+    }
+
+    void DescansaCoreManager::update_daily_summary(const DetailedSleepSession& session) {
+        // Find or create daily summary for this session's date
+        int64_t day = LocalDayIndex::day_of(session.wake_up);
+        size_t row = 0;
+        DailySleepSummary* summary = nullptr;
 
-        if (!summary) {
-            daily_summaries.emplace_back(session.wake_up);
-            summary = &daily_summaries.back();
+        invalidate_week_of(day);
+        if (summary_days.find(day, row)) {
+            summary = &daily_summaries[row];
+        } else {
+            row = summary_days.insertion_row(day);
+            auto position = daily_summaries.begin() + static_cast<std::ptrdiff_t>(row);
+            summary = &*daily_summaries.insert(position, DailySleepSummary(session.wake_up));
+            summary_days.insert(row, day);
         }
 
         // Update summary with session data
@@ -709,13 +836,93 @@ namespace descansa {
         }
     }
 
-    bool DescansaCoreManager::is_same_calendar_day(const TimePoint& t1, const TimePoint& t2) const {
-        auto time1 = std::chrono::system_clock::to_time_t(t1);
-        auto time2 = std::chrono::system_clock::to_time_t(t2);
-        auto tm1 = *std::localtime(&time1);
-        auto tm2 = *std::localtime(&time2);
+    void DescansaCoreManager::insert_session_ordered(const DetailedSleepSession& session) {
+        // Sessions normally arrive in wake order - appending keeps the invariant
+        if (detailed_sessions.empty() || !(session.wake_up < detailed_sessions.back().wake_up)) {
+            detailed_sessions.push_back(session);
+            session_columns.insert(session_columns.size(), session);
+            if (!metric_sketches_stale) metric_sketches.add(session);
+            return;
+        }
+
+        auto position = std::upper_bound(detailed_sessions.begin(), detailed_sessions.end(),
+                                         session.wake_up, WakeTimeOrder());
+        size_t row = static_cast<size_t>(position - detailed_sessions.begin());
+        detailed_sessions.insert(position, session);
+        session_columns.insert(row, session);
+        if (!metric_sketches_stale) metric_sketches.add(session);   // Order doesn't matter to a sketch
+    }
 
-        return (tm1.tm_year == tm2.tm_year && tm1.tm_yday == tm2.tm_yday);
+    void DescansaCoreManager::load_metric_sketches() {
+        // The saved sketches are only trusted if they cover exactly the loaded sessions
+        uint64_t tracked = static_cast<uint64_t>(std::count_if(detailed_sessions.begin(), detailed_sessions.end(),
+                                                               SleepMetricSketches::tracks));
+        std::ifstream in(sketches_file);
+        metric_sketches_stale = false;
+        if (in.is_open() && metric_sketches.read(in) && metric_sketches.sessions() == tracked) {
+            return;
+        }
+        metric_sketches.assign(detailed_sessions);
+    }
+
+    const SleepMetricSketches& DescansaCoreManager::fresh_metric_sketches() const {
+        if (metric_sketches_stale) {
+            metric_sketches.assign(detailed_sessions);
+            metric_sketches_stale = false;
+        }
+        return metric_sketches;
+    }
+
+    void DescansaCoreManager::restore_time_order() {
+        if (!std::is_sorted(detailed_sessions.begin(), detailed_sessions.end(), WakeTimeOrder())) {
+            std::stable_sort(detailed_sessions.begin(), detailed_sessions.end(), WakeTimeOrder());
+        }
+        session_columns.assign(detailed_sessions);  // Mirror follows the final order
+        if (!std::is_sorted(daily_summaries.begin(), daily_summaries.end(), SummaryDateOrder())) {
+            std::stable_sort(daily_summaries.begin(), daily_summaries.end(), SummaryDateOrder());
+        }
+        summary_days.assign(daily_summaries);
+        weekly_pattern_cache.clear();
+    }
+
+    bool DescansaCoreManager::is_time_ordered() const {
+        return std::is_sorted(detailed_sessions.begin(), detailed_sessions.end(), WakeTimeOrder()) &&
+               std::is_sorted(daily_summaries.begin(), daily_summaries.end(), SummaryDateOrder());
+    }
+
+    std::pair<DescansaCoreManager::SessionIterator, DescansaCoreManager::SessionIterator>
+    DescansaCoreManager::sessions_waking_between(const TimePoint& start, const TimePoint& end) const {
+        // Inclusive at both ends: start <= wake_up <= end
+        auto first = std::lower_bound(detailed_sessions.begin(), detailed_sessions.end(), start, WakeTimeOrder());
+        auto last = std::upper_bound(first, detailed_sessions.end(), end, WakeTimeOrder());
+        return std::make_pair(first, last);
+    }
+
+    std::pair<DescansaCoreManager::SummaryIterator, DescansaCoreManager::SummaryIterator>
+    DescansaCoreManager::summaries_between(const TimePoint& start, const TimePoint& end) const {
+        // Inclusive at both ends: start <= date <= end
+        auto first = std::lower_bound(daily_summaries.begin(), daily_summaries.end(), start, SummaryDateOrder());
+        auto last = std::upper_bound(first, daily_summaries.end(), end, SummaryDateOrder());
+        return std::make_pair(first, last);
+    }
+
+    DailySleepSummary* DescansaCoreManager::find_daily_summary(const TimePoint& time) {
+        // One zone conversion for the key, then a slot lookup. Callers edit the
+        // summary, so its week's cached pattern goes stale.
+        int64_t day = LocalDayIndex::day_of(time);
+        size_t row = 0;
+        if (!summary_days.find(day, row)) return nullptr;
+
+        invalidate_week_of(day);
+        return &daily_summaries[row];
+    }
+
+    TimePoint DescansaCoreManager::get_day_start(const TimePoint& tp) const {
+        return utils::start_of_day(tp);
+    }
+
+    bool DescansaCoreManager::is_same_calendar_day(const TimePoint& t1, const TimePoint& t2) const {
+        return civil::local_day(civil::to_seconds(t1)) == civil::local_day(civil::to_seconds(t2));
     }
 
 // Additional missing implementations for completeness
@@ -737,33 +944,28 @@ namespace descansa {
     }
 
     SleepStatistics DescansaCoreManager::calculate_statistics(const TimePoint& start, const TimePoint& end) const {
-        std::vector<DetailedSleepSession> range_sessions;
-        for (const auto& session : detailed_sessions) {
-            if (session.wake_up >= start && session.wake_up <= end && session.is_complete) {
-                range_sessions.push_back(session);
-            }
-        }
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::calculate_statistics");
+
+        // Statistics stream the columnar mirror; no session is copied
+        auto rows = session_columns.rows_waking_between(civil::to_seconds(start), civil::to_seconds(end));
 
         SleepStatistics stats;
         stats.analysis_period_start = start;
         stats.analysis_period_end = end;
-        stats.calculate_from_sessions(range_sessions);
+        stats.calculate_from_columns(session_columns, rows.first, rows.second);
 
         // Get daily summaries for trend analysis
-        std::vector<DailySleepSummary> range_summaries;
-        for (const auto& summary : daily_summaries) {
-            if (summary.date >= start && summary.date <= end) {
-                range_summaries.push_back(summary);
-            }
-        }
-        stats.calculate_trends(range_summaries);
+        auto summary_range = summaries_between(start, end);
+        stats.calculate_trends(ConstSpan<DailySleepSummary>(
+                daily_summaries.data() + (summary_range.first - daily_summaries.begin()),
+                static_cast<size_t>(summary_range.second - summary_range.first)));
 
         return stats;
     }
 
     SleepStatistics DescansaCoreManager::calculate_recent_statistics(int days) const {
-        TimePoint cutoff = std::chrono::system_clock::now() - std::chrono::hours(24 * days);
-        TimePoint now = std::chrono::system_clock::now();
+        TimePoint cutoff = system_now() - std::chrono::hours(24 * days);
+        TimePoint now = system_now();
         return calculate_statistics(cutoff, now);
     }
 
@@ -779,7 +981,17 @@ namespace descansa {
         return total_adherence / recent_summaries.size();
     }
 
+    double DescansaCoreManager::get_metric_percentile(SleepMetric metric, double value) const {
+        return fresh_metric_sketches().sketch(metric).rank(value) * 100.0;
+    }
+
+    double DescansaCoreManager::get_metric_quantile(SleepMetric metric, double fraction) const {
+        return fresh_metric_sketches().sketch(metric).quantile(fraction);
+    }
+
     std::vector<std::string> DescansaCoreManager::identify_sleep_patterns() const {
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::identify_sleep_patterns");
+
         std::vector<std::string> patterns;
 
         if (detailed_sessions.size() < 7) {
@@ -787,14 +999,20 @@ namespace descansa {
             return patterns;
         }
 
-        auto recent_sessions = get_sessions(14); // Last 2 weeks
+        // Last 2 weeks, read straight from the columns
+        size_t recent_count = std::min(session_columns.size(), size_t(14));
+        size_t first = session_columns.size() - recent_count;
 
-        // Analyze bedtime consistency
-        std::vector<int> bedtime_hours;
-        for (const auto& session : recent_sessions) {
-            auto time_t = std::chrono::system_clock::to_time_t(session.sleep_start);
-            auto tm = *std::localtime(&time_t);
-            bedtime_hours.push_back(tm.tm_hour);
+        // Analyze bedtime consistency - all bedtimes resolved in one batch,
+        // into buffers from the thread's arena
+        ScratchScope scratch;
+        ScratchVector<civil::LocalTime> local_bedtimes(recent_count, civil::LocalTime(),
+                                                       scratch.allocator<civil::LocalTime>());
+        civil::to_local_batch(session_columns.sleep_starts() + first, recent_count, local_bedtimes.data());
+
+        ScratchVector<int> bedtime_hours = scratch.vector<int>(recent_count);
+        for (const auto& bedtime : local_bedtimes) {
+            bedtime_hours.push_back(bedtime.hour());
         }
 
         auto minmax = std::minmax_element(bedtime_hours.begin(), bedtime_hours.end());
@@ -809,11 +1027,12 @@ namespace descansa {
         }
 
         // Analyze sleep duration patterns
-        double avg_duration = 0;
-        for (const auto& session : recent_sessions) {
-            avg_duration += session.total_sleep_duration.count() / 3600.0;
+        const int64_t* durations = session_columns.durations();
+        int64_t total_seconds = 0;
+        for (size_t row = first; row < session_columns.size(); ++row) {
+            total_seconds += durations[row];
         }
-        avg_duration /= recent_sessions.size();
+        double avg_duration = total_seconds / 3600.0 / recent_count;
 
         if (avg_duration < 7.0) {
             patterns.push_back("Chronic sleep restriction pattern detected");
@@ -830,7 +1049,6 @@ namespace descansa {
         std::vector<std::string> suggestions;
 
         auto recent_stats = calculate_recent_statistics(14);
-        auto recent_summaries = get_recent_summaries(7);
 
         // Sleep duration suggestions
         if (recent_stats.average_sleep_duration.count() < user_goals.target_sleep_duration.count()) {
@@ -888,16 +1106,12 @@ namespace descansa {
         if (debt.count() <= 0) return suggestions;
 
         // Suggest earlier bedtime for next few days
-        TimePoint tonight = std::chrono::system_clock::now();
-        auto tonight_t = std::chrono::system_clock::to_time_t(tonight);
-        auto tonight_tm = *std::localtime(&tonight_t);
+        TimePoint tonight = system_now();
 
         // Set to today's preferred bedtime
-        tonight_tm.tm_hour = static_cast<int>(user_goals.preferred_bedtime.count());
-        tonight_tm.tm_min = 0;
-        tonight_tm.tm_sec = 0;
-
-        TimePoint normal_bedtime = std::chrono::system_clock::from_time_t(std::mktime(&tonight_tm));
+        int64_t today = civil::local_day(civil::to_seconds(tonight));
+        TimePoint normal_bedtime = civil::from_seconds(civil::from_local(
+                today, static_cast<int32_t>(user_goals.preferred_bedtime.count() * 3600)));
 
         // If it's already past bedtime, start from tomorrow
         if (normal_bedtime <= tonight) {
@@ -921,12 +1135,14 @@ namespace descansa {
     }
 
     bool DescansaCoreManager::export_detailed_data(const std::string& export_path) const {
+        DESCANSA_TRACE_SCOPE("DescansaCoreManager::export_detailed_data");
+
         std::ofstream file(export_path);
         if (!file.is_open()) return false;
 
         auto now = std::time(nullptr);
         file << "Descansa Detailed Sleep Data Export\n";
-        file << "Generated: " << std::put_time(std::localtime(&now), "%Y-%m-%d %H:%M:%S") << "\n\n";
+        file << "Generated: " << civil::format_date_time(now) << "\n\n";
 
         file << "Sleep Goals:\n";
         file << "Target Sleep Duration: " << (user_goals.target_sleep_duration.count() / 3600.0) << " hours\n";
@@ -939,12 +1155,12 @@ namespace descansa {
 
         for (const auto& session : detailed_sessions) {
             if (session.is_complete) {
-                auto start_time_t = std::chrono::system_clock::to_time_t(session.sleep_start);
-                auto end_time_t = std::chrono::system_clock::to_time_t(session.wake_up);
+                int64_t start_seconds = civil::to_seconds(session.sleep_start);
+                int64_t end_seconds = civil::to_seconds(session.wake_up);
 
-                file << std::put_time(std::localtime(&start_time_t), "%Y-%m-%d") << ","
-                     << std::put_time(std::localtime(&start_time_t), "%H:%M:%S") << ","
-                     << std::put_time(std::localtime(&end_time_t), "%H:%M:%S") << ","
+                file << civil::format_date(start_seconds) << ","
+                     << civil::format_clock(start_seconds) << ","
+                     << civil::format_clock(end_seconds) << ","
                      << std::fixed << std::setprecision(2) << (session.total_sleep_duration.count() / 3600.0) << ","
                      << std::setprecision(1) << session.sleep_efficiency << ","
                      << session.get_quality_description() << ","
@@ -958,37 +1174,54 @@ namespace descansa {
 
     void DescansaCoreManager::clear_all_data() {
         detailed_sessions.clear();
+        session_columns.clear();
+        metric_sketches.clear();
+        metric_sketches_stale = false;
         daily_summaries.clear();
-        weekly_patterns.clear();
+        summary_days.clear();
+        weekly_pattern_cache.clear();
         enhanced_session_active = false;
         basic_core->clear_history();
     }
 
     void DescansaCoreManager::clear_old_data(int days_to_keep) {
-        TimePoint cutoff = std::chrono::system_clock::now() - std::chrono::hours(24 * days_to_keep);
-
-        // Remove old sessions
-        detailed_sessions.erase(
-                std::remove_if(detailed_sessions.begin(), detailed_sessions.end(),
-                               [cutoff](const DetailedSleepSession& session) {
-                                   return session.wake_up < cutoff;
-                               }),
-                detailed_sessions.end()
-        );
-
-        // Remove old summaries
-        daily_summaries.erase(
-                std::remove_if(daily_summaries.begin(), daily_summaries.end(),
-                               [cutoff](const DailySleepSummary& summary) {
-                                   return summary.date < cutoff;
-                               }),
-                daily_summaries.end()
-        );
+        TimePoint cutoff = system_now() - std::chrono::hours(24 * days_to_keep);
+
+        // Old entries are always a prefix of the time-ordered vectors
+        auto kept = std::lower_bound(detailed_sessions.begin(), detailed_sessions.end(), cutoff, WakeTimeOrder());
+        session_columns.erase_front(static_cast<size_t>(kept - detailed_sessions.begin()));
+        if (std::any_of(detailed_sessions.begin(), kept, SleepMetricSketches::tracks)) metric_sketches_stale = true;
+        detailed_sessions.erase(detailed_sessions.begin(), kept);
+
+        auto kept_summaries = std::lower_bound(daily_summaries.begin(), daily_summaries.end(), cutoff, SummaryDateOrder());
+        size_t pruned = static_cast<size_t>(kept_summaries - daily_summaries.begin());
+        if (pruned > 0) {
+            // Every week up to the last pruned day lost summaries
+            weekly_pattern_cache.erase(weekly_pattern_cache.begin(),
+                                       weekly_pattern_cache.upper_bound(week_of(summary_days.day_at(pruned - 1))));
+        }
+        summary_days.erase_front(pruned);
+        daily_summaries.erase(daily_summaries.begin(), kept_summaries);
     }
 
     bool DescansaCoreManager::validate_data_integrity() const {
         // Check for data consistency issues
 
+        // Range queries rely on the time-ordered index invariant
+        if (!is_time_ordered()) {
+            return false;
+        }
+
+        // Analytics read the columnar mirror instead of the sessions
+        if (!session_columns.mirrors(detailed_sessions)) {
+            return false;
+        }
+
+        // Day lookups go through the summary index
+        if (!summary_days.mirrors(daily_summaries)) {
+            return false;
+        }
+
         // Verify sessions have valid timestamps
         for (const auto& session : detailed_sessions) {
             if (session.sleep_start >= session.wake_up && session.is_complete) {
@@ -1012,13 +1245,13 @@ namespace descansa {
         status << "Session Status: " << (enhanced_session_active ? "Active" : "Inactive") << "\n";
         status << "Total Sessions: " << detailed_sessions.size() << "\n";
         status << "Daily Summaries: " << daily_summaries.size() << "\n";
-        status << "Weekly Patterns: " << weekly_patterns.size() << "\n\n";
+        status << "Weekly Patterns: " << weekly_pattern_cache.size() << " cached\n\n";
 
         if (enhanced_session_active) {
-            auto preview = get_current_session_preview();
+            Duration elapsed = std::chrono::duration_cast<Duration>(system_now() - current_session.sleep_start);
             status << "Current Session Duration: "
                    << std::fixed << std::setprecision(1)
-                   << (preview.total_sleep_duration.count() / 3600.0) << " hours\n";
+                   << (elapsed.count() / 3600.0) << " hours\n";
         }
 
         status << "Goal Adherence: " << std::setprecision(1)
@@ -1036,7 +1269,7 @@ namespace descansa {
 
     void DescansaCoreManager::sync_with_basic_core() {
         // Sync goals
-        basic_core->set_target_sleep_hours(user_goals.target_sleep_duration.count() / 3600.0);
+        basic_core->set_target_sleep_hours(to_hours(user_goals.target_sleep_duration));
         basic_core->set_target_wake_time(
                 static_cast<int>(user_goals.preferred_wake_time.count()), 0);
 
@@ -1048,6 +1281,33 @@ namespace descansa {
         }
     }
 
+    void DescansaCoreManager::persist_all_data() {
+        if (dirty_callback) {
+            save_pending = true;
+            dirty_callback();
+            return;
+        }
+        save_all_data();
+    }
+
+    void DescansaCoreManager::set_dirty_callback(std::function<void()> callback) {
+        dirty_callback = callback;
+        basic_core->set_dirty_callback(std::move(callback));
+    }
+
+    bool DescansaCoreManager::flush_pending() {
+        bool ok = basic_core->flush_pending();
+
+        if (save_pending) {
+            if (save_all_data()) {
+                save_pending = false;
+            } else {
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
     void DescansaCoreManager::set_session_completed_callback(std::function<void(const DetailedSleepSession&)> callback) {
         session_completed_callback = std::move(callback);
     }
@@ -1057,23 +1317,9 @@ namespace descansa {
     }
 
     std::vector<SleepPhase> DescansaCoreManager::detect_sleep_phases() const {
-        // Placeholder for future sensor integration
-        std::vector<SleepPhase> phases;
-
-        if (enhanced_session_active) {
-            Duration elapsed = std::chrono::duration_cast<Duration>(
-                    std::chrono::system_clock::now() - current_session.sleep_start);
-
-            if (elapsed.count() > 1800) { // 30 minutes
-                phases.emplace_back(current_session.sleep_start, Duration(1800), "light");
-            }
-            if (elapsed.count() > 3600) { // 1 hour
-                phases.emplace_back(current_session.sleep_start + std::chrono::seconds(1800),
-                                    Duration(1800), "deep");
-            }
-        }
-
-        return phases;
+        // Scored from accelerometer epochs (see record_activity_epoch); empty without sensor data
+        if (!enhanced_session_active) return std::vector<SleepPhase>();
+        return current_session.get_sleep_phases();
     }
 
     void DescansaCoreManager::calibrate_sleep_detection() {
@@ -1143,8 +1389,12 @@ namespace descansa {
 
         // Clear existing data
         detailed_sessions.clear();
+        session_columns.clear();
+        metric_sketches.clear();
+        metric_sketches_stale = false;
         daily_summaries.clear();
-        weekly_patterns.clear();
+        summary_days.clear();
+        weekly_pattern_cache.clear();
 
         while (std::getline(backup, line)) {
             if (line.empty() || line[0] == '#') continue;
@@ -1161,7 +1411,7 @@ namespace descansa {
                     std::string value = line.substr(eq_pos + 1);
 
                     if (key == "target_sleep_duration") {
-                        user_goals.target_sleep_duration = Duration(std::stod(value));
+                        user_goals.target_sleep_duration = Duration(std::llround(std::stod(value)));
                     } else if (key == "preferred_bedtime") {
                         user_goals.preferred_bedtime = std::chrono::hours(std::stoi(value));
                     } else if (key == "preferred_wake_time") {
@@ -1171,7 +1421,7 @@ namespace descansa {
                     } else if (key == "weekend_schedule_differs") {
                         user_goals.weekend_schedule_differs = (value == "1");
                     } else if (key == "weekend_sleep_extension") {
-                        user_goals.weekend_sleep_extension = Duration(std::stod(value));
+                        user_goals.weekend_sleep_extension = Duration(std::llround(std::stod(value)));
                     }
                 }
             }
@@ -1180,4 +1430,22 @@ namespace descansa {
         return true;
     }
 
+// Sleep metrics
+    namespace sleep_metrics {
+
+        double calculate_sleep_efficiency_percentile(double efficiency,
+                                                     const std::vector<DetailedSleepSession>& reference_data) {
+            // One-off queries are an exact count; DescansaCoreManager::get_metric_percentile
+            // serves repeated queries over the user's own history from a sketch
+            size_t reference = 0, at_or_below = 0;
+            for (const auto& session : reference_data) {
+                if (!SleepMetricSketches::tracks(session)) continue;
+                ++reference;
+                if (session.sleep_efficiency <= efficiency) ++at_or_below;
+            }
+            return reference > 0 ? 100.0 * at_or_below / reference : 0.0;
+        }
+
+    } // namespace sleep_metrics
+
 } // namespace descansa
\ No newline at end of file
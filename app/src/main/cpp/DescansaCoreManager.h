@@ -2,9 +2,18 @@
 #define DESCANSA_CORE_MANAGER_H
 
 #include "DescansaCore.h"
+#include "ConstSpan.h"
+#include "DetailedSessionColumns.h"
+#include "LocalDayIndex.h"
+#include "SensorPipeline.h"
 #include "SleepDataStructures.h"
+#include "SleepMetricSketches.h"
+#include "SleepWakeScorer.h"
+#include "TextDataParser.h"
 #include <memory>
 #include <functional>
+#include <map>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -15,10 +24,21 @@ namespace descansa {
     private:
         std::unique_ptr<DescansaCore> basic_core;
 
-        // Enhanced data storage
+        // Enhanced data storage - both kept time-ordered (sessions by wake_up,
+        // summaries by date) so range queries are binary searches
         std::vector<DetailedSleepSession> detailed_sessions;
+        DetailedSessionColumns session_columns;     // mirrors detailed_sessions row for row
+        // Percentile reference over the main sleeps. Edits that change a tracked
+        // value only mark it stale; the next query rebuilds it once.
+        mutable SleepMetricSketches metric_sketches;
+        mutable bool metric_sketches_stale;
         std::vector<DailySleepSummary> daily_summaries;
-        std::vector<WeeklySleepPattern> weekly_patterns;
+        LocalDayIndex summary_days;                 // local day of each summary, O(1) lookup
+
+        // Weekly patterns materialized on first query, keyed by the local day
+        // number of the week's Monday; an entry is dropped when a summary in
+        // its week changes, so repeat queries neither copy nor re-analyze
+        mutable std::map<int64_t, WeeklySleepPattern> weekly_pattern_cache;
         SleepGoals user_goals;
         SleepEnvironment current_environment;
 
@@ -33,18 +53,57 @@ namespace descansa {
         std::string summaries_file;
         std::string goals_file;
         std::string environment_file;
+        std::string sketches_file;
+        std::string commit_log_file;    // intent log of an in-flight multi-file save
+        text_parser::ParseReport load_report;
 
         // Analytics and callbacks
         std::function<void(const DetailedSleepSession&)> session_completed_callback;
         std::function<void(const DailySleepSummary&)> daily_summary_callback;
 
+        // Deferred persistence (see set_dirty_callback)
+        std::function<void()> dirty_callback;
+        bool save_pending;
+
+        // Accelerometer ingestion. The pipeline's consumer thread parks finished
+        // epochs in sensor_epochs; they are scored into current_session on the
+        // manager's own thread. The pipeline is declared last so it stops first.
+        SleepWakeScorer sleep_scorer;
+        SleepWakeSummary applied_sleep_summary;     // scorer totals already in current_session
+        std::mutex sensor_epoch_mutex;
+        std::vector<ActivityEpoch> sensor_epochs;
+        SensorPipeline sensor_pipeline;
+
         // Helper methods
+        void persist_all_data();
+        void apply_session_totals(DetailedSleepSession& session, const TimePoint& until) const;
         void update_daily_summary(const DetailedSleepSession& session);
         void update_weekly_patterns();
+        const WeeklySleepPattern& weekly_pattern_for_week(int64_t first_day) const;
+        void invalidate_week_of(int64_t day);
+        static int64_t week_of(int64_t day);
         void analyze_sleep_trends();
         void generate_recommendations();
         TimePoint get_day_start(const TimePoint& tp) const;
         bool is_same_calendar_day(const TimePoint& t1, const TimePoint& t2) const;
+        void write_session_line(std::ostream& out, const DetailedSleepSession& session) const;
+        bool parse_session_line(const text_parser::TextSpan& line, DetailedSleepSession& session,
+                                text_parser::ParseReport& report) const;
+
+        // Time-ordered index helpers
+        typedef std::vector<DetailedSleepSession>::const_iterator SessionIterator;
+        typedef std::vector<DailySleepSummary>::const_iterator SummaryIterator;
+
+        void insert_session_ordered(const DetailedSleepSession& session);
+        void restore_time_order();
+        void load_metric_sketches();
+        const SleepMetricSketches& fresh_metric_sketches() const;
+        bool is_time_ordered() const;
+        std::pair<SessionIterator, SessionIterator> sessions_waking_between(const TimePoint& start,
+                                                                           const TimePoint& end) const;
+        std::pair<SummaryIterator, SummaryIterator> summaries_between(const TimePoint& start,
+                                                                      const TimePoint& end) const;
+        DailySleepSummary* find_daily_summary(const TimePoint& time);
 
     public:
         explicit DescansaCoreManager(const std::string& data_dir = "");
@@ -62,6 +121,17 @@ namespace descansa {
         void add_awakening(const TimePoint& time, const Duration& duration);
         void set_sleep_quality(SleepQuality quality);
         void add_session_note(const std::string& note);
+        void set_sleep_phases(const std::vector<SleepPhase>& phases);   // Stored as the session's hypnogram
+
+        // Sensor thread entry point: queues a batch of accelerometer samples
+        // without blocking while a session is active and returns how many were
+        // taken (the rest were dropped). Scored epochs reach the session when
+        // process_sensor_data() runs: on every get_current_session_preview()
+        // and when the session ends.
+        size_t push_accelerometer_samples(const AccelerometerSample* samples, size_t count);
+        void process_sensor_data();
+        void record_activity_epoch(const ActivityEpoch& epoch);
+        uint64_t get_dropped_sensor_samples() const { return sensor_pipeline.get_dropped_samples(); }
         void mark_as_nap(bool is_nap = true);
 
         // Pre-sleep factor tracking
@@ -78,16 +148,34 @@ namespace descansa {
         void update_preferred_schedule(std::chrono::hours bedtime, std::chrono::hours wake_time);
         void set_weekend_flexibility(bool allow_flexibility, const Duration& extension = Duration(0));
 
-        // Data retrieval and analysis
-        std::vector<DetailedSleepSession> get_sessions(int count = -1) const;
-        std::vector<DetailedSleepSession> get_sessions_in_range(const TimePoint& start, const TimePoint& end) const;
+        // Data retrieval and analysis. Spans point into the manager's own
+        // storage: they copy nothing and stay valid until the next call that
+        // adds, edits or removes sessions or summaries (ending or editing a
+        // session, recording meals/caffeine, clearing, pruning, loading).
+        ConstSpan<DetailedSleepSession> get_sessions(int count = -1) const;     // the last count, oldest first
+        const DetailedSessionColumns& get_session_columns() const { return session_columns; }
+        ConstSpan<DetailedSleepSession> get_sessions_waking_in_range(const TimePoint& start,
+                                                                     const TimePoint& end) const;  // may have started before start
         DailySleepSummary get_daily_summary(const TimePoint& date) const;
-        std::vector<DailySleepSummary> get_recent_summaries(int days = 30) const;
-        WeeklySleepPattern get_weekly_pattern(const TimePoint& week_start) const;
-        std::vector<WeeklySleepPattern> get_recent_weekly_patterns(int weeks = 4) const;
+        ConstSpan<DailySleepSummary> get_recent_summaries(int days = 30) const;
+        // The local Monday-Sunday week containing the given time. The reference
+        // stays valid until a summary in that week changes.
+        const WeeklySleepPattern& get_weekly_pattern(const TimePoint& date) const;
+
+        // Visitors for filtered or non-contiguous results; same lifetime rules
+        typedef std::function<void(const DetailedSleepSession&)> SessionVisitor;
+        typedef std::function<void(const WeeklySleepPattern&)> WeeklyPatternVisitor;
+        void for_each_session_in_range(const TimePoint& start, const TimePoint& end,
+                                       const SessionVisitor& visitor) const;    // started and woke inside
+        std::vector<DetailedSleepSession> get_sessions_in_range(const TimePoint& start,
+                                                                const TimePoint& end) const;    // same, as a copy
+        void for_each_recent_weekly_pattern(int weeks, const WeeklyPatternVisitor& visitor) const;  // this week first
 
         // Current status and recommendations
-        DetailedSleepSession get_current_session_preview() const;
+        // The session so far, ended now: asleep time and efficiency come from
+        // its hypnogram - the sleep/wake scorer's output once sensor data has
+        // arrived - as when the session ends. Folds pending sensor epochs first.
+        DetailedSleepSession get_current_session_preview();
         Duration get_enhanced_remaining_work_time() const;
         std::vector<std::string> get_current_recommendations() const;
         std::string get_sleep_score_explanation() const;
@@ -97,6 +185,12 @@ namespace descansa {
         SleepStatistics calculate_statistics(const TimePoint& start, const TimePoint& end) const;
         SleepStatistics calculate_recent_statistics(int days = 30) const;
         double get_goal_adherence_percentage() const;
+
+        // Percentile rank (0-100) of a value among past main sleeps, and the
+        // inverse; answered from sketches in microseconds, within ~1.5% rank
+        double get_metric_percentile(SleepMetric metric, double value) const;
+        double get_metric_quantile(SleepMetric metric, double fraction) const;
+        const SleepMetricSketches& get_metric_sketches() const { return fresh_metric_sketches(); }
         std::vector<std::string> identify_sleep_patterns() const;
         std::vector<std::string> get_improvement_suggestions() const;
 
@@ -119,6 +213,13 @@ namespace descansa {
         void clear_all_data();
         void clear_old_data(int days_to_keep = 365);
         bool validate_data_integrity() const;
+        const text_parser::ParseReport& get_load_report() const { return load_report; }
+
+        // Deferred persistence: with a callback set, mutations mark the manager
+        // (and its basic core) dirty instead of saving; flush_pending() performs
+        // the coalesced write, typically from a PersistenceWorker
+        void set_dirty_callback(std::function<void()> callback);
+        bool flush_pending();
 
         // Event callbacks
         void set_session_completed_callback(std::function<void(const DetailedSleepSession&)> callback);
@@ -129,7 +230,7 @@ namespace descansa {
         void sync_with_basic_core();
 
         // Advanced features
-        std::vector<SleepPhase> detect_sleep_phases() const; // Placeholder for future sensor integration
+        std::vector<SleepPhase> detect_sleep_phases() const; // Active session's phases scored so far
         void calibrate_sleep_detection(); // Auto-tune detection algorithms
         std::vector<std::string> get_environmental_recommendations() const;
         void optimize_schedule_for_goals();
@@ -0,0 +1,139 @@
+// DetailedSessionColumns.cpp - Implementation
+#include "DetailedSessionColumns.h"
+#include <algorithm>
+
+namespace descansa {
+
+    namespace {
+        uint8_t flags_of(const DetailedSleepSession& session) {
+            return static_cast<uint8_t>((session.is_complete ? SESSION_COMPLETE : 0) |
+                                        (session.is_nap ? SESSION_NAP : 0));
+        }
+
+        template <typename T>
+        void insert_at(std::vector<T>& column, size_t row, T value) {
+            column.insert(column.begin() + static_cast<std::ptrdiff_t>(row), value);
+        }
+
+        template <typename T>
+        void erase_prefix(std::vector<T>& column, size_t rows) {
+            column.erase(column.begin(), column.begin() + static_cast<std::ptrdiff_t>(rows));
+        }
+    }
+
+    void DetailedSessionColumns::clear() {
+        sleep_start_column.clear();
+        wake_up_column.clear();
+        duration_column.clear();
+        efficiency_column.clear();
+        quality_column.clear();
+        awakening_column.clear();
+        temperature_column.clear();
+        noise_column.clear();
+        light_column.clear();
+        flag_column.clear();
+    }
+
+    void DetailedSessionColumns::reserve(size_t rows) {
+        sleep_start_column.reserve(rows);
+        wake_up_column.reserve(rows);
+        duration_column.reserve(rows);
+        efficiency_column.reserve(rows);
+        quality_column.reserve(rows);
+        awakening_column.reserve(rows);
+        temperature_column.reserve(rows);
+        noise_column.reserve(rows);
+        light_column.reserve(rows);
+        flag_column.reserve(rows);
+    }
+
+    void DetailedSessionColumns::assign(const std::vector<DetailedSleepSession>& sessions) {
+        clear();
+        reserve(sessions.size());
+        for (const auto& session : sessions) {
+            insert(size(), session);
+        }
+    }
+
+    void DetailedSessionColumns::insert(size_t row, const DetailedSleepSession& session) {
+        if (row >= size()) {
+            sleep_start_column.push_back(to_epoch_seconds(session.sleep_start));
+            wake_up_column.push_back(to_epoch_seconds(session.wake_up));
+            duration_column.push_back(session.total_sleep_duration.count());
+            efficiency_column.push_back(session.sleep_efficiency);
+            quality_column.push_back(static_cast<uint8_t>(session.perceived_quality));
+            awakening_column.push_back(session.awakenings_count);
+            temperature_column.push_back(session.room_temperature);
+            noise_column.push_back(session.noise_level);
+            light_column.push_back(session.light_level);
+            flag_column.push_back(flags_of(session));
+            return;
+        }
+
+        insert_at(sleep_start_column, row, to_epoch_seconds(session.sleep_start));
+        insert_at(wake_up_column, row, to_epoch_seconds(session.wake_up));
+        insert_at(duration_column, row, static_cast<int64_t>(session.total_sleep_duration.count()));
+        insert_at(efficiency_column, row, session.sleep_efficiency);
+        insert_at(quality_column, row, static_cast<uint8_t>(session.perceived_quality));
+        insert_at(awakening_column, row, static_cast<int32_t>(session.awakenings_count));
+        insert_at(temperature_column, row, session.room_temperature);
+        insert_at(noise_column, row, static_cast<int32_t>(session.noise_level));
+        insert_at(light_column, row, static_cast<int32_t>(session.light_level));
+        insert_at(flag_column, row, flags_of(session));
+    }
+
+    void DetailedSessionColumns::update(size_t row, const DetailedSleepSession& session) {
+        if (row >= size()) return;
+
+        sleep_start_column[row] = to_epoch_seconds(session.sleep_start);
+        wake_up_column[row] = to_epoch_seconds(session.wake_up);
+        duration_column[row] = session.total_sleep_duration.count();
+        efficiency_column[row] = session.sleep_efficiency;
+        quality_column[row] = static_cast<uint8_t>(session.perceived_quality);
+        awakening_column[row] = session.awakenings_count;
+        temperature_column[row] = session.room_temperature;
+        noise_column[row] = session.noise_level;
+        light_column[row] = session.light_level;
+        flag_column[row] = flags_of(session);
+    }
+
+    void DetailedSessionColumns::erase_front(size_t rows) {
+        rows = std::min(rows, size());
+        if (rows == 0) return;
+
+        erase_prefix(sleep_start_column, rows);
+        erase_prefix(wake_up_column, rows);
+        erase_prefix(duration_column, rows);
+        erase_prefix(efficiency_column, rows);
+        erase_prefix(quality_column, rows);
+        erase_prefix(awakening_column, rows);
+        erase_prefix(temperature_column, rows);
+        erase_prefix(noise_column, rows);
+        erase_prefix(light_column, rows);
+        erase_prefix(flag_column, rows);
+    }
+
+    std::pair<size_t, size_t> DetailedSessionColumns::rows_waking_between(int64_t start, int64_t end) const {
+        auto first = std::lower_bound(wake_up_column.begin(), wake_up_column.end(), start);
+        auto last = std::upper_bound(first, wake_up_column.end(), end);
+        return std::make_pair(static_cast<size_t>(first - wake_up_column.begin()),
+                              static_cast<size_t>(last - wake_up_column.begin()));
+    }
+
+    bool DetailedSessionColumns::mirrors(const std::vector<DetailedSleepSession>& sessions) const {
+        if (sessions.size() != size()) return false;
+
+        for (size_t row = 0; row < sessions.size(); ++row) {
+            const DetailedSleepSession& session = sessions[row];
+            if (sleep_start_column[row] != to_epoch_seconds(session.sleep_start) ||
+                wake_up_column[row] != to_epoch_seconds(session.wake_up) ||
+                duration_column[row] != session.total_sleep_duration.count() ||
+                quality_column[row] != static_cast<uint8_t>(session.perceived_quality) ||
+                flag_column[row] != flags_of(session)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace descansa
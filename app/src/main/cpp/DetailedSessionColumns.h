@@ -0,0 +1,75 @@
+// DetailedSessionColumns.h - Columnar mirror of the detailed session list for analytics
+#ifndef DETAILED_SESSION_COLUMNS_H
+#define DETAILED_SESSION_COLUMNS_H
+
+#include "SleepDataStructures.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace descansa {
+
+// Per-row bits of the flag column
+    enum SessionFlag : uint8_t {
+        SESSION_COMPLETE = 1,
+        SESSION_NAP = 2
+    };
+
+// Structure-of-arrays copy of the fields the analytics loops read. Row i is
+// session i of the owner's wake-ordered vector; the owner mirrors every
+// insert, erase and in-place edit, so kernels stream a few dense arrays
+// instead of striding over DetailedSleepSession objects (strings, phase
+// vectors and a dozen TimePoints each).
+    class DetailedSessionColumns {
+    private:
+        std::vector<int64_t> sleep_start_column;    // seconds since epoch
+        std::vector<int64_t> wake_up_column;        // seconds since epoch, non-decreasing
+        std::vector<int64_t> duration_column;       // seconds
+        std::vector<double> efficiency_column;      // percent
+        std::vector<uint8_t> quality_column;        // SleepQuality
+        std::vector<int32_t> awakening_column;
+        std::vector<double> temperature_column;     // Celsius
+        std::vector<int32_t> noise_column;          // 0-100
+        std::vector<int32_t> light_column;          // 0-100
+        std::vector<uint8_t> flag_column;           // SessionFlag bits
+
+    public:
+        void clear();
+        void reserve(size_t rows);
+
+        // Rebuild from the owner's vector (after a load or a re-sort)
+        void assign(const std::vector<DetailedSleepSession>& sessions);
+
+        void insert(size_t row, const DetailedSleepSession& session);   // row == size() appends
+        void update(size_t row, const DetailedSleepSession& session);
+        void erase_front(size_t rows);
+
+        size_t size() const { return wake_up_column.size(); }
+        bool empty() const { return wake_up_column.empty(); }
+
+        const int64_t* sleep_starts() const { return sleep_start_column.data(); }
+        const int64_t* wake_ups() const { return wake_up_column.data(); }
+        const int64_t* durations() const { return duration_column.data(); }
+        const double* efficiencies() const { return efficiency_column.data(); }
+        const uint8_t* qualities() const { return quality_column.data(); }
+        const int32_t* awakenings() const { return awakening_column.data(); }
+        const double* temperatures() const { return temperature_column.data(); }
+        const int32_t* noise_levels() const { return noise_column.data(); }
+        const int32_t* light_levels() const { return light_column.data(); }
+        const uint8_t* flags() const { return flag_column.data(); }
+
+        // Complete and not a nap
+        bool is_main_sleep(size_t row) const { return flag_column[row] == SESSION_COMPLETE; }
+        bool is_complete(size_t row) const { return (flag_column[row] & SESSION_COMPLETE) != 0; }
+
+        // Rows [first, last) with start <= wake_up <= end
+        std::pair<size_t, size_t> rows_waking_between(int64_t start, int64_t end) const;
+
+        // Row-for-row agreement with the owner's vector (diagnostics)
+        bool mirrors(const std::vector<DetailedSleepSession>& sessions) const;
+    };
+
+} // namespace descansa
+
+#endif // DETAILED_SESSION_COLUMNS_H
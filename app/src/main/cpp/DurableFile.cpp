@@ -0,0 +1,216 @@
+// DurableFile.cpp - Implementation
+#include "DurableFile.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace descansa {
+
+    namespace {
+
+        std::string temp_path_for(const std::string& path) {
+            return path + ".tmp";
+        }
+
+        std::string parent_directory(const std::string& path) {
+            size_t slash = path.find_last_of('/');
+            if (slash == std::string::npos) return ".";
+            if (slash == 0) return "/";
+            return path.substr(0, slash);
+        }
+
+        bool fsync_retrying(int fd) {
+            while (::fsync(fd) != 0) {
+                if (errno != EINTR) return false;
+            }
+            return true;
+        }
+
+        // Write and fsync path.tmp; the target is untouched
+        bool write_synced_temp(const std::string& path, const std::string& contents) {
+            std::string temp_path = temp_path_for(path);
+
+            int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+            if (fd < 0) return false;
+
+            bool ok = write_fully(fd, contents.data(), contents.size()) && fsync_retrying(fd);
+            ok = (::close(fd) == 0) && ok;
+
+            if (!ok) std::remove(temp_path.c_str());
+            return ok;
+        }
+
+        bool sync_directories_of(const std::vector<std::string>& paths) {
+            std::vector<std::string> directories;
+            for (const auto& path : paths) {
+                std::string directory = parent_directory(path);
+                bool seen = false;
+                for (const auto& existing : directories) {
+                    if (existing == directory) {
+                        seen = true;
+                        break;
+                    }
+                }
+                if (!seen) directories.push_back(directory);
+            }
+
+            bool ok = true;
+            for (const auto& directory : directories) {
+                ok = sync_parent_directory(directory + "/") && ok;
+            }
+            return ok;
+        }
+
+    } // namespace
+
+    bool write_fully(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+
+    bool sync_parent_directory(const std::string& path) {
+        int fd = ::open(parent_directory(path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        bool ok = fsync_retrying(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    bool write_file_durably(const std::string& path, const std::string& contents) {
+        if (!write_synced_temp(path, contents)) return false;
+
+        if (std::rename(temp_path_for(path).c_str(), path.c_str()) != 0) {
+            std::remove(temp_path_for(path).c_str());
+            return false;
+        }
+        return sync_parent_directory(path);
+    }
+
+// CommitBatch Implementation
+    CommitBatch::CommitBatch(const std::string& intent_path) : intent_log_path(intent_path) {}
+
+    void CommitBatch::stage(const std::string& path, std::string contents) {
+        for (auto& file : staged) {
+            if (file.path == path) {
+                file.contents.swap(contents); // Coalesce: the later commit wins
+                return;
+            }
+        }
+
+        StagedFile file;
+        file.path = path;
+        file.contents.swap(contents);
+        staged.push_back(std::move(file));
+    }
+
+    bool CommitBatch::write_intent_log() const {
+        std::ostringstream log;
+        log << "COMMIT:" << staged.size() << "\n";
+        for (const auto& file : staged) {
+            log << "FILE:" << file.path << "\n";
+        }
+        log << "END:" << staged.size() << "\n";
+        return write_file_durably(intent_log_path, log.str());
+    }
+
+    bool CommitBatch::commit() {
+        if (staged.empty()) return true;
+
+        // A single file needs no intent log - the rename is already atomic
+        if (staged.size() == 1) {
+            bool ok = write_file_durably(staged[0].path, staged[0].contents);
+            if (ok) staged.clear();
+            return ok;
+        }
+
+        for (size_t i = 0; i < staged.size(); ++i) {
+            if (!write_synced_temp(staged[i].path, staged[i].contents)) {
+                for (size_t j = 0; j < i; ++j) {
+                    std::remove(temp_path_for(staged[j].path).c_str());
+                }
+                return false;
+            }
+        }
+
+        // Commit point - from here recover() finishes the batch after a crash
+        if (!write_intent_log()) {
+            for (const auto& file : staged) {
+                std::remove(temp_path_for(file.path).c_str());
+            }
+            return false;
+        }
+
+        std::vector<std::string> targets;
+        bool ok = true;
+        for (const auto& file : staged) {
+            ok = std::rename(temp_path_for(file.path).c_str(), file.path.c_str()) == 0 && ok;
+            targets.push_back(file.path);
+        }
+        if (!ok) return false; // Intent log stays; recover() retries the renames
+
+        ok = sync_directories_of(targets);
+        if (ok) {
+            std::remove(intent_log_path.c_str());
+            sync_parent_directory(intent_log_path);
+            staged.clear();
+        }
+        return ok;
+    }
+
+    bool CommitBatch::recover(const std::string& intent_path) {
+        std::ifstream log(intent_path);
+        if (!log.is_open()) return true; // Nothing was in flight
+
+        std::vector<std::string> targets;
+        size_t declared = 0;
+        bool complete = false;
+
+        std::string line;
+        while (std::getline(log, line)) {
+            if (line.find("COMMIT:") == 0) {
+                declared = static_cast<size_t>(std::strtoul(line.c_str() + 7, nullptr, 10));
+            } else if (line.find("FILE:") == 0) {
+                targets.push_back(line.substr(5));
+            } else if (line.find("END:") == 0) {
+                complete = static_cast<size_t>(std::strtoul(line.c_str() + 4, nullptr, 10)) == declared &&
+                           targets.size() == declared;
+            }
+        }
+        log.close();
+
+        bool ok = true;
+        for (const auto& target : targets) {
+            std::string temp_path = temp_path_for(target);
+            std::ifstream probe(temp_path);
+            if (!probe.is_open()) continue; // Already renamed before the crash
+            probe.close();
+
+            if (complete) {
+                ok = std::rename(temp_path.c_str(), target.c_str()) == 0 && ok;
+            } else {
+                std::remove(temp_path.c_str());
+            }
+        }
+
+        if (ok) {
+            ok = sync_directories_of(targets);
+            std::remove(intent_path.c_str());
+            sync_parent_directory(intent_path);
+        }
+        return ok;
+    }
+
+} // namespace descansa
@@ -0,0 +1,56 @@
+// DurableFile.h - Crash-safe file replacement and multi-file group commit
+#ifndef DURABLE_FILE_H
+#define DURABLE_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace descansa {
+
+// Low-level helpers shared with the journal
+    bool write_fully(int fd, const char* data, size_t size);    // retries short writes and EINTR
+    bool sync_parent_directory(const std::string& path);        // makes a create/rename durable
+
+// Replace path with contents: write a temp file, fsync it, rename it over
+// path, fsync the directory. Readers see the old file or the new one, never
+// a truncated mix.
+    bool write_file_durably(const std::string& path, const std::string& contents);
+
+// Several whole-file writes committed as one transaction. Staging the same
+// path twice keeps only the latest contents, so any number of logical
+// commits folded into one batch costs one fsync per distinct file plus one
+// for the intent log and one per directory.
+//
+// Protocol: temps are written and synced, then the intent log listing them
+// is synced (commit point), then temps are renamed over their targets and
+// the intent log is removed. recover() rolls a committed batch forward and
+// discards an uncommitted one.
+    class CommitBatch {
+    private:
+        struct StagedFile {
+            std::string path;
+            std::string contents;
+        };
+
+        std::string intent_log_path;
+        std::vector<StagedFile> staged;
+
+        bool write_intent_log() const;
+
+    public:
+        explicit CommitBatch(const std::string& intent_path);
+
+        void stage(const std::string& path, std::string contents);
+        bool commit();
+
+        size_t staged_count() const { return staged.size(); }
+        bool empty() const { return staged.empty(); }
+
+        // Call before reading any file a batch may have written
+        static bool recover(const std::string& intent_path);
+    };
+
+} // namespace descansa
+
+#endif // DURABLE_FILE_H
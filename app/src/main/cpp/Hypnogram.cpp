@@ -0,0 +1,186 @@
+// Hypnogram.cpp - Implementation
+#include "Hypnogram.h"
+#include <algorithm>
+#include <utility>
+
+namespace descansa {
+
+    namespace {
+
+        const char kStageCodes[kSleepStageCount] = {'W', 'L', 'D', 'R', 'U', 'S'};
+
+        // Upper bound on a parsed timeline (~2 years of 30 s epochs), so a
+        // corrupt count can't trigger a huge allocation
+        const uint64_t kMaxParsedEpochs = 1u << 21;
+
+        bool stage_from_code(char code, SleepStage& stage) {
+            for (size_t index = 0; index < kSleepStageCount; ++index) {
+                if (kStageCodes[index] == code) {
+                    stage = static_cast<SleepStage>(index);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    } // namespace
+
+    SleepStage sleep_stage_from_name(const std::string& name) {
+        if (name == "light") return SleepStage::LIGHT;
+        if (name == "deep") return SleepStage::DEEP;
+        if (name == "rem") return SleepStage::REM;
+        if (name == "awake") return SleepStage::AWAKE;
+        if (name == "asleep") return SleepStage::ASLEEP;
+        return SleepStage::UNKNOWN;
+    }
+
+    const char* sleep_stage_name(SleepStage stage) {
+        switch (stage) {
+            case SleepStage::AWAKE: return "awake";
+            case SleepStage::LIGHT: return "light";
+            case SleepStage::DEEP: return "deep";
+            case SleepStage::REM: return "rem";
+            case SleepStage::ASLEEP: return "asleep";
+            default: return "unknown";
+        }
+    }
+
+    const int32_t Hypnogram::kDefaultEpochSeconds;
+
+    Hypnogram::Hypnogram(int64_t start_seconds, int32_t epoch_seconds) {
+        reset(start_seconds, epoch_seconds);
+    }
+
+    void Hypnogram::reset(int64_t start_seconds, int32_t epoch_seconds) {
+        start = start_seconds;
+        epoch_length = epoch_seconds > 0 ? epoch_seconds : kDefaultEpochSeconds;
+        stages.clear();
+        std::fill(stage_epochs, stage_epochs + kSleepStageCount, 0u);
+        transitions = 0;
+    }
+
+    void Hypnogram::append(SleepStage stage, size_t epochs) {
+        if (epochs == 0) return;
+        if (static_cast<size_t>(stage) >= kSleepStageCount) stage = SleepStage::UNKNOWN;
+
+        uint8_t code = static_cast<uint8_t>(stage);
+        if (!stages.empty() && stages.back() != code) transitions++;
+        stages.insert(stages.end(), epochs, code);
+        stage_epochs[code] += static_cast<uint32_t>(epochs);
+    }
+
+    void Hypnogram::set_stage(size_t epoch, SleepStage stage) {
+        if (epoch >= stages.size()) return;
+        if (static_cast<size_t>(stage) >= kSleepStageCount) stage = SleepStage::UNKNOWN;
+
+        uint8_t old_code = stages[epoch];
+        uint8_t code = static_cast<uint8_t>(stage);
+        if (old_code == code) return;
+
+        // Only the boundaries with the two neighbours can change
+        if (epoch > 0) transitions += (stages[epoch - 1] != code) - (stages[epoch - 1] != old_code);
+        if (epoch + 1 < stages.size()) transitions += (stages[epoch + 1] != code) - (stages[epoch + 1] != old_code);
+
+        stages[epoch] = code;
+        stage_epochs[old_code]--;
+        stage_epochs[code]++;
+    }
+
+    void Hypnogram::append_span(int64_t begin_seconds, int64_t end_seconds, SleepStage stage) {
+        if (end_seconds <= start || end_seconds <= begin_seconds) return;
+
+        // Boundaries snap to the nearest epoch edge
+        int64_t half = epoch_length / 2;
+        int64_t first = (std::max(begin_seconds - start, int64_t(0)) + half) / epoch_length;
+        int64_t last = (end_seconds - start + half) / epoch_length;
+        int64_t covered = static_cast<int64_t>(stages.size());
+        if (last <= covered) return;
+
+        if (first > covered) append(SleepStage::UNKNOWN, static_cast<size_t>(first - covered));
+        append(stage, static_cast<size_t>(last - std::max(first, covered)));
+    }
+
+    SleepStage Hypnogram::stage_at(int64_t seconds) const {
+        if (seconds < start || seconds >= end_seconds()) return SleepStage::UNKNOWN;
+        return stage_of_epoch(static_cast<size_t>((seconds - start) / epoch_length));
+    }
+
+    size_t Hypnogram::transition_count(SleepStage from, SleepStage to) const {
+        uint8_t from_code = static_cast<uint8_t>(from);
+        uint8_t to_code = static_cast<uint8_t>(to);
+        size_t count = 0;
+        for (size_t epoch = 1; epoch < stages.size(); ++epoch) {
+            if (stages[epoch - 1] == from_code && stages[epoch] == to_code && from_code != to_code) count++;
+        }
+        return count;
+    }
+
+    std::vector<Hypnogram::StageRun> Hypnogram::runs() const {
+        std::vector<StageRun> result;
+        result.reserve(transitions + 1);
+
+        size_t epoch = 0;
+        while (epoch < stages.size()) {
+            size_t end = epoch + 1;
+            while (end < stages.size() && stages[end] == stages[epoch]) end++;
+
+            StageRun run;
+            run.first_epoch = epoch;
+            run.epoch_count = end - epoch;
+            run.stage = static_cast<SleepStage>(stages[epoch]);
+            result.push_back(run);
+            epoch = end;
+        }
+        return result;
+    }
+
+    void Hypnogram::write(std::ostream& out) const {
+        out << start << ":" << epoch_length << ":";
+
+        size_t epoch = 0;
+        while (epoch < stages.size()) {
+            size_t end = epoch + 1;
+            while (end < stages.size() && stages[end] == stages[epoch]) end++;
+            out << kStageCodes[stages[epoch]] << (end - epoch);
+            epoch = end;
+        }
+    }
+
+    bool Hypnogram::read(const text_parser::TextSpan& text) {
+        text_parser::FieldCursor fields(text, ':');
+        text_parser::TextSpan start_field, epoch_field, runs_field;
+        int64_t start_value = 0;
+        int epoch_value = 0;
+
+        if (!fields.next(start_field) || !fields.next(epoch_field) ||
+            !text_parser::parse_int64(start_field, start_value) ||
+            !text_parser::parse_int(epoch_field, epoch_value) || epoch_value <= 0) {
+            return false;
+        }
+        fields.next(runs_field);    // May be absent for an empty timeline
+
+        // Decode into a scratch timeline so a bad field leaves this one untouched
+        Hypnogram parsed(start_value, epoch_value);
+        uint64_t total = 0;
+        const char* position = runs_field.begin;
+        while (position != runs_field.end) {
+            SleepStage stage;
+            if (!stage_from_code(*position++, stage)) return false;
+
+            uint64_t count = 0;
+            const char* digits = position;
+            while (position != runs_field.end && *position >= '0' && *position <= '9') {
+                count = count * 10 + static_cast<uint64_t>(*position++ - '0');
+                if (count > kMaxParsedEpochs) return false;
+            }
+            total += count;
+            if (position == digits || count == 0 || total > kMaxParsedEpochs) return false;
+
+            parsed.append(stage, static_cast<size_t>(count));
+        }
+
+        *this = std::move(parsed);
+        return true;
+    }
+
+} // namespace descansa
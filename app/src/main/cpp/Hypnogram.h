@@ -0,0 +1,101 @@
+// Hypnogram.h - Compact sleep stage timeline on a fixed epoch grid
+#ifndef HYPNOGRAM_H
+#define HYPNOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "TimeTypes.h"
+#include "TextDataParser.h"
+
+namespace descansa {
+
+// Sleep stages, one byte each; names are interned once on the way in
+    enum class SleepStage : uint8_t {
+        AWAKE = 0,
+        LIGHT = 1,
+        DEEP = 2,
+        REM = 3,
+        UNKNOWN = 4,
+        ASLEEP = 5          // asleep, stage not resolved (movement-only scoring)
+    };
+
+    const size_t kSleepStageCount = 6;
+
+// "awake", "light", "deep", "rem", "asleep"; anything else maps to UNKNOWN
+    SleepStage sleep_stage_from_name(const std::string& name);
+    const char* sleep_stage_name(SleepStage stage);
+
+// One stage byte per fixed-length epoch (30 s by default, the scoring
+// convention), so a night of sleep is about a kilobyte and the stage at a
+// time is an index. Per-stage epoch counts and the transition count are kept
+// up to date on append, so totals are O(1). On disk the epochs are
+// run-length encoded: "start:epoch:W4L20D18..." is a few dozen bytes a night.
+    class Hypnogram {
+    public:
+        static const int32_t kDefaultEpochSeconds = 30;
+
+        // A maximal stretch of epochs with the same stage
+        struct StageRun {
+            size_t first_epoch;
+            size_t epoch_count;
+            SleepStage stage;
+        };
+
+    private:
+        int64_t start;              // epoch seconds of the first epoch
+        int32_t epoch_length;       // seconds
+        std::vector<uint8_t> stages;
+        uint32_t stage_epochs[kSleepStageCount];
+        uint32_t transitions;       // stage changes between consecutive epochs
+
+    public:
+        explicit Hypnogram(int64_t start_seconds = 0, int32_t epoch_seconds = kDefaultEpochSeconds);
+
+        // Empty timeline on a new grid
+        void reset(int64_t start_seconds, int32_t epoch_seconds = kDefaultEpochSeconds);
+        void clear() { reset(start, epoch_length); }
+
+        void append(SleepStage stage, size_t epochs = 1);
+
+        // Rewrite one recorded epoch (a re-scored tail); totals stay O(1)
+        void set_stage(size_t epoch, SleepStage stage);
+
+        // Extend to cover [begin, end) with the stage, snapped to the epoch
+        // grid; a gap after the current end is filled with UNKNOWN, and time
+        // already covered is left as it is
+        void append_span(int64_t begin_seconds, int64_t end_seconds, SleepStage stage);
+
+        bool empty() const { return stages.empty(); }
+        size_t epoch_count() const { return stages.size(); }
+        int32_t epoch_seconds() const { return epoch_length; }
+        int64_t start_seconds() const { return start; }
+        int64_t end_seconds() const { return start + static_cast<int64_t>(stages.size()) * epoch_length; }
+
+        SleepStage stage_of_epoch(size_t epoch) const { return static_cast<SleepStage>(stages[epoch]); }
+
+        // UNKNOWN outside the recorded span
+        SleepStage stage_at(int64_t seconds) const;
+        SleepStage stage_at(const TimePoint& time) const { return stage_at(to_epoch_seconds(time)); }
+
+        size_t epochs_in(SleepStage stage) const { return stage_epochs[static_cast<size_t>(stage)]; }
+        Duration total(SleepStage stage) const { return Duration(static_cast<int64_t>(epochs_in(stage)) * epoch_length); }
+        Duration total_asleep() const {
+            return total(SleepStage::LIGHT) + total(SleepStage::DEEP) + total(SleepStage::REM) + total(SleepStage::ASLEEP);
+        }
+
+        size_t transition_count() const { return transitions; }
+        size_t transition_count(SleepStage from, SleepStage to) const;    // one scan
+
+        std::vector<StageRun> runs() const;
+
+        // One field without commas or blanks, so it can sit in a CSV line
+        void write(std::ostream& out) const;
+        bool read(const text_parser::TextSpan& text);
+    };
+
+} // namespace descansa
+
+#endif // HYPNOGRAM_H
@@ -0,0 +1,117 @@
+// LocalDayIndex.cpp - Implementation
+#include "LocalDayIndex.h"
+#include "CivilTime.h"
+#include <algorithm>
+
+namespace descansa {
+
+    const int64_t LocalDayIndex::kMaxDenseSpanDays;
+
+    int64_t LocalDayIndex::day_of(const TimePoint& time) {
+        return civil::local_day(civil::to_seconds(time));
+    }
+
+    void LocalDayIndex::clear() {
+        row_days.clear();
+        slots.clear();
+        first_day = 0;
+    }
+
+    void LocalDayIndex::assign(const std::vector<DailySleepSummary>& summaries) {
+        row_days.clear();
+        row_days.reserve(summaries.size());
+        for (const auto& summary : summaries) {
+            row_days.push_back(day_of(summary.date));
+        }
+        rebuild_slots();
+    }
+
+    void LocalDayIndex::rebuild_slots() {
+        slots.clear();
+        if (row_days.empty()) return;
+
+        first_day = row_days.front();
+        int64_t span = row_days.back() - first_day + 1;
+        if (span > kMaxDenseSpanDays) return;   // find() falls back to binary search
+
+        slots.assign(static_cast<size_t>(span), -1);
+        for (size_t row = 0; row < row_days.size(); ++row) {
+            int32_t& slot = slots[static_cast<size_t>(row_days[row] - first_day)];
+            if (slot < 0) slot = static_cast<int32_t>(row);    // First row wins on duplicates
+        }
+    }
+
+    bool LocalDayIndex::find(int64_t day, size_t& row) const {
+        if (row_days.empty() || day < row_days.front() || day > row_days.back()) return false;
+
+        if (!slots.empty()) {
+            int32_t slot = slots[static_cast<size_t>(day - first_day)];
+            if (slot < 0) return false;
+            row = static_cast<size_t>(slot);
+            return true;
+        }
+
+        auto position = std::lower_bound(row_days.begin(), row_days.end(), day);
+        if (position == row_days.end() || *position != day) return false;
+        row = static_cast<size_t>(position - row_days.begin());
+        return true;
+    }
+
+    size_t LocalDayIndex::insertion_row(int64_t day) const {
+        // Common case: a new day after everything recorded so far
+        if (row_days.empty() || day >= row_days.back()) return row_days.size();
+        return static_cast<size_t>(std::upper_bound(row_days.begin(), row_days.end(), day) - row_days.begin());
+    }
+
+    std::pair<size_t, size_t> LocalDayIndex::rows_between(int64_t from_day, int64_t end_day) const {
+        auto first = std::lower_bound(row_days.begin(), row_days.end(), from_day);
+        auto last = std::lower_bound(first, row_days.end(), end_day);
+        return std::make_pair(static_cast<size_t>(first - row_days.begin()),
+                              static_cast<size_t>(last - row_days.begin()));
+    }
+
+    void LocalDayIndex::insert(size_t row, int64_t day) {
+        if (row >= row_days.size() && (row_days.empty() || day >= row_days.back())) {
+            bool first_row = row_days.empty();
+            row_days.push_back(day);
+
+            if (first_row || !slots.empty()) {
+                if (first_row) first_day = day;
+                int64_t span = day - first_day + 1;
+                if (span <= kMaxDenseSpanDays) {
+                    if (static_cast<size_t>(span) > slots.size()) slots.resize(static_cast<size_t>(span), -1);
+                    int32_t& slot = slots[static_cast<size_t>(day - first_day)];
+                    if (slot < 0) slot = static_cast<int32_t>(row_days.size() - 1);
+                } else {
+                    slots.clear();
+                }
+            }
+            return;
+        }
+
+        row_days.insert(row_days.begin() + static_cast<std::ptrdiff_t>(std::min(row, row_days.size())), day);
+        rebuild_slots();
+    }
+
+    void LocalDayIndex::erase_front(size_t rows) {
+        rows = std::min(rows, row_days.size());
+        if (rows == 0) return;
+
+        row_days.erase(row_days.begin(), row_days.begin() + static_cast<std::ptrdiff_t>(rows));
+        rebuild_slots();
+    }
+
+    bool LocalDayIndex::mirrors(const std::vector<DailySleepSummary>& summaries) const {
+        if (summaries.size() != row_days.size()) return false;
+
+        for (size_t row = 0; row < summaries.size(); ++row) {
+            size_t found = 0;
+            if (row_days[row] != day_of(summaries[row].date) || !find(row_days[row], found) ||
+                row_days[found] != row_days[row]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+} // namespace descansa
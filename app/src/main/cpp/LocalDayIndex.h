@@ -0,0 +1,58 @@
+// LocalDayIndex.h - O(1) lookup of daily summaries by local civil day number
+#ifndef LOCAL_DAY_INDEX_H
+#define LOCAL_DAY_INDEX_H
+
+#include "SleepDataStructures.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace descansa {
+
+// Parallel index over the owner's date-ordered summary vector: the local day
+// number of every row, plus a dense slot table from (day - first day) to row.
+// Keys are computed once per summary, so lookups never convert time zones.
+// Appending a later day is O(1) amortized; inserting before the end or
+// dropping a prefix re-numbers the slots in O(rows) without conversions.
+    class LocalDayIndex {
+    public:
+        static const int64_t kMaxDenseSpanDays = 1 << 16;    // ~180 years; beyond that, binary search
+
+    private:
+        std::vector<int64_t> row_days;      // local day of each row, non-decreasing
+        std::vector<int32_t> slots;         // row for first_day + i, or -1
+        int64_t first_day;
+
+        void rebuild_slots();
+
+    public:
+        LocalDayIndex() : first_day(0) {}
+
+        void clear();
+        void assign(const std::vector<DailySleepSummary>& summaries);
+
+        // Row holding the given day; false when there is none
+        bool find(int64_t day, size_t& row) const;
+
+        // Row a new summary for the given day must be inserted at to keep order
+        size_t insertion_row(int64_t day) const;
+
+        // Rows [first, last) whose day lies in [from_day, end_day)
+        std::pair<size_t, size_t> rows_between(int64_t from_day, int64_t end_day) const;
+
+        void insert(size_t row, int64_t day);   // row == size() appends
+        void erase_front(size_t rows);
+
+        size_t size() const { return row_days.size(); }
+        int64_t day_at(size_t row) const { return row_days[row]; }
+
+        // Row-for-row agreement with the owner's vector (diagnostics)
+        bool mirrors(const std::vector<DailySleepSummary>& summaries) const;
+
+        static int64_t day_of(const TimePoint& time);
+    };
+
+} // namespace descansa
+
+#endif // LOCAL_DAY_INDEX_H
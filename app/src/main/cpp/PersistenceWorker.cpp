@@ -0,0 +1,104 @@
+// PersistenceWorker.cpp - Implementation
+#include "PersistenceWorker.h"
+#include "TraceBuffer.h"
+#include <algorithm>
+
+namespace descansa {
+
+    PersistenceWorker::PersistenceWorker(std::function<bool()> write_fn,
+                                         std::chrono::milliseconds debounce,
+                                         std::chrono::milliseconds max_wait)
+            : write_function(std::move(write_fn)), debounce_delay(debounce), max_delay(max_wait),
+              dirty(false), writing(false), stopping(false), last_write_ok(true), writes_completed(0) {
+        worker = std::thread(&PersistenceWorker::run, this);
+    }
+
+    PersistenceWorker::~PersistenceWorker() {
+        flush();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        state_changed.notify_all();
+        worker.join();
+    }
+
+    void PersistenceWorker::mark_dirty() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            Clock::time_point now = Clock::now();
+            if (!dirty) {
+                dirty = true;
+                first_dirty_time = now;
+            }
+            last_dirty_time = now;
+        }
+        state_changed.notify_all();
+    }
+
+    bool PersistenceWorker::write_locked(std::unique_lock<std::mutex>& lock) {
+        dirty = false;
+        writing = true;
+        lock.unlock();
+
+        bool ok;
+        {
+            DESCANSA_TRACE_SCOPE("PersistenceWorker::write");
+            ok = write_function();
+        }
+
+        lock.lock();
+        writing = false;
+        last_write_ok = ok;
+        writes_completed++;
+        state_changed.notify_all();
+        return ok;
+    }
+
+    bool PersistenceWorker::flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        state_changed.wait(lock, [this] { return !writing; });
+
+        if (dirty) {
+            return write_locked(lock);
+        }
+        return last_write_ok;
+    }
+
+    void PersistenceWorker::run() {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        while (true) {
+            state_changed.wait(lock, [this] { return stopping || (dirty && !writing); });
+            if (stopping) break;
+
+            // Debounce: wait for a quiet period, but never past max_delay
+            while (dirty && !stopping) {
+                Clock::time_point deadline = std::min(last_dirty_time + debounce_delay,
+                                                      first_dirty_time + max_delay);
+                if (Clock::now() >= deadline) break;
+                state_changed.wait_until(lock, deadline);
+            }
+            if (stopping) break;
+            if (!dirty || writing) continue; // A flush() got there first
+
+            if (!write_locked(lock) && !dirty) {
+                // Retry a failed write once max_delay has passed, not in a tight loop
+                dirty = true;
+                first_dirty_time = last_dirty_time = Clock::now() + max_delay;
+            }
+        }
+    }
+
+    bool PersistenceWorker::has_pending_write() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dirty || writing;
+    }
+
+    uint64_t PersistenceWorker::get_write_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writes_completed;
+    }
+
+} // namespace descansa
@@ -0,0 +1,68 @@
+// PersistenceWorker.h - Debounced background writer with write coalescing
+#ifndef PERSISTENCE_WORKER_H
+#define PERSISTENCE_WORKER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace descansa {
+
+// Runs a write function on a background thread once state has been marked
+// dirty and then left alone for the debounce delay. A burst of mutations
+// collapses into one write; max_delay bounds how long a steady stream of
+// mutations can postpone it. flush() is the synchronous barrier used on
+// pause/shutdown.
+//
+// The write function is called without any worker lock held and must do its
+// own synchronization with the state it persists. Never call flush() while
+// holding a lock the write function takes.
+    class PersistenceWorker {
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        std::function<bool()> write_function;
+        std::chrono::milliseconds debounce_delay;
+        std::chrono::milliseconds max_delay;
+
+        std::mutex mutex;
+        std::condition_variable state_changed;
+        bool dirty;
+        bool writing;
+        bool stopping;
+        bool last_write_ok;
+        uint64_t writes_completed;
+        Clock::time_point first_dirty_time;
+        Clock::time_point last_dirty_time;
+
+        std::thread worker;
+
+        void run();
+        bool write_locked(std::unique_lock<std::mutex>& lock);
+
+        PersistenceWorker(const PersistenceWorker&) = delete;
+        PersistenceWorker& operator=(const PersistenceWorker&) = delete;
+
+    public:
+        explicit PersistenceWorker(std::function<bool()> write_fn,
+                                   std::chrono::milliseconds debounce = std::chrono::milliseconds(250),
+                                   std::chrono::milliseconds max_wait = std::chrono::milliseconds(2000));
+        ~PersistenceWorker();
+
+        // Cheap; safe to call from any thread, including inside the write function's lock
+        void mark_dirty();
+
+        // Performs any pending write now and waits for an in-flight one.
+        // Returns the result of the most recent write.
+        bool flush();
+
+        bool has_pending_write();
+        uint64_t get_write_count();
+    };
+
+} // namespace descansa
+
+#endif // PERSISTENCE_WORKER_H
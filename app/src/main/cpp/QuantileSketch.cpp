@@ -0,0 +1,223 @@
+// QuantileSketch.cpp - Implementation
+#include "QuantileSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <utility>
+
+namespace descansa {
+
+    namespace {
+        const double kCapacityDecay = 2.0 / 3.0;    // each level down keeps 2/3 of the one above
+        const size_t kMinLevelCapacity = 2;
+        const uint32_t kCoinSeed = 0x9E3779B9u;
+        const size_t kMaxLevels = 64;
+        const size_t kMaxParsedLevelFactor = 4;
+    }
+
+    const uint16_t QuantileSketch::kDefaultK;
+
+    QuantileSketch::QuantileSketch(uint16_t k_parameter)
+            : k(k_parameter < kMinLevelCapacity ? kMinLevelCapacity : k_parameter) {
+        clear();
+    }
+
+    void QuantileSketch::clear() {
+        n = 0;
+        min_value = 0.0;
+        max_value = 0.0;
+        levels.clear();
+        set_level_count(1);
+        retained = 0;
+        coin_state = kCoinSeed;
+    }
+
+    size_t QuantileSketch::level_capacity(size_t level) const {
+        // The top level gets k, lower levels geometrically less
+        size_t depth = levels.size() - 1 - level;
+        double scaled = std::ceil(k * std::pow(kCapacityDecay, static_cast<double>(depth)));
+        return std::max(kMinLevelCapacity, static_cast<size_t>(scaled));
+    }
+
+    size_t QuantileSketch::total_capacity() const {
+        size_t total = 0;
+        for (size_t level = 0; level < levels.size(); ++level) {
+            total += level_capacity(level);
+        }
+        return total;
+    }
+
+    void QuantileSketch::set_level_count(size_t count) {
+        levels.resize(count);
+        capacity = total_capacity();
+    }
+
+    bool QuantileSketch::next_coin() {
+        // xorshift32
+        coin_state ^= coin_state << 13;
+        coin_state ^= coin_state >> 17;
+        coin_state ^= coin_state << 5;
+        return (coin_state & 1u) != 0;
+    }
+
+    void QuantileSketch::compress() {
+        while (retained >= capacity) {
+            size_t level = 0;
+            while (level < levels.size() && levels[level].size() < level_capacity(level)) {
+                ++level;
+            }
+            if (level == levels.size()) return;  // Nothing full yet
+            if (level + 1 == levels.size()) {
+                if (levels.size() == kMaxLevels) return;
+                set_level_count(levels.size() + 1);
+            }
+
+            std::vector<double>& compactor = levels[level];
+            std::vector<double>& above = levels[level + 1];
+            std::sort(compactor.begin(), compactor.end());
+
+            // An odd item out stays behind so the promoted pairs are exact halves
+            size_t leftover = compactor.size() % 2;
+            size_t offset = leftover + (next_coin() ? 1 : 0);
+            for (size_t i = offset; i < compactor.size(); i += 2) {
+                above.push_back(compactor[i]);
+            }
+
+            size_t promoted = (compactor.size() - leftover) / 2;
+            retained -= compactor.size() - leftover - promoted;
+            compactor.resize(leftover);
+        }
+    }
+
+    void QuantileSketch::add(double value) {
+        if (n == 0) {
+            min_value = value;
+            max_value = value;
+        } else {
+            min_value = std::min(min_value, value);
+            max_value = std::max(max_value, value);
+        }
+
+        levels[0].push_back(value);
+        ++retained;
+        ++n;
+        if (retained >= capacity) compress();
+    }
+
+    bool QuantileSketch::merge(const QuantileSketch& other) {
+        if (other.k != k) return false;
+        if (other.n == 0) return true;
+
+        if (n == 0) {
+            min_value = other.min_value;
+            max_value = other.max_value;
+        } else {
+            min_value = std::min(min_value, other.min_value);
+            max_value = std::max(max_value, other.max_value);
+        }
+
+        if (levels.size() < other.levels.size()) set_level_count(other.levels.size());
+        for (size_t level = 0; level < other.levels.size(); ++level) {
+            levels[level].insert(levels[level].end(), other.levels[level].begin(), other.levels[level].end());
+        }
+        retained += other.retained;
+        n += other.n;
+        compress();
+        return true;
+    }
+
+    double QuantileSketch::rank(double value) const {
+        if (n == 0) return 0.0;
+
+        uint64_t weight_at_or_below = 0;
+        for (size_t level = 0; level < levels.size(); ++level) {
+            uint64_t below = 0;
+            for (double item : levels[level]) {
+                if (item <= value) ++below;
+            }
+            weight_at_or_below += below << level;
+        }
+        return std::min(1.0, static_cast<double>(weight_at_or_below) / n);
+    }
+
+    double QuantileSketch::quantile(double fraction) const {
+        if (n == 0) return 0.0;
+        if (fraction <= 0.0) return min_value;
+        if (fraction >= 1.0) return max_value;
+
+        std::vector<std::pair<double, uint64_t>> weighted;
+        weighted.reserve(retained);
+        for (size_t level = 0; level < levels.size(); ++level) {
+            for (double item : levels[level]) {
+                weighted.push_back(std::make_pair(item, uint64_t(1) << level));
+            }
+        }
+        std::sort(weighted.begin(), weighted.end());
+
+        // Weights always sum to n, so the target is reached before the end
+        double target = fraction * n;
+        uint64_t cumulative = 0;
+        for (const auto& entry : weighted) {
+            cumulative += entry.second;
+            if (cumulative >= target) return entry.first;
+        }
+        return max_value;
+    }
+
+    void QuantileSketch::write(std::ostream& out) const {
+        std::ostringstream line;
+        line.precision(std::numeric_limits<double>::max_digits10);
+        line << k << " " << n << " " << min_value << " " << max_value << " " << levels.size();
+        for (const auto& level : levels) {
+            line << " " << level.size();
+            for (double item : level) {
+                line << " " << item;
+            }
+        }
+        out << line.str() << "\n";
+    }
+
+    bool QuantileSketch::read(const std::string& line) {
+        std::istringstream in(line);
+        unsigned int k_value = 0;
+        uint64_t count = 0;
+        double low = 0.0, high = 0.0;
+        size_t level_count = 0;
+        if (!(in >> k_value >> count >> low >> high >> level_count) ||
+            k_value < kMinLevelCapacity || k_value > 0xFFFF || level_count == 0 || level_count > kMaxLevels) {
+            return false;
+        }
+
+        std::vector<std::vector<double>> parsed(level_count);
+        size_t parsed_retained = 0;
+        uint64_t weight = 0;
+        // compress() keeps every level under total_capacity(), at most ~3k plus
+        // the per-level floor; a size far past that can only be corruption
+        const size_t max_level_size = kMaxParsedLevelFactor * k_value + kMinLevelCapacity * kMaxLevels;
+        for (size_t level = 0; level < level_count; ++level) {
+            size_t size = 0;
+            if (!(in >> size) || size > count || size > max_level_size) return false;
+            parsed[level].reserve(size);
+            for (size_t i = 0; i < size; ++i) {
+                double item = 0.0;
+                if (!(in >> item)) return false;
+                parsed[level].push_back(item);
+            }
+            parsed_retained += size;
+            weight += static_cast<uint64_t>(size) << level;
+        }
+        if (weight != count) return false;     // Weights must account for every value
+
+        k = static_cast<uint16_t>(k_value);
+        n = count;
+        min_value = low;
+        max_value = high;
+        levels.swap(parsed);
+        capacity = total_capacity();
+        retained = parsed_retained;
+        coin_state = kCoinSeed;
+        return true;
+    }
+
+} // namespace descansa
@@ -0,0 +1,68 @@
+// QuantileSketch.h - Mergeable streaming quantile sketch (KLL)
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace descansa {
+
+// KLL sketch: a stack of compactors where level h holds items of weight 2^h.
+// When the retained items exceed the total capacity, the lowest full level is
+// sorted and every other item moves up a level. With the default k = 200 the
+// rank error stays around 1.5% whatever the stream length, in a few hundred
+// retained doubles; below k values everything is kept and answers are exact.
+// add() is amortized O(log k), rank() is one scan of the retained items.
+    class QuantileSketch {
+    public:
+        static const uint16_t kDefaultK = 200;
+
+    private:
+        uint16_t k;
+        uint64_t n;
+        double min_value;
+        double max_value;
+        std::vector<std::vector<double>> levels;
+        size_t retained;
+        size_t capacity;        // total_capacity() for the current level count
+        uint32_t coin_state;    // deterministic coin flips, so rebuilds reproduce
+
+        size_t level_capacity(size_t level) const;
+        size_t total_capacity() const;
+        void set_level_count(size_t count);
+        void compress();
+        bool next_coin();
+
+    public:
+        explicit QuantileSketch(uint16_t k_parameter = kDefaultK);
+
+        void clear();
+        void add(double value);
+
+        // False when the sketches were built with different k
+        bool merge(const QuantileSketch& other);
+
+        uint64_t count() const { return n; }
+        bool empty() const { return n == 0; }
+        size_t retained_items() const { return retained; }
+        uint16_t k_parameter() const { return k; }
+        double min() const { return min_value; }     // 0 when empty
+        double max() const { return max_value; }     // 0 when empty
+
+        // Estimated fraction of values <= value, in [0, 1]
+        double rank(double value) const;
+
+        // Estimated value at the given fraction in [0, 1]; 0 when empty
+        double quantile(double fraction) const;
+
+        // One line: "k n min max levels size v... size v..."
+        void write(std::ostream& out) const;
+        bool read(const std::string& line);
+    };
+
+} // namespace descansa
+
+#endif // QUANTILE_SKETCH_H
@@ -0,0 +1,124 @@
+// RollingSleepAggregates.cpp - Implementation
+#include "RollingSleepAggregates.h"
+#include "CivilTime.h"
+#include <algorithm>
+
+namespace descansa {
+
+    namespace {
+        const int kTrackedWindowDays[] = {7, 30, 90};
+    }
+
+    const int RollingSleepAggregates::kMaxWindowDays;
+
+    RollingSleepAggregates::RollingSleepAggregates() : current_day(0) {
+        for (int i = 0; i < kTrackedWindowCount; ++i) {
+            tracked[i].days = kTrackedWindowDays[i];
+        }
+        clear();
+    }
+
+    size_t RollingSleepAggregates::slot_of(int64_t day) {
+        int64_t slot = day % kMaxWindowDays;
+        return static_cast<size_t>(slot < 0 ? slot + kMaxWindowDays : slot);
+    }
+
+    int64_t RollingSleepAggregates::day_index(int64_t epoch_seconds) {
+        return civil::local_day(epoch_seconds);
+    }
+
+    int64_t RollingSleepAggregates::window_start(int64_t today, int days) {
+        return civil::from_local(today - (days - 1), 0);
+    }
+
+    void RollingSleepAggregates::reset_bucket(DayBucket& bucket, int64_t day) {
+        bucket.day = day;
+        bucket.total_seconds = 0;
+        bucket.count = 0;
+        bucket.min_seconds = 0;
+        bucket.max_seconds = 0;
+    }
+
+    void RollingSleepAggregates::clear() {
+        for (int64_t day = current_day - (kMaxWindowDays - 1); day <= current_day; ++day) {
+            reset_bucket(bucket_for(day), day);
+        }
+        for (int i = 0; i < kTrackedWindowCount; ++i) {
+            tracked[i].stats = SleepWindowStats();
+        }
+    }
+
+    SleepWindowStats RollingSleepAggregates::sum_buckets(int days) const {
+        SleepWindowStats stats;
+        for (int64_t day = current_day - (days - 1); day <= current_day; ++day) {
+            const DayBucket& bucket = bucket_for(day);
+            if (bucket.day != day || bucket.count == 0) continue;
+
+            stats.min_seconds = stats.count == 0 ? bucket.min_seconds : std::min(stats.min_seconds, bucket.min_seconds);
+            stats.max_seconds = stats.count == 0 ? bucket.max_seconds : std::max(stats.max_seconds, bucket.max_seconds);
+            stats.total_seconds += bucket.total_seconds;
+            stats.count += bucket.count;
+        }
+        return stats;
+    }
+
+    void RollingSleepAggregates::advance_to(int64_t today) {
+        if (today <= current_day) return;
+
+        // Gap longer than every window - nothing survives
+        if (today - current_day >= kMaxWindowDays) {
+            current_day = today;
+            clear();
+            return;
+        }
+
+        while (current_day < today) {
+            current_day++;
+            reset_bucket(bucket_for(current_day), current_day); // Recycles the day leaving the 90-day window
+
+            for (int i = 0; i < kTrackedWindowCount; ++i) {
+                // Subtracting a departing bucket can't restore min/max, so rebuild
+                // the window once per rollover
+                tracked[i].stats = sum_buckets(tracked[i].days);
+            }
+        }
+    }
+
+    void RollingSleepAggregates::add(int64_t wake_time, int64_t duration_seconds) {
+        int64_t day = std::min(day_index(wake_time), current_day); // Clock skew: count future wakes today
+        if (day <= current_day - kMaxWindowDays) return;            // Older than every window
+
+        DayBucket& bucket = bucket_for(day);
+        if (bucket.day != day) reset_bucket(bucket, day);
+
+        bucket.min_seconds = bucket.count == 0 ? duration_seconds : std::min(bucket.min_seconds, duration_seconds);
+        bucket.max_seconds = bucket.count == 0 ? duration_seconds : std::max(bucket.max_seconds, duration_seconds);
+        bucket.total_seconds += duration_seconds;
+        bucket.count++;
+
+        for (int i = 0; i < kTrackedWindowCount; ++i) {
+            if (day <= current_day - tracked[i].days) continue;
+
+            SleepWindowStats& stats = tracked[i].stats;
+            stats.min_seconds = stats.count == 0 ? duration_seconds : std::min(stats.min_seconds, duration_seconds);
+            stats.max_seconds = stats.count == 0 ? duration_seconds : std::max(stats.max_seconds, duration_seconds);
+            stats.total_seconds += duration_seconds;
+            stats.count++;
+        }
+    }
+
+    bool RollingSleepAggregates::window(int days, SleepWindowStats& stats) const {
+        if (days < 1 || days > kMaxWindowDays) return false;
+
+        for (int i = 0; i < kTrackedWindowCount; ++i) {
+            if (tracked[i].days == days) {
+                stats = tracked[i].stats;
+                return true;
+            }
+        }
+
+        stats = sum_buckets(days);
+        return true;
+    }
+
+} // namespace descansa
@@ -0,0 +1,83 @@
+// RollingSleepAggregates.h - Incrementally maintained sliding-window sleep statistics
+#ifndef ROLLING_SLEEP_AGGREGATES_H
+#define ROLLING_SLEEP_AGGREGATES_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace descansa {
+
+// Totals for one window of days
+    struct SleepWindowStats {
+        int64_t total_seconds;
+        size_t count;
+        int64_t min_seconds;    // 0 when count == 0
+        int64_t max_seconds;    // 0 when count == 0
+
+        SleepWindowStats() : total_seconds(0), count(0), min_seconds(0), max_seconds(0) {}
+
+        // Truncated to whole seconds
+        int64_t average_seconds() const {
+            return count > 0 ? total_seconds / static_cast<int64_t>(count) : 0;
+        }
+    };
+
+// Sum/count/min/max per day bucket over the last kMaxWindowDays days, with
+// running totals for the 7/30/90-day windows. Adding a session and reading
+// a tracked window are O(1); a day rollover costs O(window) once per day.
+// A window of N days is today plus the N-1 days before it, in local days,
+// so "today" rolls over at the user's midnight.
+    class RollingSleepAggregates {
+    public:
+        static const int kMaxWindowDays = 90;
+
+    private:
+        struct DayBucket {
+            int64_t day;
+            int64_t total_seconds;
+            uint32_t count;
+            int64_t min_seconds;
+            int64_t max_seconds;
+        };
+
+        struct TrackedWindow {
+            int days;
+            SleepWindowStats stats;
+        };
+
+        static const int kTrackedWindowCount = 3;
+
+        DayBucket buckets[kMaxWindowDays];
+        TrackedWindow tracked[kTrackedWindowCount];
+        int64_t current_day;
+
+        DayBucket& bucket_for(int64_t day) { return buckets[slot_of(day)]; }
+        const DayBucket& bucket_for(int64_t day) const { return buckets[slot_of(day)]; }
+        static size_t slot_of(int64_t day);
+
+        void reset_bucket(DayBucket& bucket, int64_t day);
+        SleepWindowStats sum_buckets(int days) const;
+
+    public:
+        RollingSleepAggregates();
+
+        void clear();
+
+        // Move "today" forward; buckets that fall out of every window are recycled
+        void advance_to(int64_t today);
+
+        // Record a completed session by wake time (seconds since epoch)
+        void add(int64_t wake_time, int64_t duration_seconds);
+
+        // False when days is outside [1, kMaxWindowDays] - the caller scans instead
+        bool window(int days, SleepWindowStats& stats) const;
+
+        int64_t today() const { return current_day; }
+
+        static int64_t day_index(int64_t epoch_seconds);     // civil::local_day
+        static int64_t window_start(int64_t today, int days); // epoch seconds of the window's first midnight
+    };
+
+} // namespace descansa
+
+#endif // ROLLING_SLEEP_AGGREGATES_H
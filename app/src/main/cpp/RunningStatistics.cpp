@@ -0,0 +1,71 @@
+// RunningStatistics.cpp - Implementation
+#include "RunningStatistics.h"
+#include <cmath>
+
+namespace descansa {
+
+    void RunningStatistics::add(double value) {
+        if (n == 0) {
+            min_value = value;
+            max_value = value;
+        } else {
+            min_value = std::min(min_value, value);
+            max_value = std::max(max_value, value);
+        }
+
+        ++n;
+        double delta = value - mean_value;
+        mean_value += delta / n;
+        m2 += delta * (value - mean_value);
+    }
+
+    void RunningStatistics::merge(const RunningStatistics& other) {
+        if (other.n == 0) return;
+        if (n == 0) {
+            *this = other;
+            return;
+        }
+
+        // Chan et al. pairwise combination
+        size_t combined = n + other.n;
+        double delta = other.mean_value - mean_value;
+        mean_value += delta * other.n / combined;
+        m2 += other.m2 + delta * delta * (static_cast<double>(n) * other.n / combined);
+        min_value = std::min(min_value, other.min_value);
+        max_value = std::max(max_value, other.max_value);
+        n = combined;
+    }
+
+    double RunningStatistics::std_deviation() const {
+        return std::sqrt(variance());
+    }
+
+    double RunningStatistics::sample_std_deviation() const {
+        return std::sqrt(sample_variance());
+    }
+
+    double select_median(std::vector<double>& values) {
+        if (values.empty()) return 0.0;
+
+        std::pair<double, double> middle = select_middle_pair(values);
+        return (middle.first + middle.second) / 2.0;
+    }
+
+    double select_percentile(std::vector<double>& values, double fraction) {
+        if (values.empty()) return 0.0;
+
+        fraction = std::min(1.0, std::max(0.0, fraction));
+        double position = fraction * (values.size() - 1);
+        size_t lower_index = static_cast<size_t>(position);
+        double weight = position - lower_index;
+
+        std::vector<double>::iterator lower = values.begin() + static_cast<std::ptrdiff_t>(lower_index);
+        std::nth_element(values.begin(), lower, values.end());
+        if (weight == 0.0 || lower + 1 == values.end()) return *lower;
+
+        // Everything right of the lower rank is >= it, so the next rank is their minimum
+        double upper = *std::min_element(lower + 1, values.end());
+        return *lower + weight * (upper - *lower);
+    }
+
+} // namespace descansa
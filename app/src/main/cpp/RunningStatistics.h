@@ -0,0 +1,61 @@
+// RunningStatistics.h - One-pass moments and selection-based order statistics
+#ifndef RUNNING_STATISTICS_H
+#define RUNNING_STATISTICS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace descansa {
+
+// Welford mean/variance plus min/max, updated one value at a time. Stable
+// for large offsets such as epoch seconds; two accumulators can be merged.
+    class RunningStatistics {
+    private:
+        size_t n;
+        double mean_value;
+        double m2;              // sum of squared deviations from the mean
+        double min_value;
+        double max_value;
+
+    public:
+        RunningStatistics() : n(0), mean_value(0.0), m2(0.0), min_value(0.0), max_value(0.0) {}
+
+        void clear() { *this = RunningStatistics(); }
+        void add(double value);
+        void merge(const RunningStatistics& other);
+
+        size_t count() const { return n; }
+        bool empty() const { return n == 0; }
+        double mean() const { return mean_value; }
+        double min() const { return min_value; }     // 0 when empty
+        double max() const { return max_value; }     // 0 when empty
+
+        double variance() const { return n > 0 ? m2 / n : 0.0; }                 // population
+        double sample_variance() const { return n > 1 ? m2 / (n - 1) : 0.0; }
+        double std_deviation() const;
+        double sample_std_deviation() const;
+    };
+
+// The two middle order statistics of a non-empty vector (equal when the size
+// is odd), found with nth_element: linear time, and the vector is only
+// partially reordered.
+    template <typename T, typename Allocator>
+    std::pair<T, T> select_middle_pair(std::vector<T, Allocator>& values) {
+        typename std::vector<T, Allocator>::iterator upper = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+        std::nth_element(values.begin(), upper, values.end());
+        if (values.size() % 2 != 0) return std::make_pair(*upper, *upper);
+
+        // Everything left of the upper middle is <= it, so the lower middle is their maximum
+        return std::make_pair(*std::max_element(values.begin(), upper), *upper);
+    }
+
+// Median and linearly interpolated percentile (fraction in [0, 1]) by selection;
+// both reorder the vector and return 0 when it is empty
+    double select_median(std::vector<double>& values);
+    double select_percentile(std::vector<double>& values, double fraction);
+
+} // namespace descansa
+
+#endif // RUNNING_STATISTICS_H
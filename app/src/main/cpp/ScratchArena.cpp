@@ -0,0 +1,75 @@
+// ScratchArena.cpp - Implementation
+#include "ScratchArena.h"
+#include <cstdint>
+
+namespace descansa {
+
+    const size_t ScratchArena::kDefaultBlockSize;
+
+    void* ScratchArena::allocate(size_t bytes, size_t alignment) {
+        if (bytes == 0) bytes = 1;
+
+        // Current block first, then any later block kept from an earlier call
+        for (size_t index = current_block; index < blocks.size(); ++index) {
+            Block& block = blocks[index];
+            size_t start = index == current_block ? offset : 0;
+            uintptr_t address = reinterpret_cast<uintptr_t>(block.data.get()) + start;
+            size_t padding = (alignment - address % alignment) % alignment;
+
+            if (start + padding + bytes <= block.size) {
+                current_block = index;
+                offset = start + padding + bytes;
+                return block.data.get() + start + padding;
+            }
+        }
+
+        // Grow geometrically so a warm arena ends up as a few large blocks
+        size_t size = blocks.empty() ? kDefaultBlockSize : blocks.back().size * 2;
+        if (size < bytes + alignment) size = bytes + alignment;
+
+        Block block;
+        block.data.reset(new char[size]);
+        block.size = size;
+        blocks.push_back(std::move(block));
+
+        current_block = blocks.size() - 1;
+        offset = 0;
+        return allocate(bytes, alignment);
+    }
+
+    ScratchArena::Marker ScratchArena::mark() const {
+        Marker marker;
+        marker.block = current_block;
+        marker.offset = offset;
+        return marker;
+    }
+
+    void ScratchArena::rewind(const Marker& marker) {
+        current_block = marker.block;
+        offset = marker.offset;
+    }
+
+    void ScratchArena::reset() {
+        current_block = 0;
+        offset = 0;
+    }
+
+    void ScratchArena::release() {
+        blocks.clear();
+        reset();
+    }
+
+    size_t ScratchArena::bytes_reserved() const {
+        size_t total = 0;
+        for (const auto& block : blocks) {
+            total += block.size;
+        }
+        return total;
+    }
+
+    ScratchArena& thread_scratch_arena() {
+        thread_local ScratchArena arena;
+        return arena;
+    }
+
+} // namespace descansa
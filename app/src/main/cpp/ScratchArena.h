@@ -0,0 +1,112 @@
+// ScratchArena.h - Per-thread bump allocator for analytics temporaries
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace descansa {
+
+// Monotonic arena: allocation bumps a pointer inside a large block, freeing
+// is a no-op, and rewinding to a marker releases everything allocated since
+// in O(1). Blocks are kept after a rewind, so a thread's arena warms up once
+// and later calls allocate nothing from the heap.
+    class ScratchArena {
+    public:
+        static const size_t kDefaultBlockSize = 64 * 1024;
+
+        struct Marker {
+            size_t block;
+            size_t offset;
+        };
+
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size;
+        };
+
+        std::vector<Block> blocks;
+        size_t current_block;
+        size_t offset;
+
+        ScratchArena(const ScratchArena&);
+        ScratchArena& operator=(const ScratchArena&);
+
+    public:
+        ScratchArena() : current_block(0), offset(0) {}
+
+        void* allocate(size_t bytes, size_t alignment);
+
+        Marker mark() const;
+        void rewind(const Marker& marker);
+        void reset();                   // rewind to empty, keeping the blocks
+        void release();                 // give the blocks back to the heap (no scope open)
+
+        size_t block_count() const { return blocks.size(); }
+        size_t bytes_reserved() const;
+    };
+
+// The calling thread's arena
+    ScratchArena& thread_scratch_arena();
+
+// Standard allocator over an arena; deallocate does nothing
+    template <typename T>
+    class ArenaAllocator {
+    public:
+        typedef T value_type;
+
+        ScratchArena* arena;
+
+        explicit ArenaAllocator(ScratchArena& owner) : arena(&owner) {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+        T* allocate(size_t count) {
+            return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, size_t) {}
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena == b.arena; }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.arena != b.arena; }
+
+    template <typename T>
+    using ScratchVector = std::vector<T, ArenaAllocator<T>>;
+
+// Marks the thread's arena on entry and rewinds it on exit. Containers built
+// from it must not outlive it, and must not grow while a nested scope is
+// open (the growth would land in memory the inner scope hands back).
+    class ScratchScope {
+    private:
+        ScratchArena& arena;
+        ScratchArena::Marker marker;
+
+        ScratchScope(const ScratchScope&);
+        ScratchScope& operator=(const ScratchScope&);
+
+    public:
+        ScratchScope() : arena(thread_scratch_arena()), marker(arena.mark()) {}
+        ~ScratchScope() { arena.rewind(marker); }
+
+        template <typename T>
+        ArenaAllocator<T> allocator() const { return ArenaAllocator<T>(arena); }
+
+        // An empty vector with room for count elements
+        template <typename T>
+        ScratchVector<T> vector(size_t reserve_count = 0) const {
+            ScratchVector<T> values(allocator<T>());
+            values.reserve(reserve_count);
+            return values;
+        }
+    };
+
+} // namespace descansa
+
+#endif // SCRATCH_ARENA_H
@@ -0,0 +1,214 @@
+// SensorPipeline.cpp - Implementation
+#include "SensorPipeline.h"
+#include "TraceBuffer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace descansa {
+
+    namespace {
+
+        const double kStandardGravity = 9.80665;    // m/s^2
+        const double kDeadbandG = 0.05;             // tremor and sensor noise
+        const int64_t kMaxSampleGapMs = 1000;       // longer gaps count as missing data
+        const size_t kDrainBatch = 256;
+
+    } // namespace
+
+// ActivityEpochBuilder
+    ActivityEpochBuilder::ActivityEpochBuilder(int32_t epoch_seconds)
+            : epoch_length(epoch_seconds > 0 ? epoch_seconds : Hypnogram::kDefaultEpochSeconds) {
+        reset();
+    }
+
+    void ActivityEpochBuilder::reset() {
+        epoch_start = 0;
+        epoch_open = false;
+        excess_g_seconds = 0.0;
+        samples_in_epoch = 0;
+        last_timestamp_ms = -1;
+    }
+
+    void ActivityEpochBuilder::close_epoch(std::vector<ActivityEpoch>& completed) {
+        ActivityEpoch epoch;
+        epoch.start_seconds = epoch_start;
+        epoch.epoch_seconds = epoch_length;
+        epoch.activity_count = static_cast<uint32_t>(std::llround(excess_g_seconds * 100.0));
+        epoch.sample_count = samples_in_epoch;
+        completed.push_back(epoch);
+
+        epoch_open = false;
+        excess_g_seconds = 0.0;
+        samples_in_epoch = 0;
+    }
+
+    void ActivityEpochBuilder::add(const AccelerometerSample* samples, size_t count,
+                                   std::vector<ActivityEpoch>& completed) {
+        int64_t epoch_ms = static_cast<int64_t>(epoch_length) * 1000;
+
+        for (size_t index = 0; index < count; ++index) {
+            const AccelerometerSample& sample = samples[index];
+            int64_t start = sample.timestamp_ms / epoch_ms * epoch_length;
+
+            // A late sample stays in the open epoch rather than reopening a closed one
+            if (epoch_open && start > epoch_start) close_epoch(completed);
+            if (!epoch_open) {
+                epoch_start = start;
+                epoch_open = true;
+            }
+
+            double magnitude = std::sqrt(static_cast<double>(sample.x) * sample.x +
+                                         static_cast<double>(sample.y) * sample.y +
+                                         static_cast<double>(sample.z) * sample.z) / kStandardGravity;
+            double excess = std::max(std::fabs(magnitude - 1.0) - kDeadbandG, 0.0);
+
+            // Rectangle rule over the gap since the previous sample
+            if (last_timestamp_ms >= 0 && sample.timestamp_ms > last_timestamp_ms) {
+                int64_t gap = std::min(sample.timestamp_ms - last_timestamp_ms, kMaxSampleGapMs);
+                excess_g_seconds += excess * static_cast<double>(gap) / 1000.0;
+            }
+            last_timestamp_ms = std::max(last_timestamp_ms, sample.timestamp_ms);
+            samples_in_epoch++;
+        }
+    }
+
+    void ActivityEpochBuilder::flush(std::vector<ActivityEpoch>& completed) {
+        if (epoch_open) close_epoch(completed);
+    }
+
+// SensorPipeline
+    const size_t SensorPipeline::kDefaultCapacity;
+
+    SensorPipeline::SensorPipeline(EpochSink epoch_sink, size_t capacity, int32_t epoch_seconds,
+                                   std::chrono::milliseconds poll)
+            : queue(capacity), builder(epoch_seconds), sink(std::move(epoch_sink)), poll_interval(poll),
+              accepting(false), samples_dropped(0), epochs_emitted(0), active(false), idle(true), exiting(false) {}
+
+    SensorPipeline::~SensorPipeline() {
+        stop();
+
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            exiting = true;
+        }
+        wake.notify_all();
+        if (consumer.joinable()) consumer.join();
+    }
+
+    void SensorPipeline::start() {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        if (active) return;
+
+        // The consumer is idle until active is set, so this thread may drain stale samples
+        AccelerometerSample discarded[kDrainBatch];
+        while (queue.pop(discarded, kDrainBatch) > 0) {}
+        builder.reset();
+
+        active = true;
+        idle = false;
+        accepting.store(true, std::memory_order_release);
+        if (!consumer.joinable()) {
+            consumer = std::thread(&SensorPipeline::run, this);
+        }
+        wake.notify_all();
+    }
+
+    void SensorPipeline::stop() {
+        accepting.store(false, std::memory_order_release);
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        if (!active) return;
+
+        active = false;
+        wake.notify_all();
+        wake.wait(lock, [this] { return idle; });
+    }
+
+    size_t SensorPipeline::push_samples(const AccelerometerSample* samples, size_t count) {
+        if (!accepting.load(std::memory_order_acquire)) return 0;
+
+        size_t accepted = queue.push(samples, count);
+        if (accepted < count) {
+            samples_dropped.fetch_add(count - accepted, std::memory_order_relaxed);
+        }
+        return accepted;
+    }
+
+    void SensorPipeline::drain(std::vector<ActivityEpoch>& completed) {
+        AccelerometerSample batch[kDrainBatch];
+        size_t popped;
+        while ((popped = queue.pop(batch, kDrainBatch)) > 0) {
+            builder.add(batch, popped, completed);
+        }
+    }
+
+    void SensorPipeline::deliver(std::vector<ActivityEpoch>& completed) {
+        for (const auto& epoch : completed) {
+            if (sink) sink(epoch);
+        }
+        epochs_emitted.fetch_add(completed.size(), std::memory_order_relaxed);
+        completed.clear();
+    }
+
+    void SensorPipeline::run() {
+        std::vector<ActivityEpoch> completed;
+        std::unique_lock<std::mutex> lock(wake_mutex);
+
+        while (!exiting) {
+            if (!active) {
+                if (!idle) {
+                    // stop() was called after the last push: take what's left, then the partial epoch
+                    lock.unlock();
+                    drain(completed);
+                    builder.flush(completed);
+                    deliver(completed);
+                    lock.lock();
+
+                    idle = true;
+                    wake.notify_all();
+                }
+                // A start() and stop() can both land while this waits; idle then still needs the flush
+                wake.wait(lock, [this] { return active || !idle || exiting; });
+                continue;
+            }
+
+            lock.unlock();
+            if (queue.size_approx() > 0) {
+                DESCANSA_TRACE_SCOPE("SensorPipeline::drain");
+                drain(completed);
+                deliver(completed);
+            }
+            lock.lock();
+
+            wake.wait_for(lock, poll_interval, [this] { return !active || exiting; });
+        }
+    }
+
+// SyntheticAccelerometer
+    SyntheticAccelerometer::SyntheticAccelerometer(int64_t start_ms, int32_t rate_hz, uint32_t seed)
+            : next_ms(start_ms), period_ms(1000 / std::max(1, std::min(rate_hz, 1000))),
+              state(seed != 0 ? seed : 1) {}
+
+    float SyntheticAccelerometer::next_unit() {
+        // xorshift32
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return static_cast<float>(state) / 2147483648.0f - 1.0f;
+    }
+
+    void SyntheticAccelerometer::generate(AccelerometerSample* out, size_t count, double movement_g) {
+        const float noise = 0.01f;
+        float movement = static_cast<float>(movement_g);
+
+        for (size_t index = 0; index < count; ++index) {
+            AccelerometerSample& sample = out[index];
+            sample.timestamp_ms = next_ms;
+            sample.x = static_cast<float>((noise * next_unit() + movement * next_unit()) * kStandardGravity);
+            sample.y = static_cast<float>((noise * next_unit() + movement * next_unit()) * kStandardGravity);
+            sample.z = static_cast<float>((1.0f + noise * next_unit() + movement * next_unit()) * kStandardGravity);
+            next_ms += period_ms;
+        }
+    }
+
+} // namespace descansa
@@ -0,0 +1,142 @@
+// SensorPipeline.h - Accelerometer ingestion into per-epoch activity counts
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Hypnogram.h"
+#include "SpscRingBuffer.h"
+
+namespace descansa {
+
+// One accelerometer reading in m/s^2, as the platform sensor reports it
+    struct AccelerometerSample {
+        int64_t timestamp_ms;
+        float x;
+        float y;
+        float z;
+    };
+
+// Movement within one epoch. The count is the acceleration above a small
+// deadband around 1 g, integrated over time, in 0.01 g*s - independent of the
+// sample rate, so batches from different devices score alike.
+    struct ActivityEpoch {
+        int64_t start_seconds;      // on the wall-clock epoch grid
+        int32_t epoch_seconds;
+        uint32_t activity_count;
+        uint32_t sample_count;
+    };
+
+// Folds a time-ordered sample stream into fixed epochs aligned to multiples
+// of the epoch length. Epochs without samples are not emitted.
+    class ActivityEpochBuilder {
+    private:
+        int32_t epoch_length;
+        int64_t epoch_start;
+        bool epoch_open;
+        double excess_g_seconds;
+        uint32_t samples_in_epoch;
+        int64_t last_timestamp_ms;
+
+        void close_epoch(std::vector<ActivityEpoch>& completed);
+
+    public:
+        explicit ActivityEpochBuilder(int32_t epoch_seconds = Hypnogram::kDefaultEpochSeconds);
+
+        void reset();
+        int32_t epoch_seconds() const { return epoch_length; }
+
+        // Appends every epoch the samples complete
+        void add(const AccelerometerSample* samples, size_t count, std::vector<ActivityEpoch>& completed);
+
+        // Closes the partial epoch, if any
+        void flush(std::vector<ActivityEpoch>& completed);
+    };
+
+// Sensor thread -> SpscRingBuffer -> consumer thread -> epoch sink.
+// push_samples() is the only producer-side call: it never blocks or
+// allocates, and a burst that doesn't fit is dropped and counted. While
+// running, the consumer wakes every poll interval, drains the ring in
+// batches and hands each finished epoch to the sink on its own thread, so
+// the sink must do its own synchronization. stop() drains what is queued and
+// flushes the last partial epoch before returning. One consumer thread
+// serves every start/stop cycle; it sleeps without polling while stopped.
+    class SensorPipeline {
+    public:
+        typedef std::function<void(const ActivityEpoch&)> EpochSink;
+
+        static const size_t kDefaultCapacity = 16384;  // ~10 min at 25 Hz
+
+    private:
+        SpscRingBuffer<AccelerometerSample> queue;
+        ActivityEpochBuilder builder;           // consumer side only
+        EpochSink sink;
+        std::chrono::milliseconds poll_interval;
+
+        std::atomic<bool> accepting;
+        std::atomic<uint64_t> samples_dropped;
+        std::atomic<uint64_t> epochs_emitted;
+
+        std::mutex wake_mutex;                  // consumer and start/stop only
+        std::condition_variable wake;           // both directions
+        bool active;                            // between start() and stop()
+        bool idle;                              // consumer has flushed since the last stop()
+        bool exiting;
+        std::thread consumer;                   // started by the first start()
+
+        void run();
+        void drain(std::vector<ActivityEpoch>& completed);
+        void deliver(std::vector<ActivityEpoch>& completed);
+
+        SensorPipeline(const SensorPipeline&) = delete;
+        SensorPipeline& operator=(const SensorPipeline&) = delete;
+
+    public:
+        explicit SensorPipeline(EpochSink epoch_sink,
+                                size_t capacity = kDefaultCapacity,
+                                int32_t epoch_seconds = Hypnogram::kDefaultEpochSeconds,
+                                std::chrono::milliseconds poll = std::chrono::milliseconds(100));
+        ~SensorPipeline();
+
+        // Discards anything queued while stopped and resumes the consumer
+        void start();
+        // Call once the producer has stopped pushing; returns after the flush
+        void stop();
+        bool is_running() const { return accepting.load(std::memory_order_acquire); }
+
+        // Producer thread only. Returns how many samples were queued; 0 while stopped.
+        size_t push_samples(const AccelerometerSample* samples, size_t count);
+
+        uint64_t get_dropped_samples() const { return samples_dropped.load(std::memory_order_relaxed); }
+        uint64_t get_epoch_count() const { return epochs_emitted.load(std::memory_order_relaxed); }
+    };
+
+// Deterministic sample stream for host tests and the benchmark: gravity on
+// the z axis plus sensor noise below the deadband, and optional movement of
+// the given amplitude (in g) on every axis.
+    class SyntheticAccelerometer {
+    private:
+        int64_t next_ms;
+        int32_t period_ms;
+        uint32_t state;
+
+        float next_unit();      // uniform in [-1, 1]
+
+    public:
+        SyntheticAccelerometer(int64_t start_ms, int32_t rate_hz = 25, uint32_t seed = 1);
+
+        void generate(AccelerometerSample* out, size_t count, double movement_g);
+        int64_t next_timestamp_ms() const { return next_ms; }
+        int32_t rate_hz() const { return 1000 / period_ms; }
+    };
+
+} // namespace descansa
+
+#endif // SENSOR_PIPELINE_H
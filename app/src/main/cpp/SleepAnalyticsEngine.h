@@ -0,0 +1,237 @@
+// SleepAnalyticsEngine.h - Advanced C++11 Sleep Analysis
+#ifndef SLEEP_ANALYTICS_ENGINE_H
+#define SLEEP_ANALYTICS_ENGINE_H
+
+#include "SleepDataStructures.h"
+#include "DetailedSessionColumns.h"
+#include "ConstSpan.h"
+#include <vector>
+#include <map>
+#include <string>
+
+namespace descansa {
+
+// Advanced statistical analysis for sleep patterns
+    class SleepAnalyticsEngine {
+    private:
+        const std::vector<DetailedSleepSession>& sessions;
+        const std::vector<DailySleepSummary>& daily_summaries;
+
+        // Kernels read the columnar view; it is built here unless the caller
+        // already keeps one in sync (declared first - columns may refer to it)
+        DetailedSessionColumns owned_columns;
+        const DetailedSessionColumns& columns;
+
+        // Statistical helper methods
+        double calculate_mean(ConstSpan<double> values) const;
+        double calculate_median(std::vector<double> values) const;
+        double calculate_std_deviation(ConstSpan<double> values) const;
+        double calculate_correlation(ConstSpan<double> x, ConstSpan<double> y) const;
+
+        // Pattern detection algorithms
+        std::vector<int> detect_outliers(const std::vector<double>& values, double threshold = 2.0) const;
+        std::vector<double> apply_moving_average(const std::vector<double>& values, int window_size) const;
+        bool detect_trend(const std::vector<double>& values, double& slope, double& confidence) const;
+
+        // Sleep cycle analysis
+        std::vector<double> estimate_sleep_cycles(const DetailedSleepSession& session) const;
+        double calculate_sleep_consistency_score(const std::vector<DailySleepSummary>& summaries) const;
+
+    public:
+        SleepAnalyticsEngine(const std::vector<DetailedSleepSession>& session_data,
+                             const std::vector<DailySleepSummary>& summary_data);
+        SleepAnalyticsEngine(const std::vector<DetailedSleepSession>& session_data,
+                             const DetailedSessionColumns& session_columns,
+                             const std::vector<DailySleepSummary>& summary_data);
+
+        // Advanced pattern recognition
+        struct SleepPattern {
+            std::string pattern_type;
+            double confidence_score;
+            std::string description;
+            std::vector<std::string> recommendations;
+
+            SleepPattern(const std::string& type, double confidence, const std::string& desc)
+                    : pattern_type(type), confidence_score(confidence), description(desc) {}
+        };
+
+        std::vector<SleepPattern> identify_advanced_patterns() const;
+        std::vector<SleepPattern> detect_sleep_disorders() const;
+        std::vector<SleepPattern> analyze_chronotype() const;
+
+        // Predictive modeling
+        struct SleepPrediction {
+            TimePoint predicted_bedtime;
+            TimePoint predicted_wake_time;
+            Duration predicted_sleep_duration;
+            double prediction_confidence;
+            std::string reasoning;
+        };
+
+        SleepPrediction predict_optimal_sleep_schedule() const;
+        SleepPrediction predict_next_sleep_quality() const;
+
+        // Performance optimization
+        struct OptimizationSuggestion {
+            std::string category;
+            std::string specific_action;
+            double expected_improvement;
+            int priority_level; // 1-5, 5 being highest
+            std::string scientific_basis;
+        };
+
+        std::vector<OptimizationSuggestion> generate_optimization_plan() const;
+        std::vector<OptimizationSuggestion> analyze_environmental_factors() const;
+        std::vector<OptimizationSuggestion> optimize_sleep_timing() const;
+
+        // Comparative analysis
+        struct BenchmarkComparison {
+            std::string metric_name;
+            double user_value;
+            double population_average;
+            double population_percentile;
+            std::string interpretation;
+        };
+
+        std::vector<BenchmarkComparison> compare_to_population_norms() const;
+        BenchmarkComparison analyze_sleep_debt_trend() const;
+        BenchmarkComparison analyze_consistency_improvement() const;
+
+        // Advanced statistics
+        struct AdvancedMetrics {
+            double sleep_variability_index;
+            double circadian_rhythm_strength;
+            double sleep_efficiency_trend;
+            double recovery_capability_score;
+            double lifestyle_impact_score;
+
+            std::string generate_interpretation() const;
+        };
+
+        AdvancedMetrics calculate_advanced_metrics() const;
+
+        // Machine learning-style insights (simplified for C++11)
+        struct InsightCluster {
+            std::string insight_category;
+            std::vector<std::string> related_factors;
+            double impact_magnitude;
+            std::string actionable_advice;
+        };
+
+        std::vector<InsightCluster> discover_hidden_insights() const;
+        std::vector<InsightCluster> correlate_lifestyle_factors() const;
+
+        // Reporting and visualization data
+        struct ReportData {
+            std::string report_title;
+            std::map<std::string, double> key_metrics;
+            std::vector<std::string> trend_descriptions;
+            std::vector<std::string> actionable_items;
+            std::string overall_assessment;
+        };
+
+        ReportData generate_comprehensive_report() const;
+        ReportData generate_weekly_progress_report() const;
+        ReportData generate_health_impact_assessment() const;
+    };
+
+// Specialized algorithms for sleep optimization
+    namespace sleep_algorithms {
+
+        // Optimal bedtime calculation using multiple factors
+        TimePoint calculate_optimal_bedtime(const std::vector<DetailedSleepSession>& sessions,
+                                            const SleepGoals& goals,
+                                            const std::vector<double>& quality_scores);
+
+        // Sleep debt recovery planning
+        struct RecoveryPlan {
+            Duration total_debt;
+            std::vector<std::pair<TimePoint, Duration>> recommended_adjustments;
+            int estimated_recovery_days;
+            std::vector<std::string> recovery_strategies;
+        };
+
+        RecoveryPlan calculate_optimal_recovery_plan(const std::vector<DailySleepSummary>& summaries,
+                                                     const SleepGoals& goals);
+
+        // Circadian rhythm optimization
+        struct CircadianOptimization {
+            std::chrono::hours optimal_light_exposure_time;
+            std::chrono::hours optimal_meal_cutoff;
+            std::chrono::hours optimal_exercise_window;
+            std::chrono::hours optimal_caffeine_cutoff;
+            std::vector<std::string> phase_shift_recommendations;
+        };
+
+        CircadianOptimization optimize_circadian_rhythm(const std::vector<DetailedSleepSession>& sessions);
+
+        // Environmental optimization
+        struct EnvironmentalOptimization {
+            double optimal_temperature_range_min;
+            double optimal_temperature_range_max;
+            int max_acceptable_noise_level;
+            int max_acceptable_light_level;
+            std::vector<std::string> environmental_improvements;
+        };
+
+        EnvironmentalOptimization analyze_optimal_environment(const std::vector<DetailedSleepSession>& sessions);
+
+        // Sleep efficiency maximization
+        struct EfficiencyOptimization {
+            Duration recommended_time_in_bed_adjustment;
+            std::vector<std::string> efficiency_improvement_tactics;
+            double target_efficiency_achievable;
+            int estimated_improvement_weeks;
+        };
+
+        EfficiencyOptimization optimize_sleep_efficiency(const std::vector<DetailedSleepSession>& sessions,
+                                                         const SleepGoals& goals);
+
+        // Advanced trend analysis
+        enum class TrendDirection { IMPROVING, STABLE, DECLINING, VOLATILE };
+
+        struct TrendAnalysis {
+            TrendDirection direction;
+            double trend_strength; // 0.0 to 1.0
+            double volatility_index;
+            std::vector<TimePoint> significant_change_points;
+            std::string trend_interpretation;
+        };
+
+        TrendAnalysis analyze_sleep_quality_trend(const std::vector<DailySleepSummary>& summaries,
+                                                  int analysis_window_days = 30);
+
+        TrendAnalysis analyze_duration_consistency_trend(const std::vector<DetailedSleepSession>& sessions,
+                                                         int analysis_window_days = 30);
+
+        // Predictive sleep quality modeling
+        struct QualityPrediction {
+            SleepQuality predicted_quality;
+            double confidence_interval;
+            std::vector<std::string> influencing_factors;
+            std::vector<std::string> mitigation_strategies;
+        };
+
+        QualityPrediction predict_sleep_quality(const DetailedSleepSession& upcoming_session_context,
+                                                const std::vector<DetailedSleepSession>& historical_sessions);
+
+        // Comprehensive sleep score calculation
+        struct ComprehensiveSleepScore {
+            double overall_score; // 0-100
+            double duration_component;
+            double quality_component;
+            double consistency_component;
+            double efficiency_component;
+            double recovery_component;
+            std::string grade_letter; // A+ to F
+            std::string detailed_breakdown;
+        };
+
+        ComprehensiveSleepScore calculate_comprehensive_score(const std::vector<DailySleepSummary>& summaries,
+                                                              const SleepGoals& goals,
+                                                              int evaluation_period_days = 30);
+    }
+
+} // namespace descansa
+
+#endif // SLEEP_ANALYTICS_ENGINE_H
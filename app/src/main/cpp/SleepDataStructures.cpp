@@ -1,4 +1,8 @@
 #include "SleepDataStructures.h"
+#include "CivilTime.h"
+#include "DetailedSessionColumns.h"
+#include "RunningStatistics.h"
+#include "ScratchArena.h"
 #include <algorithm>
 #include <numeric>
 #include <sstream>
@@ -14,8 +18,8 @@ namespace descansa {
               total_awake_time(0), room_temperature(20.0), noise_level(0),
               light_level(0), light_sleep_duration(0), deep_sleep_duration(0),
               rem_sleep_duration(0), is_nap(false), is_complete(false),
-              data_validated(false), created_timestamp(std::chrono::system_clock::now()),
-              modified_timestamp(std::chrono::system_clock::now()) {}
+              data_validated(false), created_timestamp(system_now()),
+              modified_timestamp(system_now()) {}
 
     DetailedSleepSession::DetailedSleepSession(TimePoint start, TimePoint end)
             : DetailedSleepSession() {
@@ -27,9 +31,45 @@ namespace descansa {
         sleep_efficiency = calculate_sleep_efficiency();
     }
 
+    void DetailedSleepSession::set_sleep_phases(const std::vector<SleepPhase>& phases) {
+        // Phases are taken in time order; the grid starts at the first one
+        int64_t origin = to_epoch_seconds(phases.empty() ? sleep_start : phases.front().start_time);
+        hypnogram.reset(origin, hypnogram.epoch_seconds());
+
+        for (const auto& phase : phases) {
+            int64_t begin = to_epoch_seconds(phase.start_time);
+            hypnogram.append_span(begin, begin + phase.duration.count(), phase.stage);
+        }
+        update_stage_durations();
+    }
+
+    std::vector<SleepPhase> DetailedSleepSession::get_sleep_phases() const {
+        std::vector<SleepPhase> phases;
+        std::vector<Hypnogram::StageRun> runs = hypnogram.runs();
+        phases.reserve(runs.size());
+
+        int64_t epoch = hypnogram.epoch_seconds();
+        for (const auto& run : runs) {
+            phases.emplace_back(from_epoch_seconds(hypnogram.start_seconds() + static_cast<int64_t>(run.first_epoch) * epoch),
+                                Duration(static_cast<int64_t>(run.epoch_count) * epoch), run.stage);
+        }
+        return phases;
+    }
+
+    void DetailedSleepSession::update_stage_durations() {
+        light_sleep_duration = hypnogram.total(SleepStage::LIGHT);
+        deep_sleep_duration = hypnogram.total(SleepStage::DEEP);
+        rem_sleep_duration = hypnogram.total(SleepStage::REM);
+    }
+
+    void DetailedSleepSession::update_sleep_duration() {
+        bool scored = hypnogram.epoch_count() > hypnogram.epochs_in(SleepStage::UNKNOWN);
+        total_sleep_duration = scored ? std::min(hypnogram.total_asleep(), time_in_bed) : time_in_bed;
+    }
+
     double DetailedSleepSession::calculate_sleep_efficiency() const {
         if (time_in_bed.count() <= 0) return 0.0;
-        return (total_sleep_duration.count() / time_in_bed.count()) * 100.0;
+        return (static_cast<double>(total_sleep_duration.count()) / time_in_bed.count()) * 100.0;
     }
 
     Duration DetailedSleepSession::get_sleep_latency() const {
@@ -63,11 +103,11 @@ namespace descansa {
             : total_sleep_time(0), total_time_in_bed(0), total_awakenings(0),
               average_sleep_efficiency(0.0), daily_steps(0), daily_screen_time_minutes(0),
               stress_level(5), sleep_debt(0), cumulative_sleep_debt(0),
-              target_sleep_duration(Duration(8 * 3600)), met_sleep_goal(false) {
-        date = std::chrono::system_clock::now();
+              target_sleep_duration(Hours(8)), met_sleep_goal(false) {
+        date = system_now();
     }
 
-    DailySleepSummary::DailySleepSummary(const std::chrono::system_clock::time_point& day)
+    DailySleepSummary::DailySleepSummary(const TimePoint& day)
             : DailySleepSummary() {
         date = day;
     }
@@ -86,7 +126,7 @@ namespace descansa {
 
         // Calculate average efficiency
         if (total_time_in_bed.count() > 0) {
-            average_sleep_efficiency = (total_sleep_time.count() / total_time_in_bed.count()) * 100.0;
+            average_sleep_efficiency = (static_cast<double>(total_sleep_time.count()) / total_time_in_bed.count()) * 100.0;
         }
 
         // Calculate sleep debt
@@ -95,18 +135,22 @@ namespace descansa {
     }
 
     double DailySleepSummary::get_sleep_score() const {
+        return score_for(total_sleep_time, average_sleep_efficiency, main_sleep.perceived_quality);
+    }
+
+    double DailySleepSummary::score_for(Duration sleep_time, double efficiency, SleepQuality quality) {
         double score = 0.0;
 
         // Duration score (40% of total)
-        double duration_hours = total_sleep_time.count() / 3600.0;
+        double duration_hours = sleep_time.count() / 3600.0;
         double duration_score = std::min(100.0, (duration_hours / 8.0) * 100.0);
         score += duration_score * 0.4;
 
         // Efficiency score (30% of total)
-        score += average_sleep_efficiency * 0.3;
+        score += efficiency * 0.3;
 
         // Quality score (20% of total)
-        double quality_score = static_cast<double>(main_sleep.perceived_quality) * 25.0;
+        double quality_score = static_cast<double>(quality) * 25.0;
         score += quality_score * 0.2;
 
         // Consistency score (10% of total)
@@ -122,10 +166,10 @@ namespace descansa {
               average_wake_time_variance(0), average_sleep_efficiency(0.0),
               average_sleep_score(0.0), has_consistent_schedule(false),
               weekend_schedule_shift_minutes(0) {
-        week_start = std::chrono::system_clock::now();
+        week_start = system_now();
     }
 
-    WeeklySleepPattern::WeeklySleepPattern(const std::chrono::system_clock::time_point& start)
+    WeeklySleepPattern::WeeklySleepPattern(const TimePoint& start)
             : WeeklySleepPattern() {
         week_start = start;
     }
@@ -145,7 +189,7 @@ namespace descansa {
         }
 
         size_t count = daily_summaries.size();
-        average_sleep_duration = Duration(total_sleep.count() / count);
+        average_sleep_duration = total_sleep / static_cast<int64_t>(count);
         average_sleep_efficiency = total_efficiency / count;
         average_sleep_score = total_score / count;
 
@@ -184,19 +228,15 @@ namespace descansa {
     double WeeklySleepPattern::calculate_schedule_consistency() const {
         if (daily_summaries.size() < 2) return 1.0;
 
-        // Calculate variance in bedtimes and wake times
-        std::vector<double> bedtimes, wake_times;
+        // Calculate variance in bedtimes and wake times (buffers from the thread's arena)
+        ScratchScope scratch;
+        ScratchVector<double> bedtimes = scratch.vector<double>(daily_summaries.size());
+        ScratchVector<double> wake_times = scratch.vector<double>(daily_summaries.size());
 
         for (const auto& day : daily_summaries) {
             if (day.has_main_sleep()) {
-                auto bedtime_t = std::chrono::system_clock::to_time_t(day.main_sleep.sleep_start);
-                auto wake_time_t = std::chrono::system_clock::to_time_t(day.main_sleep.wake_up);
-
-                auto bed_tm = *std::localtime(&bedtime_t);
-                auto wake_tm = *std::localtime(&wake_time_t);
-
-                double bed_minutes = bed_tm.tm_hour * 60 + bed_tm.tm_min;
-                double wake_minutes = wake_tm.tm_hour * 60 + wake_tm.tm_min;
+                double bed_minutes = civil::to_local(day.main_sleep.sleep_start).minute_of_day();
+                double wake_minutes = civil::to_local(day.main_sleep.wake_up).minute_of_day();
 
                 bedtimes.push_back(bed_minutes);
                 wake_times.push_back(wake_minutes);
@@ -206,7 +246,7 @@ namespace descansa {
         if (bedtimes.empty()) return 1.0;
 
         // Calculate standard deviation
-        auto calc_std_dev = [](const std::vector<double>& values) {
+        auto calc_std_dev = [](const ScratchVector<double>& values) {
             double mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
             double sq_sum = 0.0;
             for (double value : values) {
@@ -230,7 +270,7 @@ namespace descansa {
     SleepEnvironment::SleepEnvironment()
             : temperature(20.0), humidity(50.0), noise_level(0), light_level(0),
               screen_time_minutes(0), used_sleep_aid(false) {
-        measurement_time = std::chrono::system_clock::now();
+        measurement_time = system_now();
     }
 
     bool SleepEnvironment::is_environment_optimal() const {
@@ -262,18 +302,18 @@ namespace descansa {
 
 // SleepGoals Implementation
     SleepGoals::SleepGoals()
-            : target_sleep_duration(Duration(8 * 3600)),
+            : target_sleep_duration(Hours(8)),
               preferred_bedtime(std::chrono::hours(22)),
               preferred_wake_time(std::chrono::hours(6)),
-              bedtime_tolerance(Duration(30 * 60)),
-              wake_time_tolerance(Duration(30 * 60)),
+              bedtime_tolerance(std::chrono::minutes(30)),
+              wake_time_tolerance(std::chrono::minutes(30)),
               target_sleep_efficiency(85.0),
               max_acceptable_awakenings(2),
-              max_acceptable_sleep_latency(Duration(30 * 60)),
+              max_acceptable_sleep_latency(std::chrono::minutes(30)),
               weekend_schedule_differs(true),
-              weekend_sleep_extension(Duration(60 * 60)),
+              weekend_sleep_extension(Hours(1)),
               allow_naps(true),
-              max_nap_duration(Duration(30 * 60)),
+              max_nap_duration(std::chrono::minutes(30)),
               latest_nap_time(std::chrono::hours(15)) {}
 
     bool SleepGoals::is_within_tolerance(const DetailedSleepSession& session) const {
@@ -300,7 +340,7 @@ namespace descansa {
         double score = 0.0;
 
         // Duration adherence (40%)
-        double duration_ratio = summary.total_sleep_time.count() / target_sleep_duration.count();
+        double duration_ratio = static_cast<double>(summary.total_sleep_time.count()) / target_sleep_duration.count();
         double duration_score = std::min(1.0, duration_ratio);
         score += duration_score * 0.4;
 
@@ -326,57 +366,69 @@ namespace descansa {
               total_awakenings(0), sleep_duration_trend(Trend::STABLE),
               sleep_quality_trend(Trend::STABLE), schedule_consistency_trend(Trend::STABLE),
               total_sleep_debt(0), average_daily_sleep_debt(0), days_with_sleep_debt(0) {
-        analysis_period_start = std::chrono::system_clock::now();
-        analysis_period_end = std::chrono::system_clock::now();
+        analysis_period_start = system_now();
+        analysis_period_end = system_now();
     }
 
     void SleepStatistics::calculate_from_sessions(const std::vector<DetailedSleepSession>& sessions) {
-        if (sessions.empty()) return;
-
-        total_sessions = static_cast<int>(sessions.size());
+        DetailedSessionColumns columns;
+        columns.assign(sessions);
+        calculate_from_columns(columns, 0, columns.size());
+    }
 
-        // Duration statistics
-        std::vector<double> durations;
-        Duration total_duration(0);
+    void SleepStatistics::calculate_from_columns(const DetailedSessionColumns& columns, size_t first, size_t last) {
+        last = std::min(last, columns.size());
+        if (first >= last) return;
+
+        const int64_t* session_durations = columns.durations();
+        const double* efficiencies = columns.efficiencies();
+        const int32_t* awakenings = columns.awakenings();
+        const uint8_t* qualities = columns.qualities();
+
+        // One traversal: exact integer total for the average, Welford for the
+        // spread and extremes, quality counts for the mode
+        ScratchScope scratch;
+        ScratchVector<int64_t> durations = scratch.vector<int64_t>(last - first);
+        RunningStatistics duration_stats;
+        int64_t total_seconds = 0;
         double total_efficiency = 0.0;
+        int quality_counts[5] = {0, 0, 0, 0, 0};
 
-        for (const auto& session : sessions) {
-            double hours = session.total_sleep_duration.count() / 3600.0;
-            durations.push_back(hours);
-            total_duration += session.total_sleep_duration;
-            total_efficiency += session.sleep_efficiency;
-            total_awakenings += session.awakenings_count;
+        for (size_t row = first; row < last; ++row) {
+            if (!columns.is_complete(row)) continue;
 
-            if (session.total_sleep_duration < shortest_sleep) {
-                shortest_sleep = session.total_sleep_duration;
-            }
-            if (session.total_sleep_duration > longest_sleep) {
-                longest_sleep = session.total_sleep_duration;
-            }
+            durations.push_back(session_durations[row]);
+            duration_stats.add(static_cast<double>(session_durations[row]));
+            total_seconds += session_durations[row];
+            total_efficiency += efficiencies[row];
+            total_awakenings += awakenings[row];
+            if (qualities[row] < 5) ++quality_counts[qualities[row]];
         }
+        if (durations.empty()) return;
 
-        average_sleep_duration = Duration(total_duration.count() / total_sessions);
+        total_sessions = static_cast<int>(durations.size());
+        average_sleep_duration = Duration(total_seconds / total_sessions);
         average_sleep_efficiency = total_efficiency / total_sessions;
-
-        // Median calculation
-        std::sort(durations.begin(), durations.end());
-        if (durations.size() % 2 == 0) {
-            median_sleep_duration = Duration((durations[durations.size()/2 - 1] +
-                                              durations[durations.size()/2]) * 3600.0 / 2.0);
-        } else {
-            median_sleep_duration = Duration(durations[durations.size()/2] * 3600.0);
-        }
-
-        // Standard deviation
-        double mean_hours = average_sleep_duration.count() / 3600.0;
-        double variance = 0.0;
-        for (double duration : durations) {
-            variance += (duration - mean_hours) * (duration - mean_hours);
+        shortest_sleep = Duration(static_cast<int64_t>(duration_stats.min()));
+        longest_sleep = Duration(static_cast<int64_t>(duration_stats.max()));
+        sleep_duration_std_dev = Duration(std::llround(duration_stats.std_deviation()));
+
+        // Median by selection - linear, no sort
+        std::pair<int64_t, int64_t> middle = select_middle_pair(durations);
+        median_sleep_duration = Duration((middle.first + middle.second) / 2);
+
+        // Most common rated quality; UNKNOWN only when nothing was rated
+        int best_quality = 0, best_count = 0;
+        for (int quality = 1; quality < 5; ++quality) {
+            if (quality_counts[quality] > best_count) {
+                best_quality = quality;
+                best_count = quality_counts[quality];
+            }
         }
-        sleep_duration_std_dev = Duration(std::sqrt(variance / durations.size()) * 3600.0);
+        most_common_quality = static_cast<SleepQuality>(best_quality);
     }
 
-    void SleepStatistics::calculate_trends(const std::vector<DailySleepSummary>& daily_data) {
+    void SleepStatistics::calculate_trends(ConstSpan<DailySleepSummary> daily_data) {
         if (daily_data.size() < 7) return; // Need at least a week for trend analysis
 
         // Simple trend calculation: compare first half vs second half
@@ -391,10 +443,11 @@ namespace descansa {
             second_half_avg += daily_data[i].total_sleep_time;
         }
 
-        first_half_avg = Duration(first_half_avg.count() / mid_point);
-        second_half_avg = Duration(second_half_avg.count() / (daily_data.size() - mid_point));
+        first_half_avg /= static_cast<int64_t>(mid_point);
+        second_half_avg /= static_cast<int64_t>(daily_data.size() - mid_point);
 
-        double duration_change = (second_half_avg.count() - first_half_avg.count()) / first_half_avg.count();
+        double duration_change = static_cast<double>(second_half_avg.count() - first_half_avg.count()) /
+                                 first_half_avg.count();
 
         if (duration_change > 0.05) {
             sleep_duration_trend = Trend::IMPROVING;
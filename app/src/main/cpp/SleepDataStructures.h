@@ -6,12 +6,13 @@
 #include <string>
 #include <map>
 #include <cstdint>
+#include "TimeTypes.h"
+#include "ConstSpan.h"
+#include "Hypnogram.h"
 
 namespace descansa {
 
-// Time utilities
-    using TimePoint = std::chrono::system_clock::time_point;
-    using Duration = std::chrono::duration<double>;
+    class DetailedSessionColumns;
 
 // Sleep quality indicators
     enum class SleepQuality {
@@ -22,15 +23,17 @@ namespace descansa {
         EXCELLENT = 4
     };
 
-// Sleep phase data
+// Sleep phase data - one run of a single stage, the expanded form of a Hypnogram
     struct SleepPhase {
         TimePoint start_time;
         Duration duration;
-        std::string phase_type; // "light", "deep", "rem", "awake"
+        SleepStage stage;
 
-        SleepPhase() : duration(0) {}
-        SleepPhase(TimePoint start, Duration dur, const std::string& type)
-                : start_time(start), duration(dur), phase_type(type) {}
+        SleepPhase() : duration(0), stage(SleepStage::UNKNOWN) {}
+        SleepPhase(TimePoint start, Duration dur, SleepStage phase_stage)
+                : start_time(start), duration(dur), stage(phase_stage) {}
+
+        const char* phase_type() const { return sleep_stage_name(stage); }  // "light", "deep", "rem", "awake"
     };
 
 // Detailed sleep session with comprehensive data
@@ -58,8 +61,8 @@ namespace descansa {
         TimePoint last_exercise_time;
         TimePoint screen_time_end;     // when stopped using devices
 
-        // Sleep phases (if available)
-        std::vector<SleepPhase> sleep_phases;
+        // Sleep stages per epoch (if available); the durations below follow it
+        Hypnogram hypnogram;
         Duration light_sleep_duration;
         Duration deep_sleep_duration;
         Duration rem_sleep_duration;
@@ -76,6 +79,16 @@ namespace descansa {
         DetailedSleepSession();
         explicit DetailedSleepSession(TimePoint start, TimePoint end);
 
+        // Phases in and out of the hypnogram (phases are snapped to its epochs)
+        void set_sleep_phases(const std::vector<SleepPhase>& phases);
+        std::vector<SleepPhase> get_sleep_phases() const;
+        void update_stage_durations();
+
+        // Asleep time from the hypnogram when it scores any epochs (capped at
+        // time in bed), else all of time_in_bed. The line format stores only
+        // start, wake and the hypnogram, so this is also how loading recovers it.
+        void update_sleep_duration();
+
         // Analysis methods
         double calculate_sleep_efficiency() const;
         Duration get_sleep_latency() const;      // time to fall asleep
@@ -86,7 +99,7 @@ namespace descansa {
 
 // Daily sleep summary
     struct DailySleepSummary {
-        std::chrono::system_clock::time_point date;
+        TimePoint date;
 
         // Main sleep session
         DetailedSleepSession main_sleep;
@@ -116,16 +129,19 @@ namespace descansa {
         bool met_sleep_goal;
 
         DailySleepSummary();
-        explicit DailySleepSummary(const std::chrono::system_clock::time_point& day);
+        explicit DailySleepSummary(const TimePoint& day);
 
         void calculate_daily_totals();
         bool has_main_sleep() const { return main_sleep.is_complete; }
         double get_sleep_score() const;  // 0-100 sleep quality score
+
+        // The get_sleep_score formula for arbitrary inputs (e.g. one main sleep)
+        static double score_for(Duration sleep_time, double efficiency, SleepQuality quality);
     };
 
 // Weekly sleep pattern analysis
     struct WeeklySleepPattern {
-        std::chrono::system_clock::time_point week_start;
+        TimePoint week_start;
         std::vector<DailySleepSummary> daily_summaries;
 
         // Weekly averages
@@ -144,7 +160,7 @@ namespace descansa {
         std::vector<std::string> recommendations;
 
         WeeklySleepPattern();
-        explicit WeeklySleepPattern(const std::chrono::system_clock::time_point& week_start);
+        explicit WeeklySleepPattern(const TimePoint& week_start);
 
         void analyze_patterns();
         void generate_recommendations();
@@ -243,8 +259,10 @@ namespace descansa {
 
         SleepStatistics();
 
+        // Incomplete sessions are skipped
         void calculate_from_sessions(const std::vector<DetailedSleepSession>& sessions);
-        void calculate_trends(const std::vector<DailySleepSummary>& daily_data);
+        void calculate_from_columns(const DetailedSessionColumns& columns, size_t first, size_t last);
+        void calculate_trends(ConstSpan<DailySleepSummary> daily_data);
         std::string generate_summary_report() const;
     };
 
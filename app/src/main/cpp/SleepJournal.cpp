@@ -0,0 +1,206 @@
+// SleepJournal.cpp - Implementation
+#include "SleepJournal.h"
+#include "DurableFile.h"
+#include <fstream>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace descansa {
+
+    namespace {
+
+        // File header, written once when the journal is created
+        struct JournalHeader {
+            char magic[4];
+            uint32_t version;
+            uint32_t record_size;
+            uint32_t reserved;
+        };
+
+        const char kJournalMagic[4] = {'D', 'S', 'J', '1'};
+        const uint32_t kJournalVersion = 2;
+        const uint32_t kLegacyJournalVersion = 1;
+
+        // Version 1 record: durations were doubles, 64 bytes
+        struct LegacyJournalRecord {
+            uint32_t type;
+            uint32_t checksum;
+            uint64_t sequence;
+            int64_t start_time;
+            int64_t end_time;
+            int64_t recorded_time;
+            double duration_seconds;
+            double target_sleep_seconds;
+            int32_t target_wake_hour;
+            int32_t target_wake_minute;
+        };
+
+        static_assert(sizeof(LegacyJournalRecord) == 64, "Version 1 records are 64 bytes on disk");
+
+        JournalHeader make_header() {
+            JournalHeader header;
+            std::memcpy(header.magic, kJournalMagic, sizeof(header.magic));
+            header.version = kJournalVersion;
+            header.record_size = static_cast<uint32_t>(sizeof(JournalRecord));
+            header.reserved = 0;
+            return header;
+        }
+
+        bool is_valid_header(const JournalHeader& header) {
+            return std::memcmp(header.magic, kJournalMagic, sizeof(header.magic)) == 0 &&
+                   header.version == kJournalVersion &&
+                   header.record_size == sizeof(JournalRecord);
+        }
+
+        bool is_legacy_header(const JournalHeader& header) {
+            return std::memcmp(header.magic, kJournalMagic, sizeof(header.magic)) == 0 &&
+                   header.version == kLegacyJournalVersion &&
+                   header.record_size == sizeof(LegacyJournalRecord);
+        }
+
+        template <typename Record>
+        uint32_t record_checksum(Record record) {
+            record.checksum = 0;
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < sizeof(Record); ++i) {
+                hash ^= bytes[i];
+                hash *= 16777619u;
+            }
+            return hash;
+        }
+
+        int32_t round_seconds(double seconds) {
+            return static_cast<int32_t>(seconds < 0 ? seconds - 0.5 : seconds + 0.5);
+        }
+
+        JournalRecord upgrade(const LegacyJournalRecord& legacy) {
+            JournalRecord record;
+            record.type = legacy.type;
+            record.sequence = legacy.sequence;
+            record.start_time = legacy.start_time;
+            record.end_time = legacy.end_time;
+            record.recorded_time = legacy.recorded_time;
+            record.duration_seconds = round_seconds(legacy.duration_seconds);
+            record.target_sleep_seconds = round_seconds(legacy.target_sleep_seconds);
+            record.target_wake_hour = legacy.target_wake_hour;
+            record.target_wake_minute = legacy.target_wake_minute;
+            return record;
+        }
+
+    } // namespace
+
+    JournalRecord::JournalRecord()
+            : type(0), checksum(0), sequence(0), start_time(0), end_time(0),
+              recorded_time(0), duration_seconds(0), target_sleep_seconds(0),
+              target_wake_hour(0), target_wake_minute(0) {}
+
+    JournalRecord::JournalRecord(JournalRecordType record_type)
+            : JournalRecord() {
+        type = static_cast<uint32_t>(record_type);
+    }
+
+    SleepJournal::SleepJournal(const std::string& path)
+            : journal_path(path), record_total(0), legacy_format(false) {
+        record_total = count_records_on_disk();
+    }
+
+    size_t SleepJournal::count_records_on_disk() {
+        std::ifstream file(journal_path, std::ios::binary);
+        if (!file.is_open()) return 0;
+
+        JournalHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return 0;
+        legacy_format = is_legacy_header(header);
+
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        size_t record_size = legacy_format ? sizeof(LegacyJournalRecord) : sizeof(JournalRecord);
+        return static_cast<size_t>((size - sizeof(JournalHeader)) / record_size);
+    }
+
+    bool SleepJournal::append(JournalRecord record) {
+        return append(&record, 1);
+    }
+
+    bool SleepJournal::append(const JournalRecord* records, size_t count) {
+        if (count == 0) return true;
+        if (legacy_format) return false;    // Mixing record layouts would corrupt the file
+
+        std::vector<JournalRecord> sealed(records, records + count);
+        for (auto& record : sealed) {
+            record.checksum = record_checksum(record);
+        }
+
+        int fd = ::open(journal_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0666);
+        if (fd < 0) return false;
+
+        struct stat info;
+        bool fresh = ::fstat(fd, &info) == 0 && info.st_size == 0;
+
+        // A fresh (or previously reset) journal starts with its header
+        std::string bytes;
+        bytes.reserve(sizeof(JournalHeader) + sealed.size() * sizeof(JournalRecord));
+        if (fresh) {
+            JournalHeader header = make_header();
+            bytes.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        bytes.append(reinterpret_cast<const char*>(sealed.data()), sealed.size() * sizeof(JournalRecord));
+
+        // Group commit: the whole batch is made durable by a single fsync
+        bool ok = write_fully(fd, bytes.data(), bytes.size()) && ::fsync(fd) == 0;
+        ok = (::close(fd) == 0) && ok;
+        if (ok && fresh) sync_parent_directory(journal_path);
+
+        if (!ok) return false;
+
+        record_total += count;
+        return true;
+    }
+
+    bool SleepJournal::replay(const std::function<void(const JournalRecord&)>& visitor) const {
+        std::ifstream file(journal_path, std::ios::binary);
+        if (!file.is_open()) return true; // No journal yet - nothing to replay
+
+        JournalHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            return file.gcount() == 0; // Empty file is fine, a partial header is not
+        }
+
+        if (is_legacy_header(header)) {
+            LegacyJournalRecord legacy;
+            while (file.read(reinterpret_cast<char*>(&legacy), sizeof(legacy))) {
+                if (legacy.checksum != record_checksum(legacy)) return false;
+                visitor(upgrade(legacy));
+            }
+            return file.gcount() == 0;
+        }
+        if (!is_valid_header(header)) return false;
+
+        JournalRecord record;
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            if (record.checksum != record_checksum(record)) {
+                return false; // Corrupt record - stop before applying it
+            }
+            visitor(record);
+        }
+
+        // Any trailing bytes are a torn append
+        return file.gcount() == 0;
+    }
+
+    bool SleepJournal::reset() {
+        std::ofstream file(journal_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        file.close();
+        record_total = 0;
+        legacy_format = false;
+        return !file.fail();
+    }
+
+} // namespace descansa
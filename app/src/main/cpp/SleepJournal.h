@@ -0,0 +1,74 @@
+// SleepJournal.h - Append-only binary journal for DescansaCore mutations
+#ifndef SLEEP_JOURNAL_H
+#define SLEEP_JOURNAL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <functional>
+
+namespace descansa {
+
+// Kinds of mutation recorded in the journal
+    enum class JournalRecordType : uint32_t {
+        SESSION = 1,    // completed sleep session (also ends the active session)
+        CONFIG = 2,     // schedule configuration change
+        ACTIVE = 3      // sleep session started
+    };
+
+// Fixed-size journal record - 56 bytes on disk, host byte order
+    struct JournalRecord {
+        uint32_t type;
+        uint32_t checksum;              // FNV-1a of the record with this field zeroed
+        uint64_t sequence;              // monotonically increasing, never reused
+        int64_t start_time;             // seconds since epoch
+        int64_t end_time;               // seconds since epoch
+        int64_t recorded_time;          // seconds since epoch
+        int32_t duration_seconds;       // ~68 years of headroom
+        int32_t target_sleep_seconds;
+        int32_t target_wake_hour;
+        int32_t target_wake_minute;
+
+        JournalRecord();
+        explicit JournalRecord(JournalRecordType record_type);
+
+        JournalRecordType get_type() const { return static_cast<JournalRecordType>(type); }
+    };
+
+    static_assert(sizeof(JournalRecord) == 56, "JournalRecord must stay 56 bytes on disk");
+
+// Append-only journal file. Every append costs one small write regardless of
+// how much history the snapshot holds; reset() is called once the records
+// have been folded into a snapshot.
+    class SleepJournal {
+    private:
+        std::string journal_path;
+        size_t record_total;
+        bool legacy_format;     // file still holds version 1 (double duration) records
+
+        size_t count_records_on_disk();
+
+    public:
+        explicit SleepJournal(const std::string& path);
+
+        // Append records (checksums are filled in here); a batch is one write + one fsync
+        bool append(JournalRecord record);
+        bool append(const JournalRecord* records, size_t count);
+
+        // Visit every intact record in order. Returns false if a torn or
+        // corrupt record was found; records before it are still delivered.
+        bool replay(const std::function<void(const JournalRecord&)>& visitor) const;
+
+        // Drop all records (after compaction into a snapshot)
+        bool reset();
+
+        size_t record_count() const { return record_total; }
+
+        // Legacy records replay fine but must not be appended to; compact first
+        bool needs_upgrade() const { return legacy_format; }
+        const std::string& get_path() const { return journal_path; }
+    };
+
+} // namespace descansa
+
+#endif // SLEEP_JOURNAL_H
@@ -0,0 +1,68 @@
+// SleepMetricSketches.cpp - Implementation
+#include "SleepMetricSketches.h"
+#include "CivilTime.h"
+#include <string>
+
+namespace descansa {
+
+    const int SleepMetricSketches::kMetricCount;
+
+    void SleepMetricSketches::clear() {
+        for (int metric = 0; metric < kMetricCount; ++metric) {
+            sketches[metric].clear();
+        }
+    }
+
+    double SleepMetricSketches::metric_value(SleepMetric metric, const DetailedSleepSession& session) {
+        switch (metric) {
+            case SleepMetric::DURATION_HOURS:
+                return to_hours(session.total_sleep_duration);
+            case SleepMetric::EFFICIENCY:
+                return session.sleep_efficiency;
+            case SleepMetric::BEDTIME_HOUR: {
+                double hour = civil::to_local(session.sleep_start).fractional_hour();
+                return hour < 12.0 ? hour + 24.0 : hour;
+            }
+            case SleepMetric::SCORE:
+                return DailySleepSummary::score_for(session.total_sleep_duration, session.sleep_efficiency,
+                                                    session.perceived_quality);
+        }
+        return 0.0;
+    }
+
+    void SleepMetricSketches::add(const DetailedSleepSession& session) {
+        if (!tracks(session)) return;
+
+        for (int metric = 0; metric < kMetricCount; ++metric) {
+            sketches[metric].add(metric_value(static_cast<SleepMetric>(metric), session));
+        }
+    }
+
+    void SleepMetricSketches::assign(const std::vector<DetailedSleepSession>& sessions) {
+        clear();
+        for (const auto& session : sessions) {
+            add(session);
+        }
+    }
+
+    void SleepMetricSketches::write(std::ostream& out) const {
+        for (int metric = 0; metric < kMetricCount; ++metric) {
+            sketches[metric].write(out);
+        }
+    }
+
+    bool SleepMetricSketches::read(std::istream& in) {
+        QuantileSketch parsed[kMetricCount];
+        std::string line;
+        for (int metric = 0; metric < kMetricCount; ++metric) {
+            if (!std::getline(in, line) || !parsed[metric].read(line)) return false;
+            if (parsed[metric].count() != parsed[0].count()) return false;
+        }
+
+        for (int metric = 0; metric < kMetricCount; ++metric) {
+            sketches[metric] = parsed[metric];
+        }
+        return true;
+    }
+
+} // namespace descansa
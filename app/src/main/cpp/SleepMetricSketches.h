@@ -0,0 +1,47 @@
+// SleepMetricSketches.h - Per-metric quantile sketches over the main sleeps
+#ifndef SLEEP_METRIC_SKETCHES_H
+#define SLEEP_METRIC_SKETCHES_H
+
+#include "SleepDataStructures.h"
+#include "QuantileSketch.h"
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace descansa {
+
+// Metrics with a percentile reference set
+    enum class SleepMetric {
+        DURATION_HOURS,
+        EFFICIENCY,         // percent
+        BEDTIME_HOUR,       // local, 12-36 so that late evenings sort before early mornings
+        SCORE               // DailySleepSummary::score_for the session alone
+    };
+
+// One sketch per SleepMetric, fed every complete non-nap session. Sketches
+// can't forget values, so edits and pruning rebuild them with assign().
+    class SleepMetricSketches {
+    private:
+        static const int kMetricCount = 4;
+
+        QuantileSketch sketches[kMetricCount];
+
+    public:
+        void clear();
+        void add(const DetailedSleepSession& session);     // ignores naps and open sessions
+        void assign(const std::vector<DetailedSleepSession>& sessions);
+
+        const QuantileSketch& sketch(SleepMetric metric) const { return sketches[static_cast<int>(metric)]; }
+        uint64_t sessions() const { return sketches[0].count(); }
+
+        static bool tracks(const DetailedSleepSession& session) { return session.is_complete && !session.is_nap; }
+        static double metric_value(SleepMetric metric, const DetailedSleepSession& session);
+
+        // One line per metric; read() leaves the sketches untouched on failure
+        void write(std::ostream& out) const;
+        bool read(std::istream& in);
+    };
+
+} // namespace descansa
+
+#endif // SLEEP_METRIC_SKETCHES_H
@@ -0,0 +1,112 @@
+// SleepWakeScorer.cpp - Implementation
+#include "SleepWakeScorer.h"
+#include "StatKernels.h"
+
+namespace descansa {
+
+    namespace {
+
+        const size_t kLeadMinutes = 4;      // window reaches four minutes back
+        const size_t kTrailMinutes = 3;     // two minutes ahead, plus the zero eighth tap
+        const size_t kWindow = 8;
+
+        // Activity counts are in 0.01 g*s; this brings a minute of restless
+        // movement into the range the published weights were fitted on
+        const double kCountScale = 0.05;
+        const double kScaleFactor = 0.001;  // P
+
+        // Oldest minute first, so window[k] pairs with counts[m - 4 + k]
+        const double kWeights[kWindow] = {
+                106 * kScaleFactor * kCountScale, 54 * kScaleFactor * kCountScale,
+                58 * kScaleFactor * kCountScale, 76 * kScaleFactor * kCountScale,
+                230 * kScaleFactor * kCountScale, 74 * kScaleFactor * kCountScale,
+                67 * kScaleFactor * kCountScale, 0.0
+        };
+
+    } // namespace
+
+    const int32_t SleepWakeScorer::kMinuteSeconds;
+
+    void SleepWakeScorer::Totals::apply(bool asleep) {
+        if (asleep) {
+            // A wake bout only counts once sleep resumes after it
+            if (onset && pending_wake > 0) {
+                awakenings++;
+                awake_minutes += pending_wake;
+            }
+            pending_wake = 0;
+            onset = true;
+            asleep_minutes++;
+        } else if (onset) {
+            pending_wake++;
+        }
+        last_asleep = asleep;
+    }
+
+    SleepWakeScorer::SleepWakeScorer() {
+        reset();
+    }
+
+    void SleepWakeScorer::reset() {
+        counts.assign(kLeadMinutes + kTrailMinutes, 0.0);
+        counts.reserve(kLeadMinutes + 12 * 60 + kTrailMinutes);   // a long night without regrowth
+        first_minute = 0;
+        minutes = 0;
+        final_minutes = 0;
+        finalized = Totals();
+        current = SleepWakeSummary();
+    }
+
+    bool SleepWakeScorer::score_minute(size_t minute) const {
+        // counts[minute] is four minutes before it, given the lead padding
+        return stat_kernels::dot(kWeights, &counts[minute], kWindow) < 1.0;
+    }
+
+    void SleepWakeScorer::write_minute(Hypnogram& hypnogram, size_t minute, bool asleep) {
+        SleepStage stage = asleep ? SleepStage::ASLEEP : SleepStage::AWAKE;
+        if (minute < hypnogram.epoch_count()) {
+            hypnogram.set_stage(minute, stage);
+        } else {
+            hypnogram.append(stage);
+        }
+    }
+
+    void SleepWakeScorer::add(const ActivityEpoch& epoch, Hypnogram& hypnogram) {
+        int64_t minute = epoch.start_seconds / kMinuteSeconds;
+        if (minutes == 0) {
+            first_minute = minute;
+            hypnogram.reset(minute * kMinuteSeconds, kMinuteSeconds);
+        }
+        if (minute < first_minute || static_cast<size_t>(minute - first_minute) < final_minutes) return;
+
+        // Grow into the trailing padding; the new minutes start at zero
+        size_t index = static_cast<size_t>(minute - first_minute);
+        while (minutes <= index) {
+            counts.push_back(0.0);
+            minutes++;
+        }
+        counts[kLeadMinutes + index] += static_cast<double>(epoch.activity_count);
+
+        // A minute is complete once a later one has data; final once the two after it are complete
+        while (final_minutes + 4 <= minutes) {
+            bool asleep = score_minute(final_minutes);
+            finalized.apply(asleep);
+            write_minute(hypnogram, final_minutes, asleep);
+            final_minutes++;
+        }
+
+        // Provisional tail, re-scored from scratch on top of the final totals
+        Totals totals = finalized;
+        for (size_t tail = final_minutes; tail < minutes; ++tail) {
+            bool asleep = score_minute(tail);
+            totals.apply(asleep);
+            write_minute(hypnogram, tail, asleep);
+        }
+
+        current.awakenings = totals.awakenings;
+        current.awake_after_onset = Duration(totals.awake_minutes * kMinuteSeconds);
+        current.asleep = Duration(totals.asleep_minutes * kMinuteSeconds);
+        current.asleep_now = totals.last_asleep;
+    }
+
+} // namespace descansa
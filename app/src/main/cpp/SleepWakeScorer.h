@@ -0,0 +1,80 @@
+// SleepWakeScorer.h - Incremental Cole-Kripke sleep/wake scoring of activity epochs
+#ifndef SLEEP_WAKE_SCORER_H
+#define SLEEP_WAKE_SCORER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Hypnogram.h"
+#include "SensorPipeline.h"
+#include "TimeTypes.h"
+
+namespace descansa {
+
+// Sleep/wake totals of the night scored so far
+    struct SleepWakeSummary {
+        int awakenings;                 // wake bouts with sleep on both sides
+        Duration awake_after_onset;     // minutes in those bouts
+        Duration asleep;
+        bool asleep_now;                // score of the latest minute
+
+        SleepWakeSummary() : awakenings(0), awake_after_onset(0), asleep(0), asleep_now(false) {}
+    };
+
+// Cole-Kripke (1992) on one-minute activity counts: minute m is sleep when
+//   P * (106 A[m-4] + 54 A[m-3] + 58 A[m-2] + 76 A[m-1] + 230 A[m] + 74 A[m+1] + 67 A[m+2]) < 1
+// Counts live in one contiguous history with zero padding on both ends, so
+// every window is a single 8-wide stat_kernels::dot (the weights carry a
+// zero eighth tap). A minute's score is final once the two minutes after it
+// are complete; the at most three newer minutes are scored with what has
+// arrived and re-scored on every epoch. Totals over the final prefix are kept
+// running, so an epoch costs a constant amount of work however long the
+// night. Minutes without epochs count as no movement.
+    class SleepWakeScorer {
+    public:
+        static const int32_t kMinuteSeconds = 60;
+
+    private:
+        // Running sleep/wake bookkeeping over a prefix of minutes
+        struct Totals {
+            bool onset;
+            bool last_asleep;
+            int awakenings;
+            int64_t pending_wake;       // wake minutes since the last sleep minute
+            int64_t awake_minutes;
+            int64_t asleep_minutes;
+
+            Totals() : onset(false), last_asleep(false), awakenings(0), pending_wake(0),
+                       awake_minutes(0), asleep_minutes(0) {}
+
+            void apply(bool asleep);
+        };
+
+        std::vector<double> counts;     // padding, one scaled count per minute, padding
+        int64_t first_minute;           // wall-clock minute of the first scored minute
+        size_t minutes;
+        size_t final_minutes;           // prefix whose scores can no longer change
+        Totals finalized;
+        SleepWakeSummary current;
+
+        bool score_minute(size_t minute) const;
+        static void write_minute(Hypnogram& hypnogram, size_t minute, bool asleep);
+
+    public:
+        SleepWakeScorer();
+
+        void reset();
+
+        // Adds the epoch's activity to its minute and re-scores what that can
+        // change into hypnogram (one-minute epochs, AWAKE / ASLEEP; reset by
+        // the first epoch). Epochs should be at most a minute long; one that
+        // lands in an already final minute is ignored.
+        void add(const ActivityEpoch& epoch, Hypnogram& hypnogram);
+
+        const SleepWakeSummary& summary() const { return current; }
+        size_t minute_count() const { return minutes; }
+    };
+
+} // namespace descansa
+
+#endif // SLEEP_WAKE_SCORER_H
@@ -0,0 +1,97 @@
+// SpscRingBuffer.h - Lock-free single-producer/single-consumer queue
+#ifndef SPSC_RING_BUFFER_H
+#define SPSC_RING_BUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace descansa {
+
+// Bounded FIFO for one producer thread and one consumer thread. Both sides
+// are wait-free: push never blocks and, when the ring is full, accepts only
+// what fits and reports the rest as not taken. Indices only ever grow; the
+// capacity is a power of two so the slot is a mask, and each side caches the
+// other's index so it touches the shared cache line only when it looks full
+// (producer) or empty (consumer). T should be trivially copyable.
+    template <typename T>
+    class SpscRingBuffer {
+    private:
+        static const size_t kCacheLine = 64;
+
+        std::unique_ptr<T[]> slots;
+        size_t mask;
+
+        // Written by the consumer, read by the producer. Padding rather than
+        // alignas keeps the two sides on separate cache lines without making
+        // the owner over-aligned (plain new can't honor that before C++17).
+        char pad_before_head[kCacheLine];
+        std::atomic<size_t> head;
+        size_t cached_tail;     // consumer's last view of tail
+        char pad_before_tail[kCacheLine - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+        // Written by the producer, read by the consumer
+        std::atomic<size_t> tail;
+        size_t cached_head;     // producer's last view of head
+        char pad_after_tail[kCacheLine - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+        SpscRingBuffer(const SpscRingBuffer&) = delete;
+        SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+        static size_t round_up_capacity(size_t requested) {
+            size_t capacity = 2;
+            while (capacity < requested) capacity <<= 1;
+            return capacity;
+        }
+
+    public:
+        explicit SpscRingBuffer(size_t requested_capacity)
+                : mask(round_up_capacity(requested_capacity) - 1), head(0), cached_tail(0),
+                  tail(0), cached_head(0) {
+            slots.reset(new T[mask + 1]);
+        }
+
+        size_t capacity() const { return mask + 1; }
+
+        // Producer only. Returns how many of the items were queued (a prefix).
+        size_t push(const T* items, size_t count) {
+            size_t write = tail.load(std::memory_order_relaxed);
+            if (write - cached_head + count > capacity()) {
+                cached_head = head.load(std::memory_order_acquire);
+            }
+            size_t accepted = std::min(count, capacity() - (write - cached_head));
+
+            for (size_t index = 0; index < accepted; ++index) {
+                slots[(write + index) & mask] = items[index];
+            }
+            tail.store(write + accepted, std::memory_order_release);
+            return accepted;
+        }
+
+        bool push(const T& item) { return push(&item, 1) == 1; }
+
+        // Consumer only. Moves up to max_count items into out; returns how many.
+        size_t pop(T* out, size_t max_count) {
+            size_t read = head.load(std::memory_order_relaxed);
+            if (cached_tail - read < max_count) {
+                cached_tail = tail.load(std::memory_order_acquire);
+            }
+            size_t available = std::min(max_count, cached_tail - read);
+
+            for (size_t index = 0; index < available; ++index) {
+                out[index] = slots[(read + index) & mask];
+            }
+            head.store(read + available, std::memory_order_release);
+            return available;
+        }
+
+        // Either side; a snapshot that may be stale by the time it returns
+        size_t size_approx() const {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+    };
+
+} // namespace descansa
+
+#endif // SPSC_RING_BUFFER_H
@@ -0,0 +1,533 @@
+// StatKernels.cpp - Implementation
+#include "StatKernels.h"
+#include <atomic>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define DESCANSA_SSE2_KERNELS 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define DESCANSA_AVX2_KERNELS 1
+#define DESCANSA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DESCANSA_NEON_KERNELS 1
+#endif
+
+namespace descansa {
+
+    namespace stat_kernels {
+
+        namespace {
+
+            // Every kernel family provides the same primitives; the public
+            // functions only handle empty input and derive the statistics
+            struct KernelTable {
+                const char* name;
+                double (*sum)(const double* values, size_t count);
+                int64_t (*sum_int64)(const int64_t* values, size_t count);
+                double (*dot)(const double* x, const double* y, size_t count);
+                void (*min_max)(const double* values, size_t count, double* min_value, double* max_value);
+                // sums[0] = sum(x - x0), sums[1] = sum((x - x0)^2)
+                void (*shifted_sums)(const double* x, size_t count, double x0, double* sums);
+                // sums = {dx, dy, dx*dx, dy*dy, dx*dy} with dx = x - x0, dy = y - y0
+                void (*shifted_cross_sums)(const double* x, const double* y, size_t count,
+                                           double x0, double y0, double* sums);
+            };
+
+            // ---- Scalar ----
+
+            double sum_scalar(const double* values, size_t count) {
+                double total = 0.0;
+                for (size_t i = 0; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            int64_t sum_int64_scalar(const int64_t* values, size_t count) {
+                int64_t total = 0;
+                for (size_t i = 0; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            double dot_scalar(const double* x, const double* y, size_t count) {
+                double total = 0.0;
+                for (size_t i = 0; i < count; ++i) total += x[i] * y[i];
+                return total;
+            }
+
+            void min_max_scalar(const double* values, size_t count, double* min_value, double* max_value) {
+                double low = values[0], high = values[0];
+                for (size_t i = 1; i < count; ++i) {
+                    low = values[i] < low ? values[i] : low;
+                    high = values[i] > high ? values[i] : high;
+                }
+                *min_value = low;
+                *max_value = high;
+            }
+
+            void shifted_sums_scalar(const double* x, size_t count, double x0, double* sums) {
+                double sx = 0.0, sxx = 0.0;
+                for (size_t i = 0; i < count; ++i) {
+                    double dx = x[i] - x0;
+                    sx += dx;
+                    sxx += dx * dx;
+                }
+                sums[0] = sx;
+                sums[1] = sxx;
+            }
+
+            void shifted_cross_sums_scalar(const double* x, const double* y, size_t count,
+                                           double x0, double y0, double* sums) {
+                double sx = 0.0, sy = 0.0, sxx = 0.0, syy = 0.0, sxy = 0.0;
+                for (size_t i = 0; i < count; ++i) {
+                    double dx = x[i] - x0;
+                    double dy = y[i] - y0;
+                    sx += dx;
+                    sy += dy;
+                    sxx += dx * dx;
+                    syy += dy * dy;
+                    sxy += dx * dy;
+                }
+                sums[0] = sx;
+                sums[1] = sy;
+                sums[2] = sxx;
+                sums[3] = syy;
+                sums[4] = sxy;
+            }
+
+            const KernelTable kScalarKernels = {
+                    "scalar", sum_scalar, sum_int64_scalar, dot_scalar, min_max_scalar,
+                    shifted_sums_scalar, shifted_cross_sums_scalar
+            };
+
+#if defined(DESCANSA_SSE2_KERNELS)
+            // ---- SSE2: two lanes, two accumulators per sum ----
+
+            double horizontal_sum(__m128d v) {
+                return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+            }
+
+            double sum_sse2(const double* values, size_t count) {
+                __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    a0 = _mm_add_pd(a0, _mm_loadu_pd(values + i));
+                    a1 = _mm_add_pd(a1, _mm_loadu_pd(values + i + 2));
+                }
+                double total = horizontal_sum(_mm_add_pd(a0, a1));
+                for (; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            int64_t sum_int64_sse2(const int64_t* values, size_t count) {
+                __m128i a0 = _mm_setzero_si128(), a1 = _mm_setzero_si128();
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    a0 = _mm_add_epi64(a0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)));
+                    a1 = _mm_add_epi64(a1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + 2)));
+                }
+                int64_t lanes[2];
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(a0, a1));
+                int64_t total = lanes[0] + lanes[1];
+                for (; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            double dot_sse2(const double* x, const double* y, size_t count) {
+                __m128d a0 = _mm_setzero_pd(), a1 = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    a0 = _mm_add_pd(a0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+                    a1 = _mm_add_pd(a1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+                }
+                double total = horizontal_sum(_mm_add_pd(a0, a1));
+                for (; i < count; ++i) total += x[i] * y[i];
+                return total;
+            }
+
+            void min_max_sse2(const double* values, size_t count, double* min_value, double* max_value) {
+                __m128d low = _mm_set1_pd(values[0]), high = low;
+                size_t i = 0;
+                for (; i + 2 <= count; i += 2) {
+                    __m128d v = _mm_loadu_pd(values + i);
+                    low = _mm_min_pd(low, v);
+                    high = _mm_max_pd(high, v);
+                }
+                low = _mm_min_sd(low, _mm_unpackhi_pd(low, low));
+                high = _mm_max_sd(high, _mm_unpackhi_pd(high, high));
+                double lowest = _mm_cvtsd_f64(low), highest = _mm_cvtsd_f64(high);
+                for (; i < count; ++i) {
+                    lowest = values[i] < lowest ? values[i] : lowest;
+                    highest = values[i] > highest ? values[i] : highest;
+                }
+                *min_value = lowest;
+                *max_value = highest;
+            }
+
+            void shifted_sums_sse2(const double* x, size_t count, double x0, double* sums) {
+                __m128d shift = _mm_set1_pd(x0);
+                __m128d sx = _mm_setzero_pd(), sxx = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 2 <= count; i += 2) {
+                    __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i), shift);
+                    sx = _mm_add_pd(sx, dx);
+                    sxx = _mm_add_pd(sxx, _mm_mul_pd(dx, dx));
+                }
+                sums[0] = horizontal_sum(sx);
+                sums[1] = horizontal_sum(sxx);
+                for (; i < count; ++i) {
+                    double dx = x[i] - x0;
+                    sums[0] += dx;
+                    sums[1] += dx * dx;
+                }
+            }
+
+            void shifted_cross_sums_sse2(const double* x, const double* y, size_t count,
+                                         double x0, double y0, double* sums) {
+                __m128d shift_x = _mm_set1_pd(x0), shift_y = _mm_set1_pd(y0);
+                __m128d sx = _mm_setzero_pd(), sy = _mm_setzero_pd();
+                __m128d sxx = _mm_setzero_pd(), syy = _mm_setzero_pd(), sxy = _mm_setzero_pd();
+                size_t i = 0;
+                for (; i + 2 <= count; i += 2) {
+                    __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i), shift_x);
+                    __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i), shift_y);
+                    sx = _mm_add_pd(sx, dx);
+                    sy = _mm_add_pd(sy, dy);
+                    sxx = _mm_add_pd(sxx, _mm_mul_pd(dx, dx));
+                    syy = _mm_add_pd(syy, _mm_mul_pd(dy, dy));
+                    sxy = _mm_add_pd(sxy, _mm_mul_pd(dx, dy));
+                }
+                double tail[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+                shifted_cross_sums_scalar(x + i, y + i, count - i, x0, y0, tail);
+                sums[0] = horizontal_sum(sx) + tail[0];
+                sums[1] = horizontal_sum(sy) + tail[1];
+                sums[2] = horizontal_sum(sxx) + tail[2];
+                sums[3] = horizontal_sum(syy) + tail[3];
+                sums[4] = horizontal_sum(sxy) + tail[4];
+            }
+
+            const KernelTable kSse2Kernels = {
+                    "sse2", sum_sse2, sum_int64_sse2, dot_sse2, min_max_sse2,
+                    shifted_sums_sse2, shifted_cross_sums_sse2
+            };
+#endif
+
+#if defined(DESCANSA_AVX2_KERNELS)
+            // ---- AVX2 + FMA: four lanes, chosen only if the CPU reports both ----
+
+            DESCANSA_TARGET_AVX2 double horizontal_sum(__m256d v) {
+                __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+                return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+            }
+
+            DESCANSA_TARGET_AVX2 double sum_avx2(const double* values, size_t count) {
+                __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8) {
+                    a0 = _mm256_add_pd(a0, _mm256_loadu_pd(values + i));
+                    a1 = _mm256_add_pd(a1, _mm256_loadu_pd(values + i + 4));
+                }
+                double total = horizontal_sum(_mm256_add_pd(a0, a1));
+                for (; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            DESCANSA_TARGET_AVX2 int64_t sum_int64_avx2(const int64_t* values, size_t count) {
+                __m256i a0 = _mm256_setzero_si256(), a1 = _mm256_setzero_si256();
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8) {
+                    a0 = _mm256_add_epi64(a0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)));
+                    a1 = _mm256_add_epi64(a1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 4)));
+                }
+                int64_t lanes[4];
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(a0, a1));
+                int64_t total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+                for (; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            DESCANSA_TARGET_AVX2 double dot_avx2(const double* x, const double* y, size_t count) {
+                __m256d a0 = _mm256_setzero_pd(), a1 = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 8 <= count; i += 8) {
+                    a0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), a0);
+                    a1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), a1);
+                }
+                double total = horizontal_sum(_mm256_add_pd(a0, a1));
+                for (; i < count; ++i) total += x[i] * y[i];
+                return total;
+            }
+
+            DESCANSA_TARGET_AVX2 void min_max_avx2(const double* values, size_t count,
+                                                   double* min_value, double* max_value) {
+                __m256d low = _mm256_set1_pd(values[0]), high = low;
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    __m256d v = _mm256_loadu_pd(values + i);
+                    low = _mm256_min_pd(low, v);
+                    high = _mm256_max_pd(high, v);
+                }
+                double low_lanes[4], high_lanes[4];
+                _mm256_storeu_pd(low_lanes, low);
+                _mm256_storeu_pd(high_lanes, high);
+                double lowest = low_lanes[0], highest = high_lanes[0];
+                for (int lane = 1; lane < 4; ++lane) {
+                    lowest = low_lanes[lane] < lowest ? low_lanes[lane] : lowest;
+                    highest = high_lanes[lane] > highest ? high_lanes[lane] : highest;
+                }
+                for (; i < count; ++i) {
+                    lowest = values[i] < lowest ? values[i] : lowest;
+                    highest = values[i] > highest ? values[i] : highest;
+                }
+                *min_value = lowest;
+                *max_value = highest;
+            }
+
+            DESCANSA_TARGET_AVX2 void shifted_sums_avx2(const double* x, size_t count, double x0, double* sums) {
+                __m256d shift = _mm256_set1_pd(x0);
+                __m256d sx = _mm256_setzero_pd(), sxx = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), shift);
+                    sx = _mm256_add_pd(sx, dx);
+                    sxx = _mm256_fmadd_pd(dx, dx, sxx);
+                }
+                sums[0] = horizontal_sum(sx);
+                sums[1] = horizontal_sum(sxx);
+                for (; i < count; ++i) {
+                    double dx = x[i] - x0;
+                    sums[0] += dx;
+                    sums[1] += dx * dx;
+                }
+            }
+
+            DESCANSA_TARGET_AVX2 void shifted_cross_sums_avx2(const double* x, const double* y, size_t count,
+                                                              double x0, double y0, double* sums) {
+                __m256d shift_x = _mm256_set1_pd(x0), shift_y = _mm256_set1_pd(y0);
+                __m256d sx = _mm256_setzero_pd(), sy = _mm256_setzero_pd();
+                __m256d sxx = _mm256_setzero_pd(), syy = _mm256_setzero_pd(), sxy = _mm256_setzero_pd();
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), shift_x);
+                    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), shift_y);
+                    sx = _mm256_add_pd(sx, dx);
+                    sy = _mm256_add_pd(sy, dy);
+                    sxx = _mm256_fmadd_pd(dx, dx, sxx);
+                    syy = _mm256_fmadd_pd(dy, dy, syy);
+                    sxy = _mm256_fmadd_pd(dx, dy, sxy);
+                }
+                double tail[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+                shifted_cross_sums_scalar(x + i, y + i, count - i, x0, y0, tail);
+                sums[0] = horizontal_sum(sx) + tail[0];
+                sums[1] = horizontal_sum(sy) + tail[1];
+                sums[2] = horizontal_sum(sxx) + tail[2];
+                sums[3] = horizontal_sum(syy) + tail[3];
+                sums[4] = horizontal_sum(sxy) + tail[4];
+            }
+
+            const KernelTable kAvx2Kernels = {
+                    "avx2", sum_avx2, sum_int64_avx2, dot_avx2, min_max_avx2,
+                    shifted_sums_avx2, shifted_cross_sums_avx2
+            };
+#endif
+
+#if defined(DESCANSA_NEON_KERNELS)
+            // ---- NEON (arm64): two double lanes, two accumulators per sum ----
+
+            double sum_neon(const double* values, size_t count) {
+                float64x2_t a0 = vdupq_n_f64(0.0), a1 = vdupq_n_f64(0.0);
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    a0 = vaddq_f64(a0, vld1q_f64(values + i));
+                    a1 = vaddq_f64(a1, vld1q_f64(values + i + 2));
+                }
+                double total = vaddvq_f64(vaddq_f64(a0, a1));
+                for (; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            int64_t sum_int64_neon(const int64_t* values, size_t count) {
+                int64x2_t a0 = vdupq_n_s64(0), a1 = vdupq_n_s64(0);
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    a0 = vaddq_s64(a0, vld1q_s64(values + i));
+                    a1 = vaddq_s64(a1, vld1q_s64(values + i + 2));
+                }
+                int64_t total = vaddvq_s64(vaddq_s64(a0, a1));
+                for (; i < count; ++i) total += values[i];
+                return total;
+            }
+
+            double dot_neon(const double* x, const double* y, size_t count) {
+                float64x2_t a0 = vdupq_n_f64(0.0), a1 = vdupq_n_f64(0.0);
+                size_t i = 0;
+                for (; i + 4 <= count; i += 4) {
+                    a0 = vfmaq_f64(a0, vld1q_f64(x + i), vld1q_f64(y + i));
+                    a1 = vfmaq_f64(a1, vld1q_f64(x + i + 2), vld1q_f64(y + i + 2));
+                }
+                double total = vaddvq_f64(vaddq_f64(a0, a1));
+                for (; i < count; ++i) total += x[i] * y[i];
+                return total;
+            }
+
+            void min_max_neon(const double* values, size_t count, double* min_value, double* max_value) {
+                float64x2_t low = vdupq_n_f64(values[0]), high = low;
+                size_t i = 0;
+                for (; i + 2 <= count; i += 2) {
+                    float64x2_t v = vld1q_f64(values + i);
+                    low = vminq_f64(low, v);
+                    high = vmaxq_f64(high, v);
+                }
+                double lowest = vminvq_f64(low), highest = vmaxvq_f64(high);
+                for (; i < count; ++i) {
+                    lowest = values[i] < lowest ? values[i] : lowest;
+                    highest = values[i] > highest ? values[i] : highest;
+                }
+                *min_value = lowest;
+                *max_value = highest;
+            }
+
+            void shifted_sums_neon(const double* x, size_t count, double x0, double* sums) {
+                float64x2_t shift = vdupq_n_f64(x0);
+                float64x2_t sx = vdupq_n_f64(0.0), sxx = vdupq_n_f64(0.0);
+                size_t i = 0;
+                for (; i + 2 <= count; i += 2) {
+                    float64x2_t dx = vsubq_f64(vld1q_f64(x + i), shift);
+                    sx = vaddq_f64(sx, dx);
+                    sxx = vfmaq_f64(sxx, dx, dx);
+                }
+                sums[0] = vaddvq_f64(sx);
+                sums[1] = vaddvq_f64(sxx);
+                for (; i < count; ++i) {
+                    double dx = x[i] - x0;
+                    sums[0] += dx;
+                    sums[1] += dx * dx;
+                }
+            }
+
+            void shifted_cross_sums_neon(const double* x, const double* y, size_t count,
+                                         double x0, double y0, double* sums) {
+                float64x2_t shift_x = vdupq_n_f64(x0), shift_y = vdupq_n_f64(y0);
+                float64x2_t sx = vdupq_n_f64(0.0), sy = vdupq_n_f64(0.0);
+                float64x2_t sxx = vdupq_n_f64(0.0), syy = vdupq_n_f64(0.0), sxy = vdupq_n_f64(0.0);
+                size_t i = 0;
+                for (; i + 2 <= count; i += 2) {
+                    float64x2_t dx = vsubq_f64(vld1q_f64(x + i), shift_x);
+                    float64x2_t dy = vsubq_f64(vld1q_f64(y + i), shift_y);
+                    sx = vaddq_f64(sx, dx);
+                    sy = vaddq_f64(sy, dy);
+                    sxx = vfmaq_f64(sxx, dx, dx);
+                    syy = vfmaq_f64(syy, dy, dy);
+                    sxy = vfmaq_f64(sxy, dx, dy);
+                }
+                double tail[5] = {0.0, 0.0, 0.0, 0.0, 0.0};
+                shifted_cross_sums_scalar(x + i, y + i, count - i, x0, y0, tail);
+                sums[0] = vaddvq_f64(sx) + tail[0];
+                sums[1] = vaddvq_f64(sy) + tail[1];
+                sums[2] = vaddvq_f64(sxx) + tail[2];
+                sums[3] = vaddvq_f64(syy) + tail[3];
+                sums[4] = vaddvq_f64(sxy) + tail[4];
+            }
+
+            const KernelTable kNeonKernels = {
+                    "neon", sum_neon, sum_int64_neon, dot_neon, min_max_neon,
+                    shifted_sums_neon, shifted_cross_sums_neon
+            };
+#endif
+
+            const KernelTable& detect_kernels() {
+#if defined(DESCANSA_AVX2_KERNELS)
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                    return kAvx2Kernels;
+                }
+#endif
+#if defined(DESCANSA_SSE2_KERNELS)
+                return kSse2Kernels;
+#elif defined(DESCANSA_NEON_KERNELS)
+                return kNeonKernels;
+#else
+                return kScalarKernels;
+#endif
+            }
+
+            std::atomic<bool> g_force_scalar(false);
+
+            const KernelTable& kernels() {
+                static const KernelTable& detected = detect_kernels();  // thread-safe one-time init
+                return g_force_scalar.load(std::memory_order_relaxed) ? kScalarKernels : detected;
+            }
+
+            // Population moments from shifted sums
+            void finish_moments(double sx, double sxx, size_t count, double shift, double& mean, double& variance) {
+                double mean_offset = sx / count;
+                mean = shift + mean_offset;
+                variance = sxx / count - mean_offset * mean_offset;
+                if (variance < 0.0) variance = 0.0;     // rounding on constant input
+            }
+
+        } // namespace
+
+        double sum(const double* values, size_t count) {
+            return count > 0 ? kernels().sum(values, count) : 0.0;
+        }
+
+        int64_t sum(const int64_t* values, size_t count) {
+            return count > 0 ? kernels().sum_int64(values, count) : 0;
+        }
+
+        double sum_of_squares(const double* values, size_t count) {
+            return count > 0 ? kernels().dot(values, values, count) : 0.0;
+        }
+
+        double dot(const double* x, const double* y, size_t count) {
+            return count > 0 ? kernels().dot(x, y, count) : 0.0;
+        }
+
+        bool min_max(const double* values, size_t count, double& min_value, double& max_value) {
+            if (count == 0) return false;
+            kernels().min_max(values, count, &min_value, &max_value);
+            return true;
+        }
+
+        Moments moments(const double* values, size_t count) {
+            Moments result;
+            if (count == 0) return result;
+
+            double sums[2];
+            kernels().shifted_sums(values, count, values[0], sums);
+
+            result.count = count;
+            finish_moments(sums[0], sums[1], count, values[0], result.mean_x, result.variance_x);
+            return result;
+        }
+
+        Moments moments(const double* x, const double* y, size_t count) {
+            Moments result;
+            if (count == 0) return result;
+
+            double sums[5];
+            kernels().shifted_cross_sums(x, y, count, x[0], y[0], sums);
+
+            result.count = count;
+            finish_moments(sums[0], sums[2], count, x[0], result.mean_x, result.variance_x);
+            finish_moments(sums[1], sums[3], count, y[0], result.mean_y, result.variance_y);
+            result.covariance = sums[4] / count - (sums[0] / count) * (sums[1] / count);
+            return result;
+        }
+
+        const char* active_kernel() {
+            return kernels().name;
+        }
+
+        void force_scalar(bool enabled) {
+            g_force_scalar.store(enabled, std::memory_order_relaxed);
+        }
+
+    } // namespace stat_kernels
+
+} // namespace descansa
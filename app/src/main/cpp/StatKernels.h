@@ -0,0 +1,47 @@
+// StatKernels.h - Vectorized reductions behind the analytics helpers
+#ifndef STAT_KERNELS_H
+#define STAT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace descansa {
+
+    namespace stat_kernels {
+
+// Mean, population variance and covariance from one fused pass. Sums are
+// taken relative to the first element, so hour-of-day or epoch-second
+// inputs don't lose their variance to cancellation.
+        struct Moments {
+            size_t count;
+            double mean_x;
+            double mean_y;
+            double variance_x;
+            double variance_y;
+            double covariance;
+
+            Moments() : count(0), mean_x(0.0), mean_y(0.0), variance_x(0.0), variance_y(0.0), covariance(0.0) {}
+
+            double sample_variance_x() const { return count > 1 ? variance_x * count / (count - 1) : 0.0; }
+        };
+
+// The implementation is picked once per process: AVX2+FMA when the CPU has
+// it, else SSE2 on x86, NEON on arm64, plain loops everywhere else. Lanes
+// accumulate separately, so the last bits can differ between kernels.
+        double sum(const double* values, size_t count);
+        int64_t sum(const int64_t* values, size_t count);
+        double sum_of_squares(const double* values, size_t count);
+        double dot(const double* x, const double* y, size_t count);
+        bool min_max(const double* values, size_t count, double& min_value, double& max_value); // false when empty
+
+        Moments moments(const double* values, size_t count);
+        Moments moments(const double* x, const double* y, size_t count);
+
+        const char* active_kernel();        // "avx2", "sse2", "neon" or "scalar"
+        void force_scalar(bool enabled);    // for comparisons and benchmarks
+
+    } // namespace stat_kernels
+
+} // namespace descansa
+
+#endif // STAT_KERNELS_H
@@ -0,0 +1,222 @@
+// TextDataParser.cpp - Implementation
+#include "TextDataParser.h"
+#include <fstream>
+#include <cstdlib>
+#include <limits>
+
+namespace descansa {
+
+    namespace text_parser {
+
+        namespace {
+
+            const double kPowersOfTen[] = {
+                    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            const uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+
+            bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+            const char* skip_blanks(const char* p, const char* end) {
+                while (p < end && (*p == ' ' || *p == '\t')) ++p;
+                return p;
+            }
+
+            // Slow path for values the exact fast path cannot represent
+            bool parse_double_fallback(const char* begin, const char* end, double& value) {
+                char scratch[64];
+                size_t length = static_cast<size_t>(end - begin);
+                if (length >= sizeof(scratch)) return false;
+
+                std::memcpy(scratch, begin, length);
+                scratch[length] = '\0';
+
+                char* parsed_end = nullptr;
+                value = std::strtod(scratch, &parsed_end);
+                return parsed_end == scratch + length;
+            }
+
+        } // namespace
+
+        bool LineCursor::next(TextSpan& line) {
+            if (position >= limit) return false;
+
+            const char* line_end = static_cast<const char*>(
+                    std::memchr(position, '\n', static_cast<size_t>(limit - position)));
+            if (!line_end) line_end = limit;
+
+            const char* content_end = line_end;
+            if (content_end > position && *(content_end - 1) == '\r') --content_end;
+
+            line = TextSpan(position, content_end);
+            position = line_end < limit ? line_end + 1 : limit;
+            current_line++;
+            return true;
+        }
+
+        bool FieldCursor::next(TextSpan& field) {
+            if (exhausted) return false;
+
+            if (position < limit && *position == '"') {
+                const char* content = position + 1;
+                const char* closing = static_cast<const char*>(
+                        std::memchr(content, '"', static_cast<size_t>(limit - content)));
+                if (!closing) closing = limit;
+
+                field = TextSpan(content, closing);
+                position = closing < limit ? closing + 1 : limit;
+
+                // Anything between the closing quote and the separator is dropped
+                while (position < limit && *position != separator) ++position;
+            } else {
+                const char* field_end = static_cast<const char*>(
+                        std::memchr(position, separator, static_cast<size_t>(limit - position)));
+                if (!field_end) field_end = limit;
+
+                field = TextSpan(position, field_end);
+                position = field_end;
+            }
+
+            if (position < limit) {
+                ++position; // Skip separator
+            } else {
+                exhausted = true;
+            }
+            return true;
+        }
+
+        bool split_record(const TextSpan& line, TextSpan& type, TextSpan& payload) {
+            const char* colon = static_cast<const char*>(std::memchr(line.begin, ':', line.size()));
+            if (!colon) return false;
+
+            type = TextSpan(line.begin, colon);
+            payload = TextSpan(colon + 1, line.end);
+            return true;
+        }
+
+        bool parse_int64(const TextSpan& field, int64_t& value) {
+            const char* p = skip_blanks(field.begin, field.end);
+            const char* end = field.end;
+
+            bool negative = false;
+            if (p < end && (*p == '+' || *p == '-')) {
+                negative = (*p == '-');
+                ++p;
+            }
+            if (p == end) return false;
+
+            const uint64_t limit = negative
+                                   ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1
+                                   : static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+            uint64_t magnitude = 0;
+            for (; p < end; ++p) {
+                if (!is_digit(*p)) return false;
+
+                uint64_t digit = static_cast<uint64_t>(*p - '0');
+                if (magnitude > (limit - digit) / 10) return false; // Overflow
+                magnitude = magnitude * 10 + digit;
+            }
+
+            value = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+            return true;
+        }
+
+        bool parse_int(const TextSpan& field, int& value) {
+            int64_t wide = 0;
+            if (!parse_int64(field, wide)) return false;
+            if (wide < std::numeric_limits<int>::min() || wide > std::numeric_limits<int>::max()) return false;
+
+            value = static_cast<int>(wide);
+            return true;
+        }
+
+        bool parse_double(const TextSpan& field, double& value) {
+            const char* start = skip_blanks(field.begin, field.end);
+            const char* p = start;
+            const char* end = field.end;
+
+            bool negative = false;
+            if (p < end && (*p == '+' || *p == '-')) {
+                negative = (*p == '-');
+                ++p;
+            }
+
+            uint64_t mantissa = 0;
+            int significant_digits = 0;
+            int exponent = 0;
+            bool any_digit = false;
+            bool truncated = false;
+
+            for (; p < end && is_digit(*p); ++p) {
+                any_digit = true;
+                if (significant_digits < 19) {
+                    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                    if (mantissa != 0) significant_digits++;
+                } else {
+                    exponent++;
+                    truncated = true;
+                }
+            }
+
+            if (p < end && *p == '.') {
+                for (++p; p < end && is_digit(*p); ++p) {
+                    any_digit = true;
+                    if (significant_digits < 19) {
+                        mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+                        if (mantissa != 0) significant_digits++;
+                        exponent--;
+                    } else {
+                        truncated = true;
+                    }
+                }
+            }
+            if (!any_digit) return false;
+
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                ++p;
+                bool exponent_negative = false;
+                if (p < end && (*p == '+' || *p == '-')) {
+                    exponent_negative = (*p == '-');
+                    ++p;
+                }
+                if (p == end || !is_digit(*p)) return false;
+
+                int written_exponent = 0;
+                for (; p < end && is_digit(*p); ++p) {
+                    if (written_exponent < 10000) {
+                        written_exponent = written_exponent * 10 + (*p - '0');
+                    }
+                }
+                exponent += exponent_negative ? -written_exponent : written_exponent;
+            }
+            if (p != end) return false;
+
+            // Exact when both mantissa and power of ten are representable
+            if (!truncated && mantissa <= kMaxExactMantissa && exponent >= -22 && exponent <= 22) {
+                double result = static_cast<double>(mantissa);
+                result = exponent < 0 ? result / kPowersOfTen[-exponent] : result * kPowersOfTen[exponent];
+                value = negative ? -result : result;
+                return true;
+            }
+
+            return parse_double_fallback(start, end, value);
+        }
+
+        bool read_file(const std::string& path, std::string& buffer) {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file.is_open()) return false;
+
+            std::streamoff size = file.tellg();
+            if (size < 0) return false;
+
+            buffer.resize(static_cast<size_t>(size));
+            file.seekg(0, std::ios::beg);
+            if (size > 0 && !file.read(&buffer[0], size)) return false;
+            return true;
+        }
+
+    } // namespace text_parser
+
+} // namespace descansa
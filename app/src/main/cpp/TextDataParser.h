@@ -0,0 +1,94 @@
+// TextDataParser.h - Allocation-free tokenizer for the text data files
+#ifndef TEXT_DATA_PARSER_H
+#define TEXT_DATA_PARSER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace descansa {
+
+    namespace text_parser {
+
+// Non-owning view into the file buffer
+        struct TextSpan {
+            const char* begin;
+            const char* end;
+
+            TextSpan() : begin(nullptr), end(nullptr) {}
+            TextSpan(const char* b, const char* e) : begin(b), end(e) {}
+
+            size_t size() const { return static_cast<size_t>(end - begin); }
+            bool empty() const { return begin == end; }
+            bool equals(const char* literal) const {
+                size_t length = std::strlen(literal);
+                return size() == length && std::memcmp(begin, literal, length) == 0;
+            }
+            std::string to_string() const { return std::string(begin, end); }
+        };
+
+// Counts lines that could not be parsed instead of throwing
+        struct ParseReport {
+            size_t lines_read;
+            size_t malformed_lines;
+            size_t first_malformed_line;    // 1-based, 0 if none
+            size_t dropped_fields;          // optional fields discarded from lines that were kept
+
+            ParseReport() : lines_read(0), malformed_lines(0), first_malformed_line(0), dropped_fields(0) {}
+
+            void note_malformed(size_t line_number) {
+                if (malformed_lines == 0) first_malformed_line = line_number;
+                malformed_lines++;
+            }
+            void note_dropped_field() { dropped_fields++; }
+            bool is_clean() const { return malformed_lines == 0 && dropped_fields == 0; }
+        };
+
+// Walks a buffer line by line ('\n' or "\r\n")
+        class LineCursor {
+        private:
+            const char* position;
+            const char* limit;
+            size_t current_line;
+
+        public:
+            explicit LineCursor(const std::string& buffer)
+                    : position(buffer.data()), limit(buffer.data() + buffer.size()), current_line(0) {}
+
+            bool next(TextSpan& line);
+            size_t line_number() const { return current_line; }
+        };
+
+// Splits one line into separator-delimited fields; a field opening with '"'
+// runs to the closing quote and is returned without the quotes
+        class FieldCursor {
+        private:
+            const char* position;
+            const char* limit;
+            char separator;
+            bool exhausted;
+
+        public:
+            explicit FieldCursor(const TextSpan& text, char sep = ',')
+                    : position(text.begin), limit(text.end), separator(sep), exhausted(false) {}
+
+            bool next(TextSpan& field);
+        };
+
+// Split "TYPE:payload" at the first colon
+        bool split_record(const TextSpan& line, TextSpan& type, TextSpan& payload);
+
+// Numeric parsing - whole field must be consumed, leading blanks allowed
+        bool parse_int64(const TextSpan& field, int64_t& value);
+        bool parse_int(const TextSpan& field, int& value);
+        bool parse_double(const TextSpan& field, double& value);
+
+// Read a whole file into one buffer (the only allocation of a load)
+        bool read_file(const std::string& path, std::string& buffer);
+
+    } // namespace text_parser
+
+} // namespace descansa
+
+#endif // TEXT_DATA_PARSER_H
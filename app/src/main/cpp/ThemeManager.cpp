@@ -1,5 +1,6 @@
 // ThemeManager.cpp - Implementation
 #include "ThemeManager.h"
+#include "DurableFile.h"
 #include <algorithm>
 #include <sstream>
 
@@ -96,11 +97,8 @@ namespace descansa {
     }
 
     bool ThemeManager::save_preferences() const {
-        std::ofstream file(preferences_file_path);
-        if (!file.is_open()) return false;
-
-        file << "CURRENT_THEME:" << current_theme_id << "\n";
-        return file.good();
+        // Temp file + rename - a crash mid-write keeps the previous preference
+        return write_file_durably(preferences_file_path, "CURRENT_THEME:" + current_theme_id + "\n");
     }
 
     bool ThemeManager::load_preferences() {
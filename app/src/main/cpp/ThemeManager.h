@@ -47,7 +47,7 @@ namespace descansa {
         ThemeConfig get_current_theme_config() const;
 
         // Available themes
-        std::vector<ThemeConfig> get_available_themes() const { return available_themes; }
+        const std::vector<ThemeConfig>& get_available_themes() const { return available_themes; }
         std::vector<ThemeConfig> get_light_themes() const;
         std::vector<ThemeConfig> get_dark_themes() const;
 
@@ -0,0 +1,39 @@
+// TimeTypes.h - Integer time representation shared by every session structure
+#ifndef TIME_TYPES_H
+#define TIME_TYPES_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace descansa {
+
+// Durations and timestamps are whole int64 seconds. Sums and comparisons are
+// exact integer arithmetic, and conversions to other units are chrono ratios
+// resolved at compile time (Duration -> Milliseconds widens implicitly;
+// narrowing needs an explicit duration_cast).
+    using Duration = std::chrono::duration<int64_t>;
+    using Milliseconds = std::chrono::duration<int64_t, std::milli>;
+    using Hours = std::chrono::duration<int64_t, std::ratio<3600> >;
+    using TimePoint = std::chrono::time_point<std::chrono::system_clock, Duration>;
+
+// Floor to whole seconds (also correct before 1970)
+    inline TimePoint to_time_point(const std::chrono::system_clock::time_point& tp) {
+        TimePoint truncated = std::chrono::time_point_cast<Duration>(tp);
+        return truncated > tp ? truncated - Duration(1) : truncated;
+    }
+
+    inline TimePoint system_now() { return to_time_point(std::chrono::system_clock::now()); }
+
+    inline int64_t to_epoch_seconds(const TimePoint& tp) { return tp.time_since_epoch().count(); }
+    inline TimePoint from_epoch_seconds(int64_t seconds) { return TimePoint(Duration(seconds)); }
+
+// Display-only conversions (the stored value stays integral)
+    inline double to_hours(const Duration& d) { return static_cast<double>(d.count()) / 3600.0; }
+    inline Duration from_hours(double hours) {
+        double seconds = hours * 3600.0;
+        return Duration(static_cast<int64_t>(seconds < 0 ? seconds - 0.5 : seconds + 0.5));
+    }
+
+} // namespace descansa
+
+#endif // TIME_TYPES_H
@@ -0,0 +1,197 @@
+// TraceBuffer.cpp - Implementation
+#include "TraceBuffer.h"
+#include "DurableFile.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+namespace descansa {
+
+    namespace trace {
+
+        namespace {
+
+            // One span. A seqlock per slot lets the dumper read while the
+            // owning thread wraps around: odd = being written, 2 * index + 2 = done.
+            struct TraceSlot {
+                std::atomic<uint64_t> sequence;
+                std::atomic<const char*> name;
+                std::atomic<uint64_t> start_ns;
+                std::atomic<uint64_t> duration_ns;
+                std::atomic<uint32_t> thread_id;    // a reused ring holds spans of several threads
+            };
+
+            // Rings are never freed, so the list can be walked without locks. A
+            // ring is leased to one thread at a time; an exited thread's spans
+            // stay dumpable until the next owner overwrites them.
+            struct ThreadRing {
+                TraceSlot slots[kRingCapacity];
+                std::atomic<uint64_t> written;
+                std::atomic<bool> in_use;
+                ThreadRing* next;
+            };
+
+            std::atomic<ThreadRing*> g_rings(nullptr);
+            std::atomic<size_t> g_ring_count(0);
+            std::atomic<uint32_t> g_next_thread_id(1);
+            std::atomic<bool> g_enabled(false);
+            std::atomic<uint64_t> g_cleared_before_ns(0);
+
+            // Hands the ring back when its thread exits
+            struct RingLease {
+                ThreadRing* ring;
+                uint32_t thread_id;
+                bool untraced;              // every ring was taken when this thread asked
+
+                ~RingLease() {
+                    if (ring) ring->in_use.store(false, std::memory_order_release);
+                }
+            };
+
+            thread_local RingLease tl_lease;
+
+            ThreadRing* lease_free_ring() {
+                for (ThreadRing* ring = g_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+                    bool in_use = false;
+                    if (ring->in_use.compare_exchange_strong(in_use, true, std::memory_order_acquire,
+                                                             std::memory_order_relaxed)) {
+                        return ring;
+                    }
+                }
+                return nullptr;
+            }
+
+            ThreadRing* ring_for_this_thread() {
+                RingLease& lease = tl_lease;
+                if (lease.ring || lease.untraced) return lease.ring;
+
+                lease.thread_id = g_next_thread_id.fetch_add(1, std::memory_order_relaxed);
+                lease.ring = lease_free_ring();
+                if (lease.ring) return lease.ring;
+
+                if (g_ring_count.fetch_add(1, std::memory_order_relaxed) >= kMaxRings) {
+                    g_ring_count.fetch_sub(1, std::memory_order_relaxed);
+                    lease.untraced = true;
+                    return nullptr;
+                }
+
+                ThreadRing* ring = new ThreadRing();    // value-initialized: all zero
+                ring->in_use.store(true, std::memory_order_relaxed);
+
+                ThreadRing* head = g_rings.load(std::memory_order_relaxed);
+                do {
+                    ring->next = head;
+                } while (!g_rings.compare_exchange_weak(head, ring, std::memory_order_release,
+                                                        std::memory_order_relaxed));
+                lease.ring = ring;
+                return ring;
+            }
+
+            void append_json_string(std::string& out, const char* text) {
+                out += '"';
+                for (const char* c = text; *c; ++c) {
+                    if (*c == '"' || *c == '\\') out += '\\';
+                    if (static_cast<unsigned char>(*c) >= 0x20) out += *c;
+                }
+                out += '"';
+            }
+
+            void append_microseconds(std::string& out, uint64_t nanoseconds) {
+                char buffer[32];
+                std::snprintf(buffer, sizeof(buffer), "%llu.%03u",
+                              static_cast<unsigned long long>(nanoseconds / 1000),
+                              static_cast<unsigned>(nanoseconds % 1000));
+                out += buffer;
+            }
+
+        } // namespace
+
+        bool is_enabled() {
+            return g_enabled.load(std::memory_order_relaxed);
+        }
+
+        void set_enabled(bool enabled) {
+            g_enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        uint64_t now_ns() {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        void record(const char* name, uint64_t start_ns, uint64_t end_ns) {
+            ThreadRing* ring = ring_for_this_thread();
+            if (!ring) return;
+
+            // Only this thread writes its ring, so relaxed reads of its own counter suffice
+            uint64_t index = ring->written.load(std::memory_order_relaxed);
+            TraceSlot& slot = ring->slots[index % kRingCapacity];
+
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            slot.name.store(name, std::memory_order_relaxed);
+            slot.start_ns.store(start_ns, std::memory_order_relaxed);
+            slot.duration_ns.store(end_ns > start_ns ? end_ns - start_ns : 0, std::memory_order_relaxed);
+            slot.thread_id.store(tl_lease.thread_id, std::memory_order_relaxed);
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+            ring->written.store(index + 1, std::memory_order_release);
+        }
+
+        std::string to_chrome_json() {
+            uint64_t cleared_before = g_cleared_before_ns.load(std::memory_order_relaxed);
+            int pid = static_cast<int>(getpid());
+
+            std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            bool first_event = true;
+
+            for (ThreadRing* ring = g_rings.load(std::memory_order_acquire); ring; ring = ring->next) {
+                uint64_t written = ring->written.load(std::memory_order_acquire);
+                uint64_t oldest = written > kRingCapacity ? written - kRingCapacity : 0;
+
+                for (uint64_t index = oldest; index < written; ++index) {
+                    const TraceSlot& slot = ring->slots[index % kRingCapacity];
+
+                    uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+                    if (sequence != 2 * index + 2) continue;    // Already overwritten
+
+                    const char* name = slot.name.load(std::memory_order_relaxed);
+                    uint64_t start = slot.start_ns.load(std::memory_order_relaxed);
+                    uint64_t duration = slot.duration_ns.load(std::memory_order_relaxed);
+                    uint32_t thread_id = slot.thread_id.load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (slot.sequence.load(std::memory_order_relaxed) != sequence) continue; // Torn
+
+                    if (!name || start < cleared_before) continue;
+
+                    json += first_event ? "\n" : ",\n";
+                    first_event = false;
+
+                    json += "{\"name\":";
+                    append_json_string(json, name);
+                    json += ",\"ph\":\"X\",\"ts\":";
+                    append_microseconds(json, start);
+                    json += ",\"dur\":";
+                    append_microseconds(json, duration);
+                    json += ",\"pid\":" + std::to_string(pid);
+                    json += ",\"tid\":" + std::to_string(thread_id) + "}";
+                }
+            }
+
+            json += "\n]}\n";
+            return json;
+        }
+
+        bool dump_chrome_json(const std::string& path) {
+            return write_file_durably(path, to_chrome_json());
+        }
+
+        void clear() {
+            // Rings belong to their threads; hide everything recorded so far instead
+            g_cleared_before_ns.store(now_ns(), std::memory_order_relaxed);
+        }
+
+    } // namespace trace
+
+} // namespace descansa
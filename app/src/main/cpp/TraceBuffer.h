@@ -0,0 +1,68 @@
+// TraceBuffer.h - Low-overhead scoped timing spans in per-thread ring buffers
+#ifndef TRACE_BUFFER_H
+#define TRACE_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace descansa {
+
+    namespace trace {
+
+// Every thread records into its own fixed ring, so recording a span is two
+// monotonic clock reads plus a few relaxed stores - no lock, no allocation
+// after the thread's first span. The newest kRingCapacity spans per ring
+// are kept. A ring goes back to the pool when its thread exits and the next
+// new thread reuses it; past kMaxRings live threads, further threads go
+// untraced. Span names must be string literals (only the pointer is stored).
+// Off until set_enabled(true), so release builds pay one relaxed load per scope.
+        const size_t kRingCapacity = 4096;
+        const size_t kMaxRings = 32;
+
+        bool is_enabled();
+        void set_enabled(bool enabled);
+
+        uint64_t now_ns();  // steady clock
+        void record(const char* name, uint64_t start_ns, uint64_t end_ns);
+
+        // Every thread's retained spans as Chrome trace JSON (chrome://tracing,
+        // Perfetto). Safe while other threads keep recording; a span being
+        // overwritten during the dump is skipped.
+        std::string to_chrome_json();
+        bool dump_chrome_json(const std::string& path);
+        void clear();
+
+// Times its enclosing scope
+        class Scope {
+        private:
+            const char* name;
+            uint64_t start_ns;
+
+            Scope(const Scope&);
+            Scope& operator=(const Scope&);
+
+        public:
+            explicit Scope(const char* span_name)
+                    : name(span_name), start_ns(is_enabled() ? now_ns() : 0) {}
+
+            ~Scope() {
+                if (start_ns != 0) record(name, start_ns, now_ns());
+            }
+        };
+
+    } // namespace trace
+
+} // namespace descansa
+
+#define DESCANSA_TRACE_CONCAT_INNER(a, b) a##b
+#define DESCANSA_TRACE_CONCAT(a, b) DESCANSA_TRACE_CONCAT_INNER(a, b)
+
+#ifdef DESCANSA_DISABLE_TRACING
+#define DESCANSA_TRACE_SCOPE(name) do {} while (0)
+#else
+#define DESCANSA_TRACE_SCOPE(name) \
+    ::descansa::trace::Scope DESCANSA_TRACE_CONCAT(descansa_trace_scope_, __LINE__)(name)
+#endif
+
+#endif // TRACE_BUFFER_H
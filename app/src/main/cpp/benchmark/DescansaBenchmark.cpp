@@ -0,0 +1,552 @@
+// DescansaBenchmark.cpp - Host benchmark over deterministic synthetic sleep histories
+//
+// Generates histories of 1k to 1M sessions in the on-disk formats the app
+// writes, then times load, save, statistics, trend analysis, export and
+// report generation for DescansaCore and DescansaCoreManager. A night of
+// synthetic accelerometer samples is pushed through the SensorPipeline
+// first; the run fails if its epochs or drop count don't add up.
+//
+// Usage: descansa_benchmark [--sizes 1000,10000,...] [--repeat N]
+//                           [--work-dir DIR] [--csv]
+// The work directory defaults to $TMPDIR/descansa_benchmark_data (/tmp without TMPDIR).
+#include "DescansaCore.h"
+#include "DescansaCoreManager.h"
+#include "SleepAnalyticsEngine.h"
+#include "ColumnarSessionStore.h"
+#include "DurableFile.h"
+#include "CivilTime.h"
+#include "StatKernels.h"
+#include "SensorPipeline.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace descansa;
+
+namespace {
+
+    const int64_t kSecondsPerDay = 86400;
+
+    // Histories never span more than this, so large sizes pack sessions closer
+    // together instead of reaching past what system_clock can represent
+    const int64_t kMaxHistorySeconds = 40LL * 365 * kSecondsPerDay;
+
+// xorshift64* - deterministic across platforms and standard libraries
+    class SyntheticRandom {
+    private:
+        uint64_t state;
+
+    public:
+        explicit SyntheticRandom(uint64_t seed) : state(seed ? seed : 0x9E3779B97F4A7C15ULL) {}
+
+        uint64_t next() {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            return state * 0x2545F4914F6CDD1DULL;
+        }
+
+        int64_t uniform(int64_t low, int64_t high) {   // [low, high]
+            return low + static_cast<int64_t>(next() % static_cast<uint64_t>(high - low + 1));
+        }
+    };
+
+// One generated session, in the fields both storage formats need
+    struct SyntheticSession {
+        int64_t sleep_start;
+        int64_t wake_up;
+        double efficiency;
+        int quality;
+        bool is_nap;
+        int awakenings;
+        double temperature;
+        int noise;
+        int light;
+    };
+
+// The same size always yields the same sessions relative to the anchor day
+    std::vector<SyntheticSession> generate_history(size_t count, int64_t anchor_day_start) {
+        std::vector<SyntheticSession> sessions(count);
+        SyntheticRandom random(0xD5CA45AULL + count);
+
+        int64_t step = std::min(kSecondsPerDay, kMaxHistorySeconds / static_cast<int64_t>(count));
+        int64_t first_slot = anchor_day_start - static_cast<int64_t>(count) * step;
+
+        for (size_t i = 0; i < count; ++i) {
+            SyntheticSession& session = sessions[i];
+            int64_t slot = first_slot + static_cast<int64_t>(i) * step;
+
+            // Roughly 22:00-01:00 bedtimes and 5-10 h nights at one session per day;
+            // denser histories scale both down to fit their slot
+            int64_t bedtime_offset = step == kSecondsPerDay ? random.uniform(-2 * 3600, 3600) : 0;
+            int64_t duration = step == kSecondsPerDay ? random.uniform(5 * 3600, 10 * 3600)
+                                                      : random.uniform(step / 4, step / 2);
+
+            session.sleep_start = slot + bedtime_offset;
+            session.wake_up = session.sleep_start + duration;
+            session.efficiency = 70.0 + static_cast<double>(random.uniform(0, 290)) / 10.0;
+            session.quality = static_cast<int>(random.uniform(1, 4));
+            session.is_nap = random.uniform(0, 19) == 0;
+            session.awakenings = static_cast<int>(random.uniform(0, 6));
+            session.temperature = 16.0 + static_cast<double>(random.uniform(0, 80)) / 10.0;
+            session.noise = static_cast<int>(random.uniform(0, 60));
+            session.light = static_cast<int>(random.uniform(0, 40));
+        }
+        return sessions;
+    }
+
+    bool make_directory(const std::string& path) {
+        return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+    }
+
+// DescansaCore layout: column archive plus a snapshot that points at it
+    bool write_core_files(const std::string& data_path, const std::vector<SyntheticSession>& sessions) {
+        ColumnarSessionWriter writer;
+        writer.reserve(sessions.size());
+        for (const auto& session : sessions) {
+            writer.add_row(session.sleep_start, session.wake_up, session.wake_up - session.sleep_start,
+                           8 * 3600, 7 * 60 + 30, session.wake_up);
+        }
+        if (!writer.write(data_path + ".cols")) return false;
+
+        std::ostringstream snapshot;
+        snapshot << "CONFIG:" << 8 * 3600 << ",7,30\n"
+                 << "JOURNAL:0\n"
+                 << "ARCHIVE:" << sessions.size() << "\n";
+
+        unlink((data_path + ".journal").c_str());
+        return write_file_durably(data_path, snapshot.str());
+    }
+
+// DescansaCoreManager layout: the detailed session text file
+    bool write_manager_files(const std::string& directory, const std::vector<SyntheticSession>& sessions) {
+        std::string contents;
+        contents.reserve(sessions.size() * 64);
+        contents += std::to_string(static_cast<unsigned long long>(sessions.size()));
+        contents += '\n';
+
+        char line[256];
+        for (const auto& session : sessions) {
+            std::snprintf(line, sizeof(line), "%lld,%lld,%.1f,%d,%d,%d,%.1f,%d,%d,\"\"\n",
+                          static_cast<long long>(session.sleep_start), static_cast<long long>(session.wake_up),
+                          session.efficiency, session.quality, session.is_nap ? 1 : 0, session.awakenings,
+                          session.temperature, session.noise, session.light);
+            contents += line;
+        }
+
+        unlink((directory + "/basic_data.txt.journal").c_str());
+        return write_file_durably(directory + "/detailed_sessions.dat", contents);
+    }
+
+// One summary per local day, built from the generated sessions
+    std::vector<DailySleepSummary> build_daily_summaries(const std::vector<SyntheticSession>& sessions) {
+        std::vector<DailySleepSummary> summaries;
+        int64_t current_day = 0;
+
+        for (const auto& session : sessions) {
+            int64_t day = civil::local_day(session.wake_up);
+            if (summaries.empty() || day != current_day) {
+                summaries.push_back(DailySleepSummary(civil::from_seconds(civil::from_local(day, 0))));
+                summaries.back().total_sleep_time = Duration(0);
+                current_day = day;
+            }
+            summaries.back().total_sleep_time += Duration(session.wake_up - session.sleep_start);
+        }
+        return summaries;
+    }
+
+// Best of several runs, in milliseconds
+    struct BenchmarkRunner {
+        int repeat;
+        bool csv;
+        size_t size;
+
+        template <typename Body>
+        void run(const char* name, Body body) const {
+            run(name, [] {}, body);
+        }
+
+        // setup runs untimed before every repetition
+        template <typename Setup, typename Body>
+        void run(const char* name, Setup setup, Body body) const {
+            double best = 0.0;
+            for (int i = 0; i < repeat; ++i) {
+                setup();
+                auto start = std::chrono::steady_clock::now();
+                body();
+                double elapsed = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start).count();
+                best = (i == 0 || elapsed < best) ? elapsed : best;
+            }
+
+            if (csv) {
+                std::printf("%zu,%s,%.3f\n", size, name, best);
+            } else {
+                std::printf("%10zu  %-24s %12.3f ms\n", size, name, best);
+            }
+            std::fflush(stdout);
+        }
+    };
+
+// Keeps results observable so the work isn't optimized away
+    volatile double g_sink = 0.0;
+
+    void benchmark_core(const BenchmarkRunner& runner, const std::string& directory,
+                        const std::vector<SyntheticSession>& sessions) {
+        std::string data_path = directory + "/core_data.txt";
+        if (!write_core_files(data_path, sessions)) {
+            std::fprintf(stderr, "failed to write core history in %s\n", directory.c_str());
+            return;
+        }
+
+        std::unique_ptr<DescansaCore> core;
+        runner.run("core.load", [&] { core.reset(); }, [&] {
+            core.reset(new DescansaCore(data_path));
+        });
+
+        runner.run("core.save", [&] { g_sink = core->save_data(); });
+
+        runner.run("core.stats", [&] {
+            g_sink = core->get_average_sleep_duration(7).count() +
+                     core->get_average_sleep_duration(30).count() +
+                     core->get_average_sleep_duration(365).count() +
+                     core->get_sleep_window_stats(90).average_seconds();
+        });
+
+        runner.run("core.dashboard", [&] {
+            g_sink = static_cast<double>(core->get_dashboard_snapshot(7).average_sleep_seconds);
+        });
+
+        std::string export_path = directory + "/core_export.csv";
+        runner.run("core.export_csv", [&] { g_sink = core->export_analysis_csv(export_path); });
+    }
+
+// Samples in one epoch, and whether the epoch's minute is one with movement
+    struct SensorCheck {
+        int64_t start_seconds;
+        int32_t rate_hz;
+        int32_t moving_every_minutes;
+
+        bool is_moving(int64_t epoch_start) const {
+            return ((epoch_start - start_seconds) / 60) % moving_every_minutes == 0;
+        }
+
+        // Two-second batches, as a sensor FIFO delivers them, moving or still by minute
+        static const size_t kBatch = 50;
+        void generate(SyntheticAccelerometer& sensor, AccelerometerSample* out) const {
+            bool moving = is_moving(sensor.next_timestamp_ms() / 1000);
+            sensor.generate(out, kBatch, moving ? 0.3 : 0.0);
+        }
+    };
+
+    bool check_sensor_epochs(const SensorCheck& check, const std::vector<ActivityEpoch>& epochs,
+                             const SensorPipeline& pipeline, size_t pushed) {
+        uint64_t binned = 0;
+        int64_t previous = check.start_seconds - 1;
+        for (const auto& epoch : epochs) {
+            binned += epoch.sample_count;
+            if (epoch.start_seconds <= previous || epoch.start_seconds % epoch.epoch_seconds != 0) {
+                std::fprintf(stderr, "sensor: epoch at %lld out of order or off the grid\n",
+                             static_cast<long long>(epoch.start_seconds));
+                return false;
+            }
+            if (check.is_moving(epoch.start_seconds) != (epoch.activity_count > 0)) {
+                std::fprintf(stderr, "sensor: epoch at %lld has activity %u\n",
+                             static_cast<long long>(epoch.start_seconds), epoch.activity_count);
+                return false;
+            }
+            previous = epoch.start_seconds;
+        }
+
+        // Every sample is either in exactly one epoch or counted as dropped
+        uint64_t dropped = pipeline.get_dropped_samples();
+        if (binned + dropped != pushed || pipeline.get_epoch_count() != epochs.size()) {
+            std::fprintf(stderr, "sensor: %zu pushed, %llu binned, %llu dropped, %llu/%zu epochs\n", pushed,
+                         static_cast<unsigned long long>(binned), static_cast<unsigned long long>(dropped),
+                         static_cast<unsigned long long>(pipeline.get_epoch_count()), epochs.size());
+            return false;
+        }
+
+        size_t samples_per_epoch = static_cast<size_t>(check.rate_hz) * Hypnogram::kDefaultEpochSeconds;
+        if (dropped == 0 && epochs.size() != pushed / samples_per_epoch) {
+            std::fprintf(stderr, "sensor: %zu epochs for %zu samples\n", epochs.size(), pushed);
+            return false;
+        }
+        return true;
+    }
+
+// Eight hours at 25 Hz with a minute of movement every ten minutes; then one
+// burst larger than the ring, whose overflow must be dropped and counted
+    bool benchmark_sensor_pipeline(BenchmarkRunner runner, int64_t start_seconds) {
+        const size_t kBatch = SensorCheck::kBatch;
+        SensorCheck check;
+        check.start_seconds = start_seconds;
+        check.rate_hz = 25;
+        check.moving_every_minutes = 10;
+        const size_t total = 8 * 3600 * static_cast<size_t>(check.rate_hz);
+        runner.size = total;
+
+        // The sink runs on the consumer thread; stop() returning orders it before the checks
+        std::vector<ActivityEpoch> epochs;
+        std::unique_ptr<SensorPipeline> pipeline;
+        bool ok = true;
+
+        runner.run("sensor.pipeline", [&] {
+            epochs.clear();
+            pipeline.reset(new SensorPipeline([&epochs](const ActivityEpoch& epoch) { epochs.push_back(epoch); },
+                                              SensorPipeline::kDefaultCapacity, Hypnogram::kDefaultEpochSeconds,
+                                              std::chrono::milliseconds(1)));
+        }, [&] {
+            SyntheticAccelerometer sensor(start_seconds * 1000, check.rate_hz);
+            AccelerometerSample batch[kBatch];
+
+            pipeline->start();
+            for (size_t pushed = 0; pushed < total; pushed += kBatch) {
+                check.generate(sensor, batch);
+                pipeline->push_samples(batch, kBatch);
+            }
+            pipeline->stop();
+        });
+        ok = check_sensor_epochs(check, epochs, *pipeline, total);
+
+        // Nothing drains a ring between the two halves of one push
+        const size_t kCapacity = 1024;
+        const size_t kBurst = 4 * kCapacity - 46;     // a whole number of batches
+        std::vector<AccelerometerSample> burst(kBurst);
+        SyntheticAccelerometer sensor(start_seconds * 1000, check.rate_hz);
+        for (size_t offset = 0; offset < kBurst; offset += kBatch) {
+            check.generate(sensor, &burst[offset]);
+        }
+
+        epochs.clear();
+        pipeline.reset(new SensorPipeline([&epochs](const ActivityEpoch& epoch) { epochs.push_back(epoch); },
+                                          kCapacity));
+        pipeline->start();
+        size_t accepted = pipeline->push_samples(burst.data(), kBurst);
+        pipeline->stop();
+
+        if (accepted > kCapacity || pipeline->get_dropped_samples() != kBurst - accepted) {
+            std::fprintf(stderr, "sensor: burst of %zu took %zu, dropped %llu\n", kBurst, accepted,
+                         static_cast<unsigned long long>(pipeline->get_dropped_samples()));
+            ok = false;
+        }
+        return check_sensor_epochs(check, epochs, *pipeline, kBurst) && ok;
+    }
+
+    void benchmark_manager(const BenchmarkRunner& runner, const std::string& directory,
+                           const std::vector<SyntheticSession>& sessions) {
+        if (!write_manager_files(directory, sessions)) {
+            std::fprintf(stderr, "failed to write manager history in %s\n", directory.c_str());
+            return;
+        }
+
+        std::unique_ptr<DescansaCoreManager> manager;
+        runner.run("manager.load", [&] { manager.reset(); }, [&] {
+            manager.reset(new DescansaCoreManager(directory));
+        });
+
+        runner.run("manager.save", [&] { g_sink = manager->save_all_data(); });
+
+        TimePoint history_start = civil::from_seconds(sessions.front().sleep_start);
+        TimePoint history_end = civil::from_seconds(sessions.back().wake_up);
+        runner.run("manager.stats", [&] {
+            SleepStatistics all = manager->calculate_statistics(history_start, history_end);
+            SleepStatistics recent = manager->calculate_recent_statistics(30);
+            g_sink = all.average_sleep_duration.count() + recent.average_sleep_duration.count();
+        });
+
+        std::vector<DetailedSleepSession> detailed = manager->get_sessions().to_vector();
+        std::vector<DailySleepSummary> summaries = build_daily_summaries(sessions);
+        SleepAnalyticsEngine engine(detailed, summaries);
+
+        runner.run("manager.trend", [&] {
+            SleepStatistics stats;
+            stats.calculate_trends(summaries);
+            g_sink = static_cast<double>(engine.identify_advanced_patterns().size()) +
+                     static_cast<double>(stats.sleep_duration_trend == SleepStatistics::Trend::STABLE);
+        });
+
+        std::string export_path = directory + "/manager_export.txt";
+        runner.run("manager.export_detailed", [&] { g_sink = manager->export_detailed_data(export_path); });
+
+        runner.run("manager.report", [&] {
+            SleepStatistics stats = manager->calculate_statistics(history_start, history_end);
+            std::string report = stats.generate_summary_report();
+            report += manager->get_system_status();
+            g_sink = static_cast<double>(report.size() + engine.generate_optimization_plan().size());
+        });
+
+        manager.reset();
+    }
+
+// Sessions whose asleep time comes from their hypnogram must come back from
+// a save with the same duration and efficiency they had before it
+    struct ReloadedTotals {
+        std::vector<int64_t> sleep_seconds;
+        std::vector<double> efficiencies;
+        std::vector<int64_t> column_durations;
+        std::vector<int64_t> daily_seconds;
+    };
+
+    ReloadedTotals collect_totals(const DescansaCoreManager& manager) {
+        ReloadedTotals totals;
+        ConstSpan<DetailedSleepSession> sessions = manager.get_sessions();
+        const DetailedSessionColumns& columns = manager.get_session_columns();
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            totals.sleep_seconds.push_back(sessions[i].total_sleep_duration.count());
+            totals.efficiencies.push_back(sessions[i].sleep_efficiency);
+            totals.column_durations.push_back(columns.durations()[i]);
+            totals.daily_seconds.push_back(manager.get_daily_summary(sessions[i].wake_up).total_sleep_time.count());
+        }
+        return totals;
+    }
+
+    bool check_manager_reload(const std::string& directory, int64_t anchor) {
+        const char* files[] = {"detailed_sessions.dat", "daily_summaries.dat", "metric_sketches.dat",
+                               "user_goals.dat", "basic_data.txt", "basic_data.txt.journal", "basic_data.txt.cols"};
+        for (const char* file : files) {
+            unlink((directory + "/" + file).c_str());
+        }
+
+        // Eight-hour nights: no stages, one-minute sleep/wake scores, 30 s stages
+        const int64_t kNight = 8 * 3600;
+        const char* hypnograms[] = {"", ":60:W10S400W30S40", ":30:W20L300D200R300W140"};
+        const int64_t asleep[] = {kNight, 440 * 60, 800 * 30};
+
+        std::ostringstream contents;
+        contents << 3 << "\n";
+        for (int night = 0; night < 3; ++night) {
+            int64_t start = anchor - (3 - night) * kSecondsPerDay - kNight;
+            contents << start << "," << start + kNight << "," << 100.0 * asleep[night] / kNight
+                     << ",3,0,0,20.0,10,5,\"\"";
+            if (hypnograms[night][0] != '\0') contents << "," << start << hypnograms[night];
+            contents << "\n";
+        }
+        if (!write_file_durably(directory + "/detailed_sessions.dat", contents.str())) return false;
+
+        ReloadedTotals before;
+        {
+            DescansaCoreManager manager(directory);
+            before = collect_totals(manager);
+            if (!manager.save_all_data()) {
+                std::fprintf(stderr, "reload: save failed\n");
+                return false;
+            }
+        }
+        DescansaCoreManager reloaded(directory);
+        ReloadedTotals after = collect_totals(reloaded);
+
+        bool ok = before.sleep_seconds.size() == 3 && after.sleep_seconds == before.sleep_seconds &&
+                  after.efficiencies == before.efficiencies && after.column_durations == before.column_durations &&
+                  after.daily_seconds == before.daily_seconds;
+        for (size_t night = 0; ok && night < 3; ++night) {
+            ok = before.sleep_seconds[night] == asleep[night] && before.column_durations[night] == asleep[night];
+        }
+        if (!ok) {
+            std::fprintf(stderr, "reload: session totals changed across save and load\n");
+        }
+        return ok;
+    }
+
+    std::vector<size_t> parse_sizes(const char* text) {
+        std::vector<size_t> sizes;
+        std::stringstream stream(text);
+        std::string token;
+        while (std::getline(stream, token, ',')) {
+            long long value = std::atoll(token.c_str());
+            if (value > 0) sizes.push_back(static_cast<size_t>(value));
+        }
+        return sizes;
+    }
+
+// Generated histories go under the temp directory, never the working (source) directory
+    std::string default_work_dir() {
+        const char* temp = std::getenv("TMPDIR");
+        std::string base = (temp != nullptr && temp[0] != '\0') ? temp : "/tmp";
+        return base + "/descansa_benchmark_data";
+    }
+
+    void print_usage(const char* program) {
+        std::fprintf(stderr, "usage: %s [--sizes 1000,10000,...] [--repeat N] [--work-dir DIR] [--csv]\n", program);
+    }
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<size_t> sizes;
+    sizes.push_back(1000);
+    sizes.push_back(10000);
+    sizes.push_back(100000);
+    sizes.push_back(1000000);
+
+    BenchmarkRunner runner;
+    runner.repeat = 3;
+    runner.csv = false;
+    runner.size = 0;
+    std::string work_dir = default_work_dir();
+
+    for (int i = 1; i < argc; ++i) {
+        bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--sizes") == 0 && has_value) {
+            sizes = parse_sizes(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && has_value) {
+            runner.repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--work-dir") == 0 && has_value) {
+            work_dir = argv[++i];
+        } else if (std::strcmp(argv[i], "--csv") == 0) {
+            runner.csv = true;
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (sizes.empty() || !make_directory(work_dir)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    // Histories end at the start of today so the 7/30/90-day windows have data
+    int64_t anchor = civil::start_of_local_day(civil::to_seconds(system_now()));
+
+    if (runner.csv) {
+        std::printf("sessions,benchmark,best_ms\n");
+    } else {
+        std::printf("stat kernels: %s\n", stat_kernels::active_kernel());
+    }
+
+    if (!benchmark_sensor_pipeline(runner, anchor)) {
+        std::fprintf(stderr, "sensor pipeline check failed\n");
+        return 1;
+    }
+
+    if (!make_directory(work_dir + "/reload") || !check_manager_reload(work_dir + "/reload", anchor)) {
+        std::fprintf(stderr, "manager reload check failed\n");
+        return 1;
+    }
+
+    for (size_t size : sizes) {
+        runner.size = size;
+        std::vector<SyntheticSession> sessions = generate_history(size, anchor);
+
+        std::string directory = work_dir + "/" + std::to_string(static_cast<unsigned long long>(size));
+        if (!make_directory(directory)) {
+            std::fprintf(stderr, "cannot create %s\n", directory.c_str());
+            return 1;
+        }
+
+        benchmark_core(runner, directory, sessions);
+        benchmark_manager(runner, directory, sessions);
+    }
+
+    return 0;
+}
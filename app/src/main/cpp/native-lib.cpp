@@ -1,25 +1,88 @@
 #include <jni.h>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <android/log.h>
 #include "DescansaCore.h"
+#include "CoreSnapshot.h"
+#include "PersistenceWorker.h"
+#include "TraceBuffer.h"
 
 #define LOG_TAG "DescansaNative"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// SIMPLIFIED: Only one core instance
+// SIMPLIFIED: Only one core instance, guarded by g_core_mutex
+static std::mutex g_core_mutex;
 static std::unique_ptr<descansa::DescansaCore> g_core;
 
-// Helper function to ensure core is initialized
+// Latest published state of g_core. Queries load it without g_core_mutex,
+// so exports and UI reads never wait behind a mutation or a disk write.
+static std::shared_ptr<const descansa::CoreSnapshot> g_state;
+
+// Background writer - JNI mutations only queue journal records and return
+static std::unique_ptr<descansa::PersistenceWorker> g_persistence;
+
+// Held for a whole flush so g_core can't be replaced mid-write. Always taken
+// before g_core_mutex, never while holding it.
+static std::mutex g_flush_mutex;
+
+// Runs on the persistence thread: one append for everything queued so far.
+// g_core_mutex is only held to take the queued records and to fold the
+// result back in; the fsync'd append or snapshot commit runs without it.
+static bool flush_core_writes() {
+    std::lock_guard<std::mutex> flushing(g_flush_mutex);
+
+    descansa::DescansaCore::PendingWrites writes;
+    {
+        std::lock_guard<std::mutex> lock(g_core_mutex);
+        if (!g_core || !g_core->take_pending_writes(writes)) return true;
+    }
+
+    bool ok = g_core->write_pending_writes(writes);
+
+    std::lock_guard<std::mutex> lock(g_core_mutex);
+    g_core->finish_pending_writes(writes, ok);
+    return ok;
+}
+
+// Route a freshly created core's writes through the background worker (g_core_mutex held)
+static void attach_persistence(descansa::DescansaCore* core) {
+    if (!g_persistence) {
+        g_persistence.reset(new descansa::PersistenceWorker(flush_core_writes));
+    }
+    core->set_dirty_callback([] { g_persistence->mark_dirty(); });
+}
+
+// Mirror every version the core publishes into g_state (g_core_mutex held)
+static void attach_state(descansa::DescansaCore* core) {
+    core->set_publish_callback([](const std::shared_ptr<const descansa::CoreSnapshot>& state) {
+        std::atomic_store(&g_state, state);
+    });
+    std::atomic_store(&g_state, core->snapshot());
+}
+
+// Helper function to ensure core is initialized (g_core_mutex held)
 void ensure_core_initialized(const std::string& data_path = "") {
     if (!g_core) {
         LOGD("Initializing core with path: %s", data_path.c_str());
         g_core.reset(new descansa::DescansaCore(data_path));
+        attach_persistence(g_core.get());
+        attach_state(g_core.get());
         LOGD("Core initialized successfully");
     }
 }
 
+// Lock-free read path; only the very first call (before initializeCore) locks
+static std::shared_ptr<const descansa::CoreSnapshot> current_state() {
+    std::shared_ptr<const descansa::CoreSnapshot> state = std::atomic_load(&g_state);
+    if (state) return state;
+
+    std::lock_guard<std::mutex> lock(g_core_mutex);
+    ensure_core_initialized();
+    return g_core->snapshot();
+}
+
 extern "C" {
 
 // ========== CORE INITIALIZATION ==========
@@ -27,6 +90,7 @@ extern "C" {
 JNIEXPORT void JNICALL
 Java_io_nava_descansa_app_MainActivity_initializeCore(
         JNIEnv* env, jobject, jstring data_path) {
+    DESCANSA_TRACE_SCOPE("jni.initializeCore");
 
     const char* path_chars = env->GetStringUTFChars(data_path, nullptr);
     std::string path(path_chars);
@@ -35,11 +99,20 @@ Java_io_nava_descansa_app_MainActivity_initializeCore(
     LOGD("=== INITIALIZING CORE ===");
     LOGD("Data path: %s", path.c_str());
 
+    // Drain the previous core's queued writes before replacing it
+    if (g_persistence) {
+        g_persistence->flush();
+    }
+
+    std::lock_guard<std::mutex> flushing(g_flush_mutex);
+    std::lock_guard<std::mutex> lock(g_core_mutex);
     g_core.reset(new descansa::DescansaCore(path));
+    attach_persistence(g_core.get());
+    attach_state(g_core.get());
 
     // Log the loaded configuration to verify settings are preserved
     const auto& config = g_core->get_config();
-    double hours = config.target_sleep_hours.count() / 3600.0;
+    double hours = descansa::to_hours(config.target_sleep_hours);
     int wake_hour = static_cast<int>(config.target_wake_hour.count());
     int wake_minute = static_cast<int>(config.target_wake_minute.count());
 
@@ -47,6 +120,10 @@ Java_io_nava_descansa_app_MainActivity_initializeCore(
     LOGD("  - Sleep hours: %.2f", hours);
     LOGD("  - Wake time: %d:%02d", wake_hour, wake_minute);
     LOGD("  - Session count: %zu", g_core->get_session_count());
+    if (!g_core->is_archive_intact()) {
+        LOGE("Session archive unreadable (%zu rows missing) - snapshots paused, journal still written",
+             g_core->get_missing_archive_rows());
+    }
     LOGD("=== CORE INITIALIZATION COMPLETE ===");
 }
 
@@ -54,30 +131,32 @@ Java_io_nava_descansa_app_MainActivity_initializeCore(
 
 JNIEXPORT void JNICALL
 Java_io_nava_descansa_app_MainActivity_startSleepSession(JNIEnv*, jobject) {
+    DESCANSA_TRACE_SCOPE("jni.startSleepSession");
+    std::lock_guard<std::mutex> lock(g_core_mutex);
     ensure_core_initialized();
     LOGD("Starting sleep session");
     g_core->start_sleep_session();
 
-    // FORCE SAVE immediately after starting
-    bool saved = g_core->save_data();
-    LOGD("Session started, data saved: %s", saved ? "true" : "false");
+    // Queued for the persistence worker - written after the debounce
+    LOGD("Session started, write pending: %s", g_core->has_pending_writes() ? "true" : "false");
 }
 
 JNIEXPORT void JNICALL
 Java_io_nava_descansa_app_MainActivity_endSleepSession(JNIEnv*, jobject) {
+    DESCANSA_TRACE_SCOPE("jni.endSleepSession");
+    std::lock_guard<std::mutex> lock(g_core_mutex);
     ensure_core_initialized();
     LOGD("Ending sleep session");
     g_core->end_sleep_session();
 
-    // FORCE SAVE immediately after ending
-    bool saved = g_core->save_data();
-    LOGD("Session ended, data saved: %s", saved ? "true" : "false");
+    // Queued for the persistence worker - written after the debounce
+    LOGD("Session ended, write pending: %s", g_core->has_pending_writes() ? "true" : "false");
 }
 
 JNIEXPORT jboolean JNICALL
 Java_io_nava_descansa_app_MainActivity_isSessionRunning(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    bool running = g_core->is_session_running();
+    DESCANSA_TRACE_SCOPE("jni.isSessionRunning");
+    bool running = current_state()->is_session_running();
     LOGD("Session running check: %s", running ? "true" : "false");
     return running;
 }
@@ -86,29 +165,27 @@ Java_io_nava_descansa_app_MainActivity_isSessionRunning(JNIEnv*, jobject) {
 
 JNIEXPORT void JNICALL
 Java_io_nava_descansa_app_MainActivity_setTargetSleepHours(JNIEnv*, jobject, jdouble hours) {
+    DESCANSA_TRACE_SCOPE("jni.setTargetSleepHours");
+    std::lock_guard<std::mutex> lock(g_core_mutex);
     ensure_core_initialized();
     LOGD("=== SETTING TARGET SLEEP HOURS: %.2f ===", hours);
     g_core->set_target_sleep_hours(hours);
-
-    // Save settings immediately and verify
-    bool saved = g_core->save_data();
-    LOGD("Sleep hours set and saved: %s", saved ? "SUCCESS" : "FAILED");
+    LOGD("Sleep hours set, write queued");
 
     // Verify the setting was actually stored
     const auto& config = g_core->get_config();
-    double stored_hours = config.target_sleep_hours.count() / 3600.0;
+    double stored_hours = descansa::to_hours(config.target_sleep_hours);
     LOGD("Verification - stored sleep hours: %.2f", stored_hours);
 }
 
 JNIEXPORT void JNICALL
 Java_io_nava_descansa_app_MainActivity_setTargetWakeTime(JNIEnv*, jobject, jint hour, jint minute) {
+    DESCANSA_TRACE_SCOPE("jni.setTargetWakeTime");
+    std::lock_guard<std::mutex> lock(g_core_mutex);
     ensure_core_initialized();
     LOGD("=== SETTING TARGET WAKE TIME: %d:%02d ===", hour, minute);
     g_core->set_target_wake_time(hour, minute);
-
-    // Save settings immediately and verify
-    bool saved = g_core->save_data();
-    LOGD("Wake time set and saved: %s", saved ? "SUCCESS" : "FAILED");
+    LOGD("Wake time set, write queued");
 
     // Verify the setting was actually stored
     const auto& config = g_core->get_config();
@@ -119,17 +196,19 @@ Java_io_nava_descansa_app_MainActivity_setTargetWakeTime(JNIEnv*, jobject, jint
 
 JNIEXPORT jdouble JNICALL
 Java_io_nava_descansa_app_MainActivity_getCurrentTargetSleepHours(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    const auto& config = g_core->get_config();
-    double hours = config.target_sleep_hours.count() / 3600.0;
+    DESCANSA_TRACE_SCOPE("jni.getCurrentTargetSleepHours");
+    auto state = current_state();
+    const auto& config = state->get_config();
+    double hours = descansa::to_hours(config.target_sleep_hours);
     LOGD("Current target sleep hours: %.1f", hours);
     return hours;
 }
 
 JNIEXPORT jint JNICALL
 Java_io_nava_descansa_app_MainActivity_getCurrentWakeHour(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    const auto& config = g_core->get_config();
+    DESCANSA_TRACE_SCOPE("jni.getCurrentWakeHour");
+    auto state = current_state();
+    const auto& config = state->get_config();
     int hour = static_cast<int>(config.target_wake_hour.count());
     LOGD("Current wake hour: %d", hour);
     return hour;
@@ -137,8 +216,9 @@ Java_io_nava_descansa_app_MainActivity_getCurrentWakeHour(JNIEnv*, jobject) {
 
 JNIEXPORT jint JNICALL
 Java_io_nava_descansa_app_MainActivity_getCurrentWakeMinute(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    const auto& config = g_core->get_config();
+    DESCANSA_TRACE_SCOPE("jni.getCurrentWakeMinute");
+    auto state = current_state();
+    const auto& config = state->get_config();
     int minute = static_cast<int>(config.target_wake_minute.count());
     LOGD("Current wake minute: %d", minute);
     return minute;
@@ -148,8 +228,9 @@ Java_io_nava_descansa_app_MainActivity_getCurrentWakeMinute(JNIEnv*, jobject) {
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getRemainingWorkTimeFormatted(JNIEnv* env, jobject) {
-    ensure_core_initialized();
-    auto duration = g_core->get_remaining_work_time();
+    DESCANSA_TRACE_SCOPE("jni.getRemainingWorkTimeFormatted");
+    auto state = current_state();
+    auto duration = state->get_remaining_work_time(descansa::utils::now());
     std::string formatted = descansa::utils::format_duration(duration);
     LOGD("Remaining work time: %s", formatted.c_str());
     return env->NewStringUTF(formatted.c_str());
@@ -157,8 +238,9 @@ Java_io_nava_descansa_app_MainActivity_getRemainingWorkTimeFormatted(JNIEnv* env
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getLastSleepDurationFormatted(JNIEnv* env, jobject) {
-    ensure_core_initialized();
-    auto duration = g_core->get_last_sleep_duration();
+    DESCANSA_TRACE_SCOPE("jni.getLastSleepDurationFormatted");
+    auto state = current_state();
+    auto duration = state->get_last_sleep_duration();
     std::string formatted = descansa::utils::format_duration(duration);
     LOGD("Last sleep duration: %s", formatted.c_str());
     return env->NewStringUTF(formatted.c_str());
@@ -166,8 +248,9 @@ Java_io_nava_descansa_app_MainActivity_getLastSleepDurationFormatted(JNIEnv* env
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getAverageSleepDurationFormatted(JNIEnv* env, jobject, jint days) {
-    ensure_core_initialized();
-    auto duration = g_core->get_average_sleep_duration(days);
+    DESCANSA_TRACE_SCOPE("jni.getAverageSleepDurationFormatted");
+    auto state = current_state();
+    auto duration = state->get_average_sleep_duration(descansa::utils::now(), days);
     std::string formatted = descansa::utils::format_duration(duration);
     LOGD("Average sleep duration (%d days): %s", days, formatted.c_str());
     return env->NewStringUTF(formatted.c_str());
@@ -175,58 +258,114 @@ Java_io_nava_descansa_app_MainActivity_getAverageSleepDurationFormatted(JNIEnv*
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getCurrentSessionDurationFormatted(JNIEnv* env, jobject) {
-    ensure_core_initialized();
-    auto duration = g_core->get_current_session_duration();
+    DESCANSA_TRACE_SCOPE("jni.getCurrentSessionDurationFormatted");
+    auto state = current_state();
+    auto duration = state->get_current_session_duration(descansa::utils::now());
     std::string formatted = descansa::utils::format_duration(duration);
     return env->NewStringUTF(formatted.c_str());
 }
 
 JNIEXPORT jint JNICALL
 Java_io_nava_descansa_app_MainActivity_getSessionCount(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    int count = static_cast<int>(g_core->get_session_count());
+    DESCANSA_TRACE_SCOPE("jni.getSessionCount");
+    auto state = current_state();
+    int count = static_cast<int>(state->get_session_count());
     LOGD("Session count: %d", count);
     return count;
 }
 
+// ========== DASHBOARD SNAPSHOT ==========
+
+// Slots of the long[] filled by fillDashboardSnapshot - keep in step with
+// the DASH_* constants in MainActivity
+enum DashboardSlot {
+    DASH_TAKEN_AT = 0,
+    DASH_FLAGS,                     // bit 0 running, bit 1 in sleep period, bit 2 before target wake
+    DASH_CURRENT_SESSION_SECONDS,
+    DASH_REMAINING_WORK_SECONDS,
+    DASH_TIME_UNTIL_WAKE_SECONDS,
+    DASH_TIME_UNTIL_NEXT_WAKE_SECONDS,
+    DASH_NEXT_WAKE_MINUTE_OF_DAY,
+    DASH_LAST_SLEEP_SECONDS,
+    DASH_AVERAGE_SLEEP_SECONDS,
+    DASH_SESSION_COUNT,
+    DASH_SLOT_COUNT
+};
+
+// One boundary crossing per UI refresh: every value from one clock read,
+// written into a caller-owned array so no Java objects are allocated
+JNIEXPORT jboolean JNICALL
+Java_io_nava_descansa_app_MainActivity_fillDashboardSnapshot(JNIEnv* env, jobject, jlongArray out, jint averageDays) {
+    DESCANSA_TRACE_SCOPE("jni.fillDashboardSnapshot");
+    if (!out || env->GetArrayLength(out) < DASH_SLOT_COUNT) {
+        LOGE("Dashboard snapshot array too small");
+        return false;
+    }
+
+    descansa::DashboardSnapshot snapshot = current_state()->get_dashboard(descansa::utils::now(), averageDays);
+
+    jlong values[DASH_SLOT_COUNT];
+    values[DASH_TAKEN_AT] = snapshot.taken_at;
+    values[DASH_FLAGS] = (snapshot.session_running ? 1 : 0) |
+                         (snapshot.in_sleep_period ? 2 : 0) |
+                         (snapshot.before_target_wake ? 4 : 0);
+    values[DASH_CURRENT_SESSION_SECONDS] = snapshot.current_session_seconds;
+    values[DASH_REMAINING_WORK_SECONDS] = snapshot.remaining_work_seconds;
+    values[DASH_TIME_UNTIL_WAKE_SECONDS] = snapshot.time_until_wake_seconds;
+    values[DASH_TIME_UNTIL_NEXT_WAKE_SECONDS] = snapshot.time_until_next_wake_seconds;
+    values[DASH_NEXT_WAKE_MINUTE_OF_DAY] = snapshot.next_wake_minute_of_day;
+    values[DASH_LAST_SLEEP_SECONDS] = snapshot.last_sleep_seconds;
+    values[DASH_AVERAGE_SLEEP_SECONDS] = snapshot.average_sleep_seconds;
+    values[DASH_SESSION_COUNT] = snapshot.session_count;
+
+    env->SetLongArrayRegion(out, 0, DASH_SLOT_COUNT, values);
+    return true;
+}
+
 // ========== SLEEP PERIOD DETECTION ==========
 
 JNIEXPORT jboolean JNICALL
 Java_io_nava_descansa_app_MainActivity_isInSleepPeriod(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    bool inSleep = g_core->is_in_sleep_period();
+    DESCANSA_TRACE_SCOPE("jni.isInSleepPeriod");
+    auto state = current_state();
+    bool inSleep = state->is_in_sleep_period(descansa::utils::now());
     LOGD("In sleep period: %s", inSleep ? "true" : "false");
     return inSleep;
 }
 
 JNIEXPORT jboolean JNICALL
 Java_io_nava_descansa_app_MainActivity_isBeforeTargetWakeTime(JNIEnv*, jobject) {
-    ensure_core_initialized();
-    bool beforeWake = g_core->is_before_target_wake_time();
+    DESCANSA_TRACE_SCOPE("jni.isBeforeTargetWakeTime");
+    auto state = current_state();
+    bool beforeWake = state->is_before_target_wake_time(descansa::utils::now());
     LOGD("Before target wake: %s", beforeWake ? "true" : "false");
     return beforeWake;
 }
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getTimeUntilWakeFormatted(JNIEnv* env, jobject) {
-    ensure_core_initialized();
-    auto duration = g_core->get_time_until_target_wake();
+    DESCANSA_TRACE_SCOPE("jni.getTimeUntilWakeFormatted");
+    auto state = current_state();
+    auto duration = state->get_time_until_target_wake(descansa::utils::now());
     std::string formatted = descansa::utils::format_duration(duration);
     return env->NewStringUTF(formatted.c_str());
 }
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getTimeUntilNextWakeFormatted(JNIEnv* env, jobject) {
-    ensure_core_initialized();
-    auto duration = g_core->get_time_until_next_wake();
+    DESCANSA_TRACE_SCOPE("jni.getTimeUntilNextWakeFormatted");
+    auto state = current_state();
+    auto duration = state->get_time_until_next_wake(descansa::utils::now());
     std::string formatted = descansa::utils::format_duration(duration);
     return env->NewStringUTF(formatted.c_str());
 }
 
 JNIEXPORT jstring JNICALL
 Java_io_nava_descansa_app_MainActivity_getNextWakeTimeFormatted(JNIEnv* env, jobject) {
-    ensure_core_initialized();
-    std::string formatted = g_core->get_next_wake_time_formatted();
+    DESCANSA_TRACE_SCOPE("jni.getNextWakeTimeFormatted");
+    auto state = current_state();
+    std::string formatted = descansa::DescansaCore::format_wake_time_24h(
+            state->get_next_wake_time(descansa::utils::now()));
     return env->NewStringUTF(formatted.c_str());
 }
 
@@ -234,26 +373,29 @@ Java_io_nava_descansa_app_MainActivity_getNextWakeTimeFormatted(JNIEnv* env, job
 
 JNIEXPORT jboolean JNICALL
 Java_io_nava_descansa_app_MainActivity_saveData(JNIEnv*, jobject) {
-    if (!g_core) {
+    DESCANSA_TRACE_SCOPE("jni.saveData");
+    if (!g_persistence) {
         LOGE("Cannot save data - core not initialized");
         return false;
     }
 
-    bool saved = g_core->save_data();
+    // Flush barrier (onPause/onDestroy): every queued mutation is on disk when this returns
+    bool saved = g_persistence->flush();
     LOGD("=== SAVE DATA CALLED - Result: %s ===", saved ? "SUCCESS" : "FAILED");
     return saved;
 }
 
 JNIEXPORT jboolean JNICALL
 Java_io_nava_descansa_app_MainActivity_exportAnalysisCsv(JNIEnv* env, jobject, jstring export_path) {
-    ensure_core_initialized();
+    DESCANSA_TRACE_SCOPE("jni.exportAnalysisCsv");
+    auto state = current_state();
 
     const char* path_chars = env->GetStringUTFChars(export_path, nullptr);
     std::string path(path_chars);
     env->ReleaseStringUTFChars(export_path, path_chars);
 
     LOGD("Exporting CSV to: %s", path.c_str());
-    bool success = g_core->export_analysis_csv(path);
+    bool success = state->export_analysis_csv(path);
     LOGD("Export result: %s", success ? "SUCCESS" : "FAILED");
 
     return success;
@@ -261,10 +403,46 @@ Java_io_nava_descansa_app_MainActivity_exportAnalysisCsv(JNIEnv* env, jobject, j
 
 JNIEXPORT void JNICALL
 Java_io_nava_descansa_app_MainActivity_clearHistory(JNIEnv*, jobject) {
+    DESCANSA_TRACE_SCOPE("jni.clearHistory");
+    std::lock_guard<std::mutex> lock(g_core_mutex);
     ensure_core_initialized();
     LOGD("=== CLEARING ALL DATA ===");
     g_core->clear_history();
     LOGD("Data cleared");
 }
 
+// Called from MainActivity's ACTION_TIMEZONE_CHANGED receiver
+JNIEXPORT void JNICALL
+Java_io_nava_descansa_app_MainActivity_onTimeZoneChanged(JNIEnv*, jobject) {
+    DESCANSA_TRACE_SCOPE("jni.onTimeZoneChanged");
+    std::lock_guard<std::mutex> lock(g_core_mutex);
+    ensure_core_initialized();
+    g_core->on_time_zone_changed();
+    LOGD("Time zone changed - local day caches dropped");
+}
+
+
+// ========== TRACING ==========
+
+JNIEXPORT void JNICALL
+Java_io_nava_descansa_app_MainActivity_setNativeTracingEnabled(JNIEnv*, jobject, jboolean enabled) {
+    descansa::trace::set_enabled(enabled);
+}
+
+// Writes every thread's recent spans as Chrome trace JSON (open in Perfetto or chrome://tracing)
+JNIEXPORT jboolean JNICALL
+Java_io_nava_descansa_app_MainActivity_dumpNativeTrace(JNIEnv* env, jobject, jstring output_path) {
+    const char* path_chars = env->GetStringUTFChars(output_path, nullptr);
+    std::string path(path_chars);
+    env->ReleaseStringUTFChars(output_path, path_chars);
+
+    bool success = descansa::trace::dump_chrome_json(path);
+    LOGD("Trace dump to %s: %s", path.c_str(), success ? "SUCCESS" : "FAILED");
+    return success;
+}
+
+JNIEXPORT void JNICALL
+Java_io_nava_descansa_app_MainActivity_clearNativeTrace(JNIEnv*, jobject) {
+    descansa::trace::clear();
+}
 } // extern "C"
\ No newline at end of file
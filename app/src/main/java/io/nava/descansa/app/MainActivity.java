@@ -6,6 +6,9 @@ import androidx.appcompat.app.AppCompatDelegate;
 import androidx.core.view.WindowCompat;
 import androidx.core.view.WindowInsetsControllerCompat;
 
+import android.content.BroadcastReceiver;
+import android.content.Context;
+import android.content.IntentFilter;
 import android.content.SharedPreferences;
 import android.os.Bundle;
 import android.os.Environment;
@@ -31,6 +34,36 @@ public class MainActivity extends AppCompatActivity {
     private Runnable updateRunnable;
     private boolean isUpdating = false;
 
+    // Dashboard snapshot slots - must match DashboardSlot in native-lib.cpp
+    private static final int DASH_TAKEN_AT = 0;
+    private static final int DASH_FLAGS = 1;
+    private static final int DASH_CURRENT_SESSION_SECONDS = 2;
+    private static final int DASH_REMAINING_WORK_SECONDS = 3;
+    private static final int DASH_TIME_UNTIL_WAKE_SECONDS = 4;
+    private static final int DASH_TIME_UNTIL_NEXT_WAKE_SECONDS = 5;
+    private static final int DASH_NEXT_WAKE_MINUTE_OF_DAY = 6;
+    private static final int DASH_LAST_SLEEP_SECONDS = 7;
+    private static final int DASH_AVERAGE_SLEEP_SECONDS = 8;
+    private static final int DASH_SESSION_COUNT = 9;
+    private static final int DASH_SLOT_COUNT = 10;
+
+    private static final long FLAG_SESSION_RUNNING = 1;
+    private static final long FLAG_IN_SLEEP_PERIOD = 2;
+    private static final long FLAG_BEFORE_TARGET_WAKE = 4;
+
+    // Reused every refresh - one JNI call fills it
+    private final long[] dashboard = new long[DASH_SLOT_COUNT];
+
+    // Native date math caches UTC offsets; a zone change must drop them
+    private final BroadcastReceiver timeZoneReceiver = new BroadcastReceiver() {
+        @Override
+        public void onReceive(Context context, Intent intent) {
+            Log.d("Descansa", "Time zone changed");
+            onTimeZoneChanged();
+            updateUI();
+        }
+    };
+
     // UI Elements
     private TextView statusText;
     private TextView currentSessionText;
@@ -56,6 +89,7 @@ public class MainActivity extends AppCompatActivity {
 
         // Initialize C++ core FIRST
         initializeCore();
+        registerReceiver(timeZoneReceiver, new IntentFilter(Intent.ACTION_TIMEZONE_CHANGED));
 
         binding = ActivityMainBinding.inflate(getLayoutInflater());
         setContentView(binding.getRoot());
@@ -317,15 +351,33 @@ public class MainActivity extends AppCompatActivity {
     // ========== UI UPDATES ==========
     private void updateUI() {
         Log.d("Descansa", "=== updateUI() called ===");
+        if (!fillDashboardSnapshot(dashboard, 7)) {
+            return;
+        }
         updateStatusSection();
         updateInformationGrid();
         updateDebugInfo();
     }
 
+    private boolean dashboardFlag(long flag) {
+        return (dashboard[DASH_FLAGS] & flag) != 0;
+    }
+
+    // Same "Xh Ym" format the native side used to return
+    private static String formatDuration(long seconds) {
+        long hours = seconds / 3600;
+        long minutes = (seconds - hours * 3600) / 60;
+        return hours + "h " + minutes + "m";
+    }
+
+    private static String formatMinuteOfDay(long minuteOfDay) {
+        return String.format(java.util.Locale.US, "%02d:%02d", minuteOfDay / 60, minuteOfDay % 60);
+    }
+
     private void updateStatusSection() {
-        boolean sessionRunning = isSessionRunning();
-        boolean inSleepPeriod = isInSleepPeriod();
-        boolean beforeWake = isBeforeTargetWakeTime();
+        boolean sessionRunning = dashboardFlag(FLAG_SESSION_RUNNING);
+        boolean inSleepPeriod = dashboardFlag(FLAG_IN_SLEEP_PERIOD);
+        boolean beforeWake = dashboardFlag(FLAG_BEFORE_TARGET_WAKE);
 
         Log.d("Descansa", String.format("Status - Running: %b, InSleep: %b, BeforeWake: %b",
                 sessionRunning, inSleepPeriod, beforeWake));
@@ -343,7 +395,7 @@ public class MainActivity extends AppCompatActivity {
         statusText.setText("SLEEPING");
         sleepButton.setText("End Sleep");
 
-        String duration = getCurrentSessionDurationFormatted();
+        String duration = formatDuration(dashboard[DASH_CURRENT_SESSION_SECONDS]);
         currentSessionText.setText("Session: " + duration);
         currentSessionText.setVisibility(TextView.VISIBLE);
 
@@ -356,8 +408,8 @@ public class MainActivity extends AppCompatActivity {
 
         // RESTORED: Better dynamic labeling like before
         TextView workTimeLabel = findViewById(R.id.work_time_label);
-        String nextWakeTime = getNextWakeTimeFormatted();
-        String timeUntilWake = getTimeUntilWakeFormatted();
+        String nextWakeTime = formatMinuteOfDay(dashboard[DASH_NEXT_WAKE_MINUTE_OF_DAY]);
+        String timeUntilWake = formatDuration(dashboard[DASH_TIME_UNTIL_WAKE_SECONDS]);
 
         // Set the dynamic label
         String labelText = getString(R.string.label_time_until_wake_dynamic, nextWakeTime);
@@ -377,10 +429,10 @@ public class MainActivity extends AppCompatActivity {
         // RESTORED: Better work time display logic
         TextView workTimeLabel = findViewById(R.id.work_time_label);
 
-        boolean inSleepPeriod = isInSleepPeriod();
-        String workTime = getRemainingWorkTimeFormatted();
-        String nextWake = getNextWakeTimeFormatted();
-        String timeUntilWake = getTimeUntilNextWakeFormatted();
+        boolean inSleepPeriod = dashboardFlag(FLAG_IN_SLEEP_PERIOD);
+        String workTime = formatDuration(dashboard[DASH_REMAINING_WORK_SECONDS]);
+        String nextWake = formatMinuteOfDay(dashboard[DASH_NEXT_WAKE_MINUTE_OF_DAY]);
+        String timeUntilWake = formatDuration(dashboard[DASH_TIME_UNTIL_NEXT_WAKE_SECONDS]);
 
         if (inSleepPeriod) {
             // We're past bedtime - show time until wake
@@ -405,20 +457,20 @@ public class MainActivity extends AppCompatActivity {
 
     private void updateInformationGrid() {
         // Last sleep
-        String lastSleep = getLastSleepDurationFormatted();
+        String lastSleep = formatDuration(dashboard[DASH_LAST_SLEEP_SECONDS]);
         lastSleepText.setText(lastSleep.equals("0h 0m") ? "--" : lastSleep);
 
         // Average sleep
-        String avgSleep = getAverageSleepDurationFormatted(7);
+        String avgSleep = formatDuration(dashboard[DASH_AVERAGE_SLEEP_SECONDS]);
         averageSleepText.setText(avgSleep.equals("0h 0m") ? "--" : avgSleep);
 
         // Session count
-        sessionCountText.setText(String.valueOf(getSessionCount()));
+        sessionCountText.setText(String.valueOf(dashboard[DASH_SESSION_COUNT]));
     }
 
     private void updateDebugInfo() {
-        int sessionCount = getSessionCount();
-        if (isSessionRunning()) {
+        long sessionCount = dashboard[DASH_SESSION_COUNT];
+        if (dashboardFlag(FLAG_SESSION_RUNNING)) {
             debugText.setText("Session Active - " + sessionCount + " total");
         } else {
             debugText.setText("Ready - " + sessionCount + " sessions recorded");
@@ -594,6 +646,7 @@ public class MainActivity extends AppCompatActivity {
         Log.d("Descansa", "=== onDestroy() ===");
 
         stopPeriodicUpdates();
+        unregisterReceiver(timeZoneReceiver);
 
         // FINAL SAVE
         boolean saved = saveData();
@@ -628,9 +681,17 @@ public class MainActivity extends AppCompatActivity {
     public native String getTimeUntilNextWakeFormatted();
     public native String getNextWakeTimeFormatted();
 
+    public native boolean fillDashboardSnapshot(long[] out, int averageDays);
+
     public native boolean saveData();
     public native boolean exportAnalysisCsv(String exportPath);
     public native void clearHistory();
+    public native void onTimeZoneChanged();
+
+    // Native timing spans, dumped as Chrome trace JSON (open in Perfetto)
+    public native void setNativeTracingEnabled(boolean enabled);
+    public native boolean dumpNativeTrace(String outputPath);
+    public native void clearNativeTrace();
 
     static {
         System.loadLibrary("descansa");